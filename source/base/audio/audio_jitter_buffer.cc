@@ -0,0 +1,223 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/audio/audio_jitter_buffer.h"
+
+#include "base/logging.h"
+#include "base/audio/audio_output.h"
+#include "base/codec/audio_bus.h"
+#include "base/codec/audio_sample_types.h"
+#include "base/codec/multi_channel_resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+const size_t kChannels = AudioOutput::kChannels;
+const size_t kFramesPerMs = AudioOutput::kSampleRate / 1000;
+
+// The delay must be noticeably greater than the block requested by the resampler.
+const std::chrono::milliseconds kMinTargetDelay { 20 };
+
+// If more audio than |target_delay| * kMaxDelayFactor is buffered, the oldest samples are dropped.
+const size_t kMaxDelayFactor = 3;
+
+// The playback rate is changed at most by 0.5% in steps of 0.05%. Such changes are not audible.
+const double kMaxRateChange = 0.005;
+const double kRateStep = 0.0005;
+
+// Weight of the current amount of buffered audio in the moving average.
+const double kAverageFactor = 0.02;
+
+} // namespace
+
+AudioJitterBuffer::AudioJitterBuffer(const std::chrono::milliseconds& target_delay)
+    : target_frames_(static_cast<size_t>(std::max(target_delay, kMinTargetDelay).count()) *
+                     kFramesPerMs),
+      max_frames_(target_frames_ * kMaxDelayFactor),
+      capacity_(max_frames_ + target_frames_),
+      buffer_(std::make_unique<int16_t[]>(capacity_ * kChannels))
+{
+    LOG(LS_INFO) << "Ctor (target delay: " << target_frames_ / kFramesPerMs << "ms)";
+
+    resampler_ = std::make_unique<MultiChannelResampler>(
+        static_cast<int>(kChannels), rate_, SincResampler::kDefaultRequestSize,
+        std::bind(&AudioJitterBuffer::onMoreDataRequired,
+                  this, std::placeholders::_1, std::placeholders::_2));
+
+    // 10 ms is requested by AudioOutput.
+    output_bus_ = AudioBus::Create(
+        static_cast<int>(kChannels), static_cast<int>(kFramesPerMs * 10));
+}
+
+AudioJitterBuffer::~AudioJitterBuffer()
+{
+    LOG(LS_INFO) << "Dtor";
+}
+
+void AudioJitterBuffer::addSamples(const int16_t* samples, size_t frames)
+{
+    const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+
+    const size_t free_frames = capacity_ - static_cast<size_t>(write_pos - read_pos);
+    if (frames > free_frames)
+    {
+        // The consumer does not read samples. The newest samples are dropped.
+        ++overrun_count_;
+        frames = free_frames;
+    }
+
+    if (!frames)
+        return;
+
+    const size_t offset = static_cast<size_t>(write_pos % capacity_);
+    const size_t first_part = std::min(frames, capacity_ - offset);
+
+    memcpy(buffer_.get() + offset * kChannels, samples,
+           first_part * kChannels * sizeof(int16_t));
+
+    if (frames > first_part)
+    {
+        memcpy(buffer_.get(), samples + first_part * kChannels,
+               (frames - first_part) * kChannels * sizeof(int16_t));
+    }
+
+    write_pos_.store(write_pos + frames, std::memory_order_release);
+}
+
+void AudioJitterBuffer::readSamples(int16_t* samples, size_t frames)
+{
+    const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    size_t buffered_frames =
+        static_cast<size_t>(write_pos_.load(std::memory_order_acquire) - read_pos);
+
+    if (is_buffering_)
+    {
+        if (buffered_frames < target_frames_)
+        {
+            memset(samples, 0, frames * kChannels * sizeof(int16_t));
+            buffered_frames_.store(buffered_frames, std::memory_order_relaxed);
+            return;
+        }
+
+        is_buffering_ = false;
+        average_frames_ = static_cast<double>(buffered_frames);
+    }
+
+    if (buffered_frames > max_frames_)
+    {
+        // The delay has grown, for example, after a network hiccup. The oldest samples are dropped
+        // to return to the target delay.
+        read_pos_.store(read_pos + (buffered_frames - target_frames_), std::memory_order_release);
+        ++overrun_count_;
+
+        buffered_frames = target_frames_;
+        average_frames_ = static_cast<double>(buffered_frames);
+    }
+
+    updateRate(buffered_frames);
+
+    if (frames > static_cast<size_t>(output_bus_->frames()))
+    {
+        // AudioOutput always requests the same amount, so memory is allocated at most once.
+        output_bus_ = AudioBus::Create(static_cast<int>(kChannels), static_cast<int>(frames));
+    }
+
+    resampler_->Resample(static_cast<int>(frames), output_bus_.get());
+    output_bus_->ToInterleaved<SignedInt16SampleTypeTraits>(static_cast<int>(frames), samples);
+
+    buffered_frames = static_cast<size_t>(write_pos_.load(std::memory_order_acquire) -
+                                          read_pos_.load(std::memory_order_relaxed));
+    buffered_frames_.store(buffered_frames + static_cast<size_t>(resampler_->BufferedFrames()),
+                           std::memory_order_relaxed);
+}
+
+AudioJitterBuffer::Statistics AudioJitterBuffer::statistics() const
+{
+    Statistics statistics;
+    statistics.underrun_count = underrun_count_.load(std::memory_order_relaxed);
+    statistics.overrun_count = overrun_count_.load(std::memory_order_relaxed);
+    statistics.delay = std::chrono::milliseconds(
+        buffered_frames_.load(std::memory_order_relaxed) / kFramesPerMs);
+    return statistics;
+}
+
+void AudioJitterBuffer::onMoreDataRequired(int /* frame_delay */, AudioBus* audio_bus)
+{
+    const size_t frames = static_cast<size_t>(audio_bus->frames());
+    const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t buffered_frames =
+        static_cast<size_t>(write_pos_.load(std::memory_order_acquire) - read_pos);
+
+    // After an underrun, nothing is read until the buffer is filled again.
+    const size_t count = is_buffering_ ? 0 : std::min(frames, buffered_frames);
+
+    if (count)
+    {
+        const size_t offset = static_cast<size_t>(read_pos % capacity_);
+        const size_t first_part = std::min(count, capacity_ - offset);
+
+        audio_bus->FromInterleavedPartial<SignedInt16SampleTypeTraits>(
+            buffer_.get() + offset * kChannels, 0, static_cast<int>(first_part));
+
+        if (count > first_part)
+        {
+            audio_bus->FromInterleavedPartial<SignedInt16SampleTypeTraits>(
+                buffer_.get(), static_cast<int>(first_part), static_cast<int>(count - first_part));
+        }
+
+        read_pos_.store(read_pos + count, std::memory_order_release);
+    }
+
+    if (count < frames)
+    {
+        audio_bus->ZeroFramesPartial(static_cast<int>(count), static_cast<int>(frames - count));
+
+        if (!is_buffering_)
+        {
+            ++underrun_count_;
+            is_buffering_ = true;
+        }
+    }
+}
+
+void AudioJitterBuffer::updateRate(size_t buffered_frames)
+{
+    average_frames_ += (static_cast<double>(buffered_frames) - average_frames_) * kAverageFactor;
+
+    // If the sender's clock is faster than the audio device's clock, audio accumulates in the
+    // buffer and it is played a little faster. And vice versa.
+    const double target_frames = static_cast<double>(target_frames_);
+    const double deviation = (average_frames_ - target_frames) / target_frames;
+
+    double rate = 1.0 + std::clamp(deviation * kMaxRateChange, -kMaxRateChange, kMaxRateChange);
+    rate = std::round(rate / kRateStep) * kRateStep;
+
+    if (rate != rate_)
+    {
+        rate_ = rate;
+        resampler_->SetRatio(rate_);
+    }
+}
+
+} // namespace base
@@ -0,0 +1,99 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_AUDIO_AUDIO_JITTER_BUFFER_H
+#define BASE_AUDIO_AUDIO_JITTER_BUFFER_H
+
+#include "base/macros_magic.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace base {
+
+class AudioBus;
+class MultiChannelResampler;
+
+// Buffers interleaved 16-bit samples with the format of AudioOutput between the thread that
+// receives audio packets and the audio output thread.
+// The buffer is a single-producer single-consumer ring: addSamples() is called from one thread
+// and readSamples() from another, no locks are taken and readSamples() does not allocate memory.
+// Playback starts when |target_delay| of audio is buffered. The difference between the clocks of
+// the sender and the audio device is compensated by small changes of the playback rate, so the
+// amount of buffered audio stays close to |target_delay|.
+class AudioJitterBuffer
+{
+public:
+    explicit AudioJitterBuffer(const std::chrono::milliseconds& target_delay);
+    ~AudioJitterBuffer();
+
+    struct Statistics
+    {
+        // Number of times the buffer ran out of samples during playback.
+        int64_t underrun_count = 0;
+
+        // Number of times samples were dropped because too much audio was buffered.
+        int64_t overrun_count = 0;
+
+        // Current delay of buffered audio.
+        std::chrono::milliseconds delay { 0 };
+    };
+
+    // Adds |frames| frames of interleaved samples. Called from the producer thread.
+    void addSamples(const int16_t* samples, size_t frames);
+
+    // Fills |samples| with |frames| frames of interleaved samples. If there is not enough buffered
+    // audio, silence is returned. Called from the consumer thread.
+    void readSamples(int16_t* samples, size_t frames);
+
+    // May be called from any thread.
+    Statistics statistics() const;
+
+private:
+    void onMoreDataRequired(int frame_delay, AudioBus* audio_bus);
+    void updateRate(size_t buffered_frames);
+
+    const size_t target_frames_;
+    const size_t max_frames_;
+    const size_t capacity_;
+
+    std::unique_ptr<int16_t[]> buffer_;
+
+    // Positions are counted in frames from the beginning and never wrap.
+    std::atomic<uint64_t> write_pos_ { 0 };
+    std::atomic<uint64_t> read_pos_ { 0 };
+
+    // Used only by the consumer.
+    std::unique_ptr<MultiChannelResampler> resampler_;
+    std::unique_ptr<AudioBus> output_bus_;
+    bool is_buffering_ = true;
+    double average_frames_ = 0;
+    double rate_ = 1.0;
+
+    std::atomic<int64_t> underrun_count_ { 0 };
+    std::atomic<int64_t> overrun_count_ { 0 };
+    std::atomic<size_t> buffered_frames_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(AudioJitterBuffer);
+};
+
+} // namespace base
+
+#endif // BASE_AUDIO_AUDIO_JITTER_BUFFER_H
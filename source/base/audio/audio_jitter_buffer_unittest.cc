@@ -0,0 +1,136 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/audio/audio_jitter_buffer.h"
+
+#include "base/audio/audio_output.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const size_t kFramesPerMs = AudioOutput::kSampleRate / 1000;
+const size_t kFramesPer10ms = kFramesPerMs * 10;
+const std::chrono::milliseconds kTargetDelay { 40 };
+
+std::vector<int16_t> makeSamples(size_t frames, int16_t value)
+{
+    return std::vector<int16_t>(frames * AudioOutput::kChannels, value);
+}
+
+void addMs(AudioJitterBuffer* buffer, int ms)
+{
+    std::vector<int16_t> samples = makeSamples(kFramesPer10ms, 1000);
+
+    for (int i = 0; i < ms / 10; ++i)
+        buffer->addSamples(samples.data(), kFramesPer10ms);
+}
+
+bool readMs(AudioJitterBuffer* buffer, int ms)
+{
+    std::vector<int16_t> samples = makeSamples(kFramesPer10ms, 0);
+    bool has_sound = false;
+
+    for (int i = 0; i < ms / 10; ++i)
+    {
+        buffer->readSamples(samples.data(), kFramesPer10ms);
+
+        for (int16_t sample : samples)
+        {
+            if (sample != 0)
+                has_sound = true;
+        }
+    }
+
+    return has_sound;
+}
+
+} // namespace
+
+TEST(AudioJitterBufferTest, WaitsForTargetDelay)
+{
+    AudioJitterBuffer buffer(kTargetDelay);
+
+    addMs(&buffer, 30);
+    EXPECT_FALSE(readMs(&buffer, 10));
+    EXPECT_EQ(buffer.statistics().delay, std::chrono::milliseconds(30));
+
+    addMs(&buffer, 10);
+    EXPECT_TRUE(readMs(&buffer, 10));
+
+    AudioJitterBuffer::Statistics statistics = buffer.statistics();
+    EXPECT_EQ(statistics.underrun_count, 0);
+    EXPECT_EQ(statistics.overrun_count, 0);
+}
+
+TEST(AudioJitterBufferTest, Underrun)
+{
+    AudioJitterBuffer buffer(kTargetDelay);
+
+    addMs(&buffer, 40);
+    EXPECT_TRUE(readMs(&buffer, 100));
+    EXPECT_EQ(buffer.statistics().underrun_count, 1);
+
+    // After an underrun the playback waits for the target delay again.
+    addMs(&buffer, 20);
+    EXPECT_FALSE(readMs(&buffer, 10));
+    EXPECT_EQ(buffer.statistics().underrun_count, 1);
+}
+
+TEST(AudioJitterBufferTest, Overrun)
+{
+    AudioJitterBuffer buffer(kTargetDelay);
+
+    addMs(&buffer, 40);
+    EXPECT_TRUE(readMs(&buffer, 10));
+
+    // The network delivers a burst of audio after a hiccup.
+    addMs(&buffer, 150);
+    EXPECT_TRUE(readMs(&buffer, 10));
+
+    AudioJitterBuffer::Statistics statistics = buffer.statistics();
+    EXPECT_GE(statistics.overrun_count, 1);
+    EXPECT_LE(statistics.delay, kTargetDelay + std::chrono::milliseconds(20));
+}
+
+TEST(AudioJitterBufferTest, DelayStaysNearTarget)
+{
+    AudioJitterBuffer buffer(kTargetDelay);
+
+    // The sender is 0.2% faster than the audio device: 481 frames are received while 480 are
+    // played. Without correction, the delay grows by 125 ms in a minute.
+    std::vector<int16_t> samples = makeSamples(kFramesPer10ms + 1, 1000);
+    std::vector<int16_t> output = makeSamples(kFramesPer10ms, 0);
+
+    for (int i = 0; i < 6000; ++i)
+    {
+        buffer.addSamples(samples.data(), kFramesPer10ms + 1);
+        buffer.readSamples(output.data(), kFramesPer10ms);
+    }
+
+    AudioJitterBuffer::Statistics statistics = buffer.statistics();
+    EXPECT_EQ(statistics.underrun_count, 0);
+    EXPECT_EQ(statistics.overrun_count, 0);
+    EXPECT_LE(statistics.delay, kTargetDelay * 2);
+}
+
+} // namespace base
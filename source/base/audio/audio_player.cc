@@ -24,7 +24,11 @@
 
 namespace base {
 
-AudioPlayer::AudioPlayer()
+// static
+const std::chrono::milliseconds AudioPlayer::kDefaultTargetDelay { 60 };
+
+AudioPlayer::AudioPlayer(const std::chrono::milliseconds& target_delay)
+    : jitter_buffer_(target_delay)
 {
     LOG(LS_INFO) << "Ctor";
 }
@@ -35,9 +39,9 @@ AudioPlayer::~AudioPlayer()
 }
 
 // static
-std::unique_ptr<AudioPlayer> AudioPlayer::create()
+std::unique_ptr<AudioPlayer> AudioPlayer::create(const std::chrono::milliseconds& target_delay)
 {
-    std::unique_ptr<AudioPlayer> player(new AudioPlayer());
+    std::unique_ptr<AudioPlayer> player(new AudioPlayer(target_delay));
     if (!player->init())
     {
         LOG(LS_WARNING) << "Unable to initialize audio player";
@@ -49,54 +53,32 @@ std::unique_ptr<AudioPlayer> AudioPlayer::create()
 
 void AudioPlayer::addPacket(std::unique_ptr<proto::AudioPacket> packet)
 {
-    std::scoped_lock lock(incoming_queue_lock_);
-    incoming_queue_.emplace(std::move(packet));
-}
-
-size_t AudioPlayer::onMoreDataRequired(void* data, size_t size)
-{
-    if (work_queue_.empty())
+    if (packet->data_size() != 1 ||
+        packet->channels() != static_cast<int>(AudioOutput::kChannels) ||
+        packet->sampling_rate() != static_cast<int>(AudioOutput::kSampleRate))
     {
-        {
-            std::scoped_lock lock(incoming_queue_lock_);
-            work_queue_.swap(incoming_queue_);
-        }
-
-        if (work_queue_.empty())
-            return 0;
+        LOG(LS_WARNING) << "Unsupported audio packet";
+        return;
     }
 
-    size_t target_pos = 0;
+    const std::string& packet_data = packet->data(0);
+    const size_t frames = packet_data.size() / (AudioOutput::kChannels * sizeof(int16_t));
 
-    while (!work_queue_.empty())
-    {
-        const std::string& packet_data = work_queue_.front()->data(0);
-
-        size_t source_size = packet_data.size() - source_pos_;
-        size_t target_size = size - target_pos;
-        size_t num_bytes = std::min(target_size, source_size);
-
-        memcpy(reinterpret_cast<uint8_t*>(data) + target_pos,
-               packet_data.data() + source_pos_,
-               num_bytes);
-        target_pos += num_bytes;
-
-        if (target_size < source_size)
-        {
-            source_pos_ += num_bytes;
-            break;
-        }
-        else
-        {
-            work_queue_.pop();
-            source_pos_ = 0;
-
-            if (target_size == source_size)
-                break;
-        }
-    }
+    jitter_buffer_.addSamples(reinterpret_cast<const int16_t*>(packet_data.data()), frames);
+}
+
+AudioJitterBuffer::Statistics AudioPlayer::statistics() const
+{
+    return jitter_buffer_.statistics();
+}
+
+size_t AudioPlayer::onMoreDataRequired(void* data, size_t size)
+{
+    const size_t frames = size / (AudioOutput::kChannels * sizeof(int16_t));
 
-    return target_pos;
+    // The jitter buffer returns silence if there is not enough data.
+    jitter_buffer_.readSamples(reinterpret_cast<int16_t*>(data), frames);
+    return size;
 }
 
 bool AudioPlayer::init()
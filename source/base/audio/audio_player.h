@@ -20,10 +20,10 @@
 #define BASE_AUDIO_AUDIO_PLAYER_H
 
 #include "base/macros_magic.h"
+#include "base/audio/audio_jitter_buffer.h"
 
+#include <chrono>
 #include <memory>
-#include <mutex>
-#include <queue>
 
 namespace proto {
 class AudioPacket;
@@ -38,22 +38,26 @@ class AudioPlayer
 public:
     ~AudioPlayer();
 
-    static std::unique_ptr<AudioPlayer> create();
+    static const std::chrono::milliseconds kDefaultTargetDelay;
+
+    // |target_delay| is the amount of audio buffered before playback. A greater delay allows
+    // to play without interruptions on networks with greater jitter.
+    static std::unique_ptr<AudioPlayer> create(
+        const std::chrono::milliseconds& target_delay = kDefaultTargetDelay);
+
     void addPacket(std::unique_ptr<proto::AudioPacket> packet);
 
+    AudioJitterBuffer::Statistics statistics() const;
+
 private:
-    AudioPlayer();
+    explicit AudioPlayer(const std::chrono::milliseconds& target_delay);
     bool init();
     size_t onMoreDataRequired(void* data, size_t size);
 
+    // Must be destroyed after |output_|, which reads from it on the audio thread.
+    AudioJitterBuffer jitter_buffer_;
     std::unique_ptr<AudioOutput> output_;
 
-    std::queue<std::unique_ptr<proto::AudioPacket>> incoming_queue_;
-    std::mutex incoming_queue_lock_;
-
-    std::queue<std::unique_ptr<proto::AudioPacket>> work_queue_;
-    size_t source_pos_ = 0;
-
     DISALLOW_COPY_AND_ASSIGN(AudioPlayer);
 };
 
@@ -18,8 +18,10 @@
 
 #include "base/codec/video_decoder.h"
 
+#include "base/logging.h"
 #include "base/codec/video_decoder_vpx.h"
 #include "base/codec/video_decoder_zstd.h"
+#include "base/desktop/frame.h"
 
 namespace base {
 
@@ -42,4 +44,32 @@ std::unique_ptr<VideoDecoder> VideoDecoder::create(proto::VideoEncoding encoding
     }
 }
 
+// static
+bool VideoDecoder::applyCopyRects(const proto::VideoPacket& packet, Frame* frame)
+{
+    const Rect frame_rect = Rect::makeSize(frame->size());
+
+    for (int i = 0; i < packet.copy_rect_size(); ++i)
+    {
+        const proto::VideoCopyRect& copy_rect = packet.copy_rect(i);
+
+        Rect source_rect = Rect::makeXYWH(copy_rect.source_rect().x(),
+                                          copy_rect.source_rect().y(),
+                                          copy_rect.source_rect().width(),
+                                          copy_rect.source_rect().height());
+        Point target_pos(copy_rect.target_x(), copy_rect.target_y());
+
+        if (!frame_rect.containsRect(source_rect) ||
+            !frame_rect.containsRect(Rect::makeXYWH(target_pos, source_rect.size())))
+        {
+            LOG(LS_WARNING) << "The copy rectangle is outside the screen area";
+            return false;
+        }
+
+        frame->movePixels(source_rect, target_pos);
+    }
+
+    return true;
+}
+
 } // namespace base
@@ -35,6 +35,11 @@ public:
     static std::unique_ptr<VideoDecoder> create(proto::VideoEncoding encoding);
 
     virtual bool decode(const proto::VideoPacket& packet, Frame* frame) = 0;
+
+protected:
+    // Moves the areas listed in |packet.copy_rect| within |frame|. Must be called before the dirty
+    // rectangles of the packet are decoded. Returns false if an area is outside the frame.
+    static bool applyCopyRects(const proto::VideoPacket& packet, Frame* frame);
 };
 
 } // namespace base
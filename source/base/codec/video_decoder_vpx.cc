@@ -159,6 +159,9 @@ bool VideoDecoderVPX::decode(const proto::VideoPacket& packet, Frame* frame)
         return false;
     }
 
+    if (!applyCopyRects(packet, frame))
+        return false;
+
     return convertImage(packet, image, frame);
 }
 
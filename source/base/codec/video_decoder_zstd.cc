@@ -43,6 +43,12 @@ Rect parseRect(const proto::Rect& rect)
     return Rect::makeXYWH(rect.x(), rect.y(), rect.width(), rect.height());
 }
 
+Rect tileRect(const proto::VideoCachedTile& tile)
+{
+    return Rect::makeXYWH(
+        tile.x(), tile.y(), VideoTileCache::kTileSize, VideoTileCache::kTileSize);
+}
+
 } // namespace
 
 VideoDecoderZstd::VideoDecoderZstd()
@@ -83,6 +89,23 @@ bool VideoDecoderZstd::decode(const proto::VideoPacket& packet, Frame* target_fr
         return false;
     }
 
+    if (packet.tile_cache_size())
+    {
+        if (packet.tile_cache_size() > VideoTileCache::kMaxCapacity)
+        {
+            LOG(LS_WARNING) << "Invalid tile cache size: " << packet.tile_cache_size();
+            return false;
+        }
+
+        tile_cache_ = std::make_unique<VideoTileCache>(packet.tile_cache_size(), true);
+    }
+
+    if (!applyCopyRects(packet, target_frame))
+        return false;
+
+    if (!applyCachedTiles(packet, target_frame))
+        return false;
+
     size_t ret = ZSTD_initDStream(stream_.get());
     if (ZSTD_isError(ret))
     {
@@ -137,6 +160,70 @@ bool VideoDecoderZstd::decode(const proto::VideoPacket& packet, Frame* target_fr
                                rect.height());
     }
 
+    return addNewTiles(packet, *target_frame);
+}
+
+bool VideoDecoderZstd::applyCachedTiles(const proto::VideoPacket& packet, Frame* target_frame)
+{
+    if (!packet.cached_tile_size())
+        return true;
+
+    if (!tile_cache_)
+    {
+        LOG(LS_WARNING) << "Cached tiles received without tile cache";
+        return false;
+    }
+
+    const Rect frame_rect = Rect::makeSize(target_frame->size());
+
+    for (int i = 0; i < packet.cached_tile_size(); ++i)
+    {
+        const proto::VideoCachedTile& tile = packet.cached_tile(i);
+        const Rect rect = tileRect(tile);
+
+        if (!frame_rect.containsRect(rect))
+        {
+            LOG(LS_WARNING) << "The cached tile is outside the screen area";
+            return false;
+        }
+
+        if (!tile_cache_->copyTile(tile.hash(), target_frame, rect.topLeft()))
+        {
+            LOG(LS_WARNING) << "Tile " << tile.hash() << " is not in the cache";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VideoDecoderZstd::addNewTiles(const proto::VideoPacket& packet, const Frame& target_frame)
+{
+    if (!packet.new_tile_size())
+        return true;
+
+    if (!tile_cache_)
+    {
+        LOG(LS_WARNING) << "New tiles received without tile cache";
+        return false;
+    }
+
+    const Rect frame_rect = Rect::makeSize(target_frame.size());
+
+    for (int i = 0; i < packet.new_tile_size(); ++i)
+    {
+        const proto::VideoCachedTile& tile = packet.new_tile(i);
+        const Rect rect = tileRect(tile);
+
+        if (!frame_rect.containsRect(rect))
+        {
+            LOG(LS_WARNING) << "The new tile is outside the screen area";
+            return false;
+        }
+
+        tile_cache_->addTile(tile.hash(), target_frame, rect.topLeft());
+    }
+
     return true;
 }
 
@@ -22,6 +22,7 @@
 #include "base/macros_magic.h"
 #include "base/codec/scoped_zstd_stream.h"
 #include "base/codec/video_decoder.h"
+#include "base/codec/video_tile_cache.h"
 
 namespace base {
 
@@ -39,9 +40,13 @@ public:
 private:
     VideoDecoderZstd();
 
+    bool applyCachedTiles(const proto::VideoPacket& packet, Frame* target_frame);
+    bool addNewTiles(const proto::VideoPacket& packet, const Frame& target_frame);
+
     ScopedZstdDStream stream_;
     std::unique_ptr<PixelTranslator> translator_;
     std::unique_ptr<Frame> source_frame_;
+    std::unique_ptr<VideoTileCache> tile_cache_;
 
     DISALLOW_COPY_AND_ASSIGN(VideoDecoderZstd);
 };
@@ -34,6 +34,10 @@ public:
 
     virtual bool encode(const Frame* frame, proto::VideoPacket* packet) = 0;
 
+    // Sets the bitrate (in kilobits per second) which the encoder should not exceed. Encoders
+    // without rate control ignore it.
+    virtual void setTargetBitrate(uint32_t /* kbps */) {}
+
     void setKeyFrameRequired(bool enable) { key_frame_required_ = enable; }
     bool isKeyFrameRequired() const { return key_frame_required_; }
 
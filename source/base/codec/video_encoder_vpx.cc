@@ -24,6 +24,7 @@
 #include <libyuv/convert.h>
 #include <libyuv/cpu_id.h>
 
+#include <algorithm>
 #include <thread>
 
 namespace base {
@@ -32,6 +33,14 @@ namespace {
 
 const std::chrono::milliseconds kTargetFrameInterval{ 80 };
 
+// Limits of the frame duration passed to the encoder. The rate control spreads the target bitrate
+// over the durations, so they have to follow the real frame rate.
+const std::chrono::milliseconds kMinFrameInterval{ 10 };
+const std::chrono::milliseconds kMaxFrameInterval{ 200 };
+
+// Target bitrate (in kbps) until the bandwidth estimate is received.
+const uint32_t kDefaultTargetBitrate = 1000;
+
 // Defines the dimension of a macro block. This is used to compute the active map for the encoder.
 const int kMacroBlockSize = 16;
 
@@ -155,7 +164,8 @@ std::unique_ptr<VideoEncoderVPX> VideoEncoderVPX::createVP9()
 }
 
 VideoEncoderVPX::VideoEncoderVPX(proto::VideoEncoding encoding)
-    : VideoEncoder(encoding)
+    : VideoEncoder(encoding),
+      target_bitrate_(kDefaultTargetBitrate)
 {
     memset(&config_, 0, sizeof(config_));
     memset(&active_map_, 0, sizeof(active_map_));
@@ -208,13 +218,25 @@ bool VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
         return false;
     }
 
-    // Do the actual encoding.
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::microseconds duration = kTargetFrameInterval;
+
+    if (!is_key_frame && last_frame_time_ != std::chrono::steady_clock::time_point())
+    {
+        duration = std::clamp(std::chrono::duration_cast<std::chrono::microseconds>(
+            now - last_frame_time_), std::chrono::microseconds(kMinFrameInterval),
+            std::chrono::microseconds(kMaxFrameInterval));
+    }
+
+    last_frame_time_ = now;
+
+    // Do the actual encoding. If a key frame is required, then the encoder must not refer to the
+    // previous frames (the receiver may not have them).
     ret = vpx_codec_encode(codec_.get(),
                            image_.get(),
                            0, // pts
-                           static_cast<unsigned long>(
-                               std::chrono::microseconds(kTargetFrameInterval).count()),
-                           0, // flags
+                           static_cast<unsigned long>(duration.count()),
+                           is_key_frame ? VPX_EFLAG_FORCE_KF : 0, // flags
                            VPX_DL_REALTIME);
     if (ret != VPX_CODEC_OK)
     {
@@ -242,6 +264,24 @@ bool VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
     return true;
 }
 
+void VideoEncoderVPX::setTargetBitrate(uint32_t kbps)
+{
+    if (target_bitrate_ == kbps)
+        return;
+
+    target_bitrate_ = kbps;
+
+    // The codec is not created yet. The bitrate will be applied on creation.
+    if (!codec_)
+        return;
+
+    config_.rc_target_bitrate = kbps;
+
+    vpx_codec_err_t ret = vpx_codec_enc_config_set(codec_.get(), &config_);
+    if (ret != VPX_CODEC_OK)
+        LOG(LS_WARNING) << "vpx_codec_enc_config_set failed: " << ret;
+}
+
 bool VideoEncoderVPX::setMinQuantizer(uint32_t min_quantizer)
 {
     if (min_quantizer < 10 || min_quantizer > 50)
@@ -336,9 +376,7 @@ bool VideoEncoderVPX::createVp8Codec(const Size& size)
     config_.rc_min_quantizer = 10;
     config_.rc_max_quantizer = 30;
 
-    // In the absence of a good bandwidth estimator set the target bitrate to a
-    // conservative default.
-    config_.rc_target_bitrate = 1000;
+    config_.rc_target_bitrate = target_bitrate_;
 
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     if (ret != VPX_CODEC_OK)
@@ -395,9 +433,7 @@ bool VideoEncoderVPX::createVp9Codec(const Size& size)
     config_.rc_min_quantizer = 10;
     config_.rc_max_quantizer = 30;
 
-    // In the absence of a good bandwidth estimator set the target bitrate to a
-    // conservative default.
-    config_.rc_target_bitrate = 1000;
+    config_.rc_target_bitrate = target_bitrate_;
 
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     if (ret != VPX_CODEC_OK)
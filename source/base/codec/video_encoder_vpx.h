@@ -40,6 +40,8 @@ public:
     static std::unique_ptr<VideoEncoderVPX> createVP9();
 
     bool encode(const Frame* frame, proto::VideoPacket* packet) override;
+    void setTargetBitrate(uint32_t kbps) override;
+    uint32_t targetBitrate() const { return target_bitrate_; }
 
     bool setMinQuantizer(uint32_t min_quantizer);
     uint32_t minQuantizer() const;
@@ -59,6 +61,9 @@ private:
     vpx_codec_enc_cfg_t config_;
     ScopedVpxCodec codec_;
 
+    uint32_t target_bitrate_;
+    std::chrono::steady_clock::time_point last_frame_time_;
+
     ByteArray active_map_buffer_;
     vpx_active_map_t active_map_;
 
@@ -20,7 +20,7 @@
 
 #include "base/logging.h"
 #include "base/codec/pixel_translator.h"
-#include "base/desktop/frame.h"
+#include "base/desktop/frame_simple.h"
 
 namespace base {
 
@@ -139,9 +139,15 @@ bool VideoEncoderZstd::encode(const Frame* frame, proto::VideoPacket* packet)
         else
         {
             updated_region_ = frame->constUpdatedRegion();
+
+            if (copy_rect_enabled_)
+                detectMove(frame, packet);
         }
     }
 
+    if (tile_cache_size_)
+        useTileCache(frame, packet->has_format() || isKeyFrameRequired(), packet);
+
     if (!translator_)
     {
         LOG(LS_INFO) << "Pixel translator not created yet";
@@ -196,6 +202,14 @@ bool VideoEncoderZstd::encode(const Frame* frame, proto::VideoPacket* packet)
         return false;
     }
 
+    if (copy_rect_enabled_)
+    {
+        if (packet->has_format() || isKeyFrameRequired())
+            updateLastFrame(frame, Region(Rect::makeSize(frame->size())));
+        else
+            updateLastFrame(frame, frame->constUpdatedRegion());
+    }
+
     setKeyFrameRequired(false);
 
     return true;
@@ -218,4 +232,124 @@ int VideoEncoderZstd::compressRatio() const
     return compress_ratio_;
 }
 
+void VideoEncoderZstd::setCopyRectEnabled(bool enable)
+{
+    LOG(LS_INFO) << "Copy rectangles enabled: " << enable;
+
+    copy_rect_enabled_ = enable;
+    last_frame_.reset();
+}
+
+void VideoEncoderZstd::setTileCacheSize(size_t tile_cache_size)
+{
+    LOG(LS_INFO) << "Tile cache size: " << tile_cache_size;
+
+    tile_cache_size_ = std::min(tile_cache_size, VideoTileCache::kMaxCapacity);
+    tile_cache_.reset();
+}
+
+void VideoEncoderZstd::detectMove(const Frame* frame, proto::VideoPacket* packet)
+{
+    if (!last_frame_ || last_frame_->size() != frame->size())
+        return;
+
+    MoveDetector::Move move;
+    if (!move_detector_.detect(*last_frame_, *frame, updated_region_, &move))
+        return;
+
+    proto::VideoCopyRect* copy_rect = packet->add_copy_rect();
+    serializeRect(move.source_rect, copy_rect->mutable_source_rect());
+    copy_rect->set_target_x(move.target_pos.x());
+    copy_rect->set_target_y(move.target_pos.y());
+
+    // The moved area is restored by the decoder from the previous image.
+    updated_region_.subtract(Rect::makeXYWH(move.target_pos, move.source_rect.size()));
+}
+
+void VideoEncoderZstd::updateLastFrame(const Frame* frame, const Region& updated_region)
+{
+    if (!last_frame_ || last_frame_->size() != frame->size())
+    {
+        last_frame_ = FrameSimple::create(frame->size(), frame->format());
+        if (!last_frame_)
+        {
+            LOG(LS_ERROR) << "Unable to create frame";
+            return;
+        }
+
+        last_frame_->copyPixelsFrom(*frame, Point(0, 0), Rect::makeSize(frame->size()));
+        return;
+    }
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+        last_frame_->copyPixelsFrom(*frame, rect.topLeft(), rect);
+    }
+}
+
+void VideoEncoderZstd::useTileCache(
+    const Frame* frame, bool full_update, proto::VideoPacket* packet)
+{
+    static const int kTileSize = VideoTileCache::kTileSize;
+
+    // The decoder starts with an empty cache after a key frame.
+    if (full_update || !tile_cache_)
+    {
+        tile_cache_ = std::make_unique<VideoTileCache>(tile_cache_size_, false);
+        packet->set_tile_cache_size(static_cast<uint32_t>(tile_cache_->capacity()));
+    }
+
+    Rect bounds;
+    for (Region::Iterator it(updated_region_); !it.isAtEnd(); it.advance())
+        bounds.unionWith(it.rect());
+
+    const int first_x = (bounds.left() / kTileSize) * kTileSize;
+    const int first_y = (bounds.top() / kTileSize) * kTileSize;
+
+    Region cached_region;
+
+    for (int y = first_y; y < bounds.bottom() && y + kTileSize <= frame->size().height();
+         y += kTileSize)
+    {
+        for (int x = first_x; x < bounds.right() && x + kTileSize <= frame->size().width();
+             x += kTileSize)
+        {
+            const Rect tile_rect = Rect::makeXYWH(x, y, kTileSize, kTileSize);
+
+            // Only the tiles which are completely updated can be used.
+            Region tile_region(tile_rect);
+            tile_region.intersectWith(updated_region_);
+            if (!tile_region.equals(Region(tile_rect)))
+                continue;
+
+            const uint64_t hash = VideoTileCache::tileHash(*frame, tile_rect.topLeft());
+            proto::VideoCachedTile* tile;
+
+            if (!full_update && tile_cache_->touch(hash))
+            {
+                tile = packet->add_cached_tile();
+                cached_region.addRect(tile_rect);
+            }
+            else
+            {
+                tile = packet->add_new_tile();
+            }
+
+            tile->set_x(x);
+            tile->set_y(y);
+            tile->set_hash(hash);
+        }
+    }
+
+    updated_region_.subtract(cached_region);
+
+    // The decoder adds the new tiles after all the cached tiles are taken.
+    for (int i = 0; i < packet->new_tile_size(); ++i)
+    {
+        const proto::VideoCachedTile& tile = packet->new_tile(i);
+        tile_cache_->addTile(tile.hash(), *frame, Point(tile.x(), tile.y()));
+    }
+}
+
 } // namespace base
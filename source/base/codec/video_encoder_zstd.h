@@ -23,11 +23,14 @@
 #include "base/memory/aligned_memory.h"
 #include "base/codec/scoped_zstd_stream.h"
 #include "base/codec/video_encoder.h"
+#include "base/codec/video_tile_cache.h"
+#include "base/desktop/move_detector.h"
 #include "base/desktop/region.h"
 #include "base/desktop/pixel_format.h"
 
 namespace base {
 
+class Frame;
 class PixelTranslator;
 
 class VideoEncoderZstd : public VideoEncoder
@@ -43,11 +46,23 @@ public:
     bool setCompressRatio(int compression_ratio);
     int compressRatio() const;
 
+    // If enabled, areas of the screen that have moved since the previous frame (for example, when
+    // a document is scrolled) are sent as copy rectangles instead of being encoded again. The
+    // decoder must support VideoPacket.copy_rect.
+    void setCopyRectEnabled(bool enable);
+
+    // Sets the number of 64x64 tiles that the decoder keeps in the tile cache. Tiles which are
+    // already in the cache are sent as references instead of pixels. Zero disables the cache.
+    void setTileCacheSize(size_t tile_cache_size);
+
 private:
     VideoEncoderZstd(const PixelFormat& target_format, int compression_ratio);
     bool compressPacket(proto::VideoPacket* packet,
                         const uint8_t* input_data,
                         size_t input_size);
+    void detectMove(const Frame* frame, proto::VideoPacket* packet);
+    void updateLastFrame(const Frame* frame, const Region& updated_region);
+    void useTileCache(const Frame* frame, bool full_update, proto::VideoPacket* packet);
 
     Region updated_region_;
     PixelFormat target_format_;
@@ -57,6 +72,14 @@ private:
     std::unique_ptr<uint8_t[], base::AlignedFreeDeleter> translate_buffer_;
     size_t translate_buffer_size_ = 0;
 
+    // Used only when copy rectangles are enabled. Contains the last encoded frame.
+    bool copy_rect_enabled_ = false;
+    MoveDetector move_detector_;
+    std::unique_ptr<Frame> last_frame_;
+
+    size_t tile_cache_size_ = 0;
+    std::unique_ptr<VideoTileCache> tile_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(VideoEncoderZstd);
 };
 
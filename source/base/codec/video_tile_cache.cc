@@ -0,0 +1,149 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_tile_cache.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+const int kBytesPerPixel = 4;
+const int kTileRowSize = VideoTileCache::kTileSize * kBytesPerPixel;
+
+} // namespace
+
+VideoTileCache::VideoTileCache(size_t capacity, bool store_pixels)
+    : capacity_(std::min(capacity, kMaxCapacity)),
+      store_pixels_(store_pixels)
+{
+    LOG(LS_INFO) << "Ctor (capacity: " << capacity_ << ", store pixels: " << store_pixels_ << ")";
+    index_.reserve(capacity_);
+}
+
+VideoTileCache::~VideoTileCache()
+{
+    LOG(LS_INFO) << "Dtor";
+}
+
+// static
+uint64_t VideoTileCache::tileHash(const Frame& frame, const Point& pos)
+{
+    DCHECK_EQ(frame.format().bytesPerPixel(), kBytesPerPixel);
+    DCHECK(Rect::makeSize(frame.size()).containsRect(
+        Rect::makeXYWH(pos.x(), pos.y(), kTileSize, kTileSize)));
+
+    static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+    auto round = [](uint64_t acc, uint64_t value)
+    {
+        acc += value * kPrime2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * kPrime1;
+    };
+
+    // Four independent lanes, 32 bytes per step. A row of the tile is 256 bytes.
+    uint64_t acc[4] = { kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1 };
+    const uint8_t* row = frame.frameDataAtPos(pos);
+
+    for (int y = 0; y < kTileSize; ++y)
+    {
+        for (int x = 0; x < kTileRowSize; x += 32)
+        {
+            uint64_t values[4];
+            memcpy(values, row + x, sizeof(values));
+
+            acc[0] = round(acc[0], values[0]);
+            acc[1] = round(acc[1], values[1]);
+            acc[2] = round(acc[2], values[2]);
+            acc[3] = round(acc[3], values[3]);
+        }
+
+        row += frame.stride();
+    }
+
+    uint64_t hash = round(round(acc[0], acc[1]), round(acc[2], acc[3]));
+    hash ^= hash >> 29;
+    return hash;
+}
+
+bool VideoTileCache::touch(uint64_t hash)
+{
+    auto result = index_.find(hash);
+    if (result == index_.end())
+        return false;
+
+    tiles_.splice(tiles_.begin(), tiles_, result->second);
+    return true;
+}
+
+bool VideoTileCache::copyTile(uint64_t hash, Frame* frame, const Point& pos)
+{
+    DCHECK(store_pixels_);
+
+    if (!touch(hash))
+        return false;
+
+    frame->copyPixelsFrom(tiles_.front().pixels.get(), kTileRowSize,
+                          Rect::makeXYWH(pos.x(), pos.y(), kTileSize, kTileSize));
+    return true;
+}
+
+void VideoTileCache::addTile(uint64_t hash, const Frame& frame, const Point& pos)
+{
+    if (!capacity_ || touch(hash))
+        return;
+
+    std::unique_ptr<uint8_t[]> pixels;
+
+    if (tiles_.size() >= capacity_)
+    {
+        // Reuse the buffer of the least recently used tile.
+        index_.erase(tiles_.back().hash);
+        pixels = std::move(tiles_.back().pixels);
+        tiles_.pop_back();
+    }
+
+    if (store_pixels_)
+    {
+        DCHECK_EQ(frame.format().bytesPerPixel(), kBytesPerPixel);
+
+        if (!pixels)
+            pixels = std::make_unique<uint8_t[]>(kTileSize * kTileRowSize);
+
+        const uint8_t* source = frame.frameDataAtPos(pos);
+        uint8_t* target = pixels.get();
+
+        for (int y = 0; y < kTileSize; ++y)
+        {
+            memcpy(target, source, kTileRowSize);
+            source += frame.stride();
+            target += kTileRowSize;
+        }
+    }
+
+    tiles_.push_front({ hash, std::move(pixels) });
+    index_.emplace(hash, tiles_.begin());
+}
+
+} // namespace base
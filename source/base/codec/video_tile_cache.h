@@ -0,0 +1,86 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_CODEC_VIDEO_TILE_CACHE_H
+#define BASE_CODEC_VIDEO_TILE_CACHE_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace base {
+
+class Frame;
+
+// LRU cache of 64x64 tiles of the screen identified by the hash of their pixels.
+// The encoder keeps only the hashes, the decoder also keeps the pixels. Both sides stay in sync
+// because they perform the same operations in the same order: all lookups of a packet first,
+// then all additions.
+class VideoTileCache
+{
+public:
+    static constexpr int kTileSize = 64;
+
+    // Upper limit of the capacity (64 MB of 32-bit pixels).
+    static constexpr size_t kMaxCapacity = 4096;
+
+    // If |store_pixels| is false, only the hashes of the tiles are kept.
+    VideoTileCache(size_t capacity, bool store_pixels);
+    ~VideoTileCache();
+
+    size_t capacity() const { return capacity_; }
+
+    // Calculates the hash of the tile of |frame| at |pos|. The tile must be inside the frame.
+    static uint64_t tileHash(const Frame& frame, const Point& pos);
+
+    // Returns true if the tile is in the cache and marks it as recently used.
+    bool touch(uint64_t hash);
+
+    // Copies the pixels of the tile to |frame| at |pos| and marks it as recently used. Returns
+    // false if the tile is not in the cache.
+    bool copyTile(uint64_t hash, Frame* frame, const Point& pos);
+
+    // Adds the tile of |frame| at |pos| to the cache. The least recently used tile is removed if
+    // the cache is full.
+    void addTile(uint64_t hash, const Frame& frame, const Point& pos);
+
+private:
+    struct Tile
+    {
+        uint64_t hash;
+        std::unique_ptr<uint8_t[]> pixels;
+    };
+
+    using TileList = std::list<Tile>;
+
+    const size_t capacity_;
+    const bool store_pixels_;
+
+    // The most recently used tiles are at the front.
+    TileList tiles_;
+    std::unordered_map<uint64_t, TileList::iterator> index_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoTileCache);
+};
+
+} // namespace base
+
+#endif // BASE_CODEC_VIDEO_TILE_CACHE_H
@@ -0,0 +1,277 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "base/codec/video_tile_cache.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const int kTileSize = VideoTileCache::kTileSize;
+
+std::unique_ptr<Frame> createFrame(int tiles_x, int tiles_y)
+{
+    std::unique_ptr<Frame> frame =
+        FrameSimple::create(Size(tiles_x * kTileSize, tiles_y * kTileSize), PixelFormat::ARGB());
+    memset(frame->frameData(), 0, static_cast<size_t>(frame->stride() * frame->size().height()));
+    return frame;
+}
+
+// Fills the tile at |pos| with a pattern which is different for every |seed|.
+void fillTile(Frame* frame, const Point& pos, uint32_t seed)
+{
+    for (int y = 0; y < kTileSize; ++y)
+    {
+        uint8_t* row = frame->frameDataAtPos(pos.x(), pos.y() + y);
+
+        for (int x = 0; x < kTileSize; ++x)
+        {
+            const uint32_t value = seed * 0x9E3779B1U + static_cast<uint32_t>(y * kTileSize + x);
+            memcpy(row + x * 4, &value, sizeof(value));
+        }
+    }
+}
+
+bool equalTiles(const Frame& first, const Point& first_pos,
+                const Frame& second, const Point& second_pos)
+{
+    for (int y = 0; y < kTileSize; ++y)
+    {
+        if (memcmp(first.frameDataAtPos(first_pos.x(), first_pos.y() + y),
+                   second.frameDataAtPos(second_pos.x(), second_pos.y() + y),
+                   kTileSize * 4) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct TestTile
+{
+    Point pos;
+    uint64_t hash;
+};
+
+struct TestPacket
+{
+    std::vector<TestTile> cached_tiles;
+    std::vector<TestTile> new_tiles;
+};
+
+// Does the same cache operations as VideoEncoderZstd: all lookups of the packet first, then all
+// additions.
+TestPacket encode(VideoTileCache* cache, const Frame& frame, const std::vector<Point>& tiles)
+{
+    TestPacket packet;
+
+    for (const auto& pos : tiles)
+    {
+        const uint64_t hash = VideoTileCache::tileHash(frame, pos);
+
+        if (cache->touch(hash))
+            packet.cached_tiles.push_back({ pos, hash });
+        else
+            packet.new_tiles.push_back({ pos, hash });
+    }
+
+    for (const auto& tile : packet.new_tiles)
+        cache->addTile(tile.hash, frame, tile.pos);
+
+    return packet;
+}
+
+// Does the same cache operations as VideoDecoderZstd. The new tiles are copied from |source|
+// instead of decoding.
+bool decode(VideoTileCache* cache, const TestPacket& packet, const Frame& source, Frame* target)
+{
+    for (const auto& tile : packet.cached_tiles)
+    {
+        if (!cache->copyTile(tile.hash, target, tile.pos))
+            return false;
+    }
+
+    for (const auto& tile : packet.new_tiles)
+    {
+        target->copyPixelsFrom(
+            source, tile.pos, Rect::makeXYWH(tile.pos.x(), tile.pos.y(), kTileSize, kTileSize));
+    }
+
+    for (const auto& tile : packet.new_tiles)
+        cache->addTile(tile.hash, *target, tile.pos);
+
+    return true;
+}
+
+} // namespace
+
+TEST(VideoTileCacheTest, TileHash)
+{
+    std::unique_ptr<Frame> first = createFrame(2, 1);
+    std::unique_ptr<Frame> second = createFrame(3, 2);
+
+    fillTile(first.get(), Point(0, 0), 1);
+    fillTile(first.get(), Point(kTileSize, 0), 2);
+    fillTile(second.get(), Point(2 * kTileSize, kTileSize), 1);
+
+    // The hash depends only on the pixels of the tile, not on its position or the frame stride.
+    EXPECT_EQ(VideoTileCache::tileHash(*first, Point(0, 0)),
+              VideoTileCache::tileHash(*second, Point(2 * kTileSize, kTileSize)));
+    EXPECT_NE(VideoTileCache::tileHash(*first, Point(0, 0)),
+              VideoTileCache::tileHash(*first, Point(kTileSize, 0)));
+
+    // A change of one pixel changes the hash.
+    const uint64_t hash = VideoTileCache::tileHash(*first, Point(0, 0));
+    first->frameDataAtPos(kTileSize - 1, kTileSize - 1)[0] ^= 1;
+    EXPECT_NE(VideoTileCache::tileHash(*first, Point(0, 0)), hash);
+}
+
+TEST(VideoTileCacheTest, Eviction)
+{
+    std::unique_ptr<Frame> frame = createFrame(4, 1);
+    uint64_t hash[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        fillTile(frame.get(), Point(i * kTileSize, 0), static_cast<uint32_t>(i));
+        hash[i] = VideoTileCache::tileHash(*frame, Point(i * kTileSize, 0));
+    }
+
+    VideoTileCache cache(2, false);
+    EXPECT_EQ(cache.capacity(), 2U);
+
+    cache.addTile(hash[0], *frame, Point(0, 0));
+    cache.addTile(hash[1], *frame, Point(kTileSize, 0));
+
+    // The touched tile becomes the most recently used one, so the other tile is evicted.
+    EXPECT_TRUE(cache.touch(hash[0]));
+    cache.addTile(hash[2], *frame, Point(2 * kTileSize, 0));
+
+    EXPECT_FALSE(cache.touch(hash[1]));
+    EXPECT_TRUE(cache.touch(hash[2]));
+    EXPECT_TRUE(cache.touch(hash[0]));
+
+    // Adding a tile which is already in the cache only marks it as recently used.
+    cache.addTile(hash[2], *frame, Point(2 * kTileSize, 0));
+    cache.addTile(hash[3], *frame, Point(3 * kTileSize, 0));
+
+    EXPECT_FALSE(cache.touch(hash[0]));
+    EXPECT_TRUE(cache.touch(hash[2]));
+    EXPECT_TRUE(cache.touch(hash[3]));
+}
+
+TEST(VideoTileCacheTest, ZeroCapacity)
+{
+    std::unique_ptr<Frame> frame = createFrame(1, 1);
+    fillTile(frame.get(), Point(0, 0), 1);
+
+    const uint64_t hash = VideoTileCache::tileHash(*frame, Point(0, 0));
+
+    VideoTileCache cache(0, true);
+    cache.addTile(hash, *frame, Point(0, 0));
+
+    EXPECT_FALSE(cache.touch(hash));
+}
+
+TEST(VideoTileCacheTest, CopyTile)
+{
+    std::unique_ptr<Frame> source = createFrame(2, 2);
+    std::unique_ptr<Frame> target = createFrame(3, 1);
+
+    fillTile(source.get(), Point(kTileSize, kTileSize), 7);
+    const uint64_t hash = VideoTileCache::tileHash(*source, Point(kTileSize, kTileSize));
+
+    VideoTileCache cache(4, true);
+    cache.addTile(hash, *source, Point(kTileSize, kTileSize));
+
+    // The source can change after the tile is added.
+    fillTile(source.get(), Point(kTileSize, kTileSize), 8);
+
+    EXPECT_TRUE(cache.copyTile(hash, target.get(), Point(2 * kTileSize, 0)));
+    EXPECT_EQ(VideoTileCache::tileHash(*target, Point(2 * kTileSize, 0)), hash);
+
+    fillTile(source.get(), Point(kTileSize, kTileSize), 7);
+    EXPECT_TRUE(equalTiles(*source, Point(kTileSize, kTileSize), *target, Point(2 * kTileSize, 0)));
+
+    // The frame is not changed if the tile is not in the cache.
+    std::unique_ptr<Frame> empty = createFrame(1, 1);
+    EXPECT_FALSE(cache.copyTile(hash + 1, target.get(), Point(0, 0)));
+    EXPECT_TRUE(equalTiles(*empty, Point(0, 0), *target, Point(0, 0)));
+}
+
+TEST(VideoTileCacheTest, EncoderAndDecoderInSync)
+{
+    const int kTilesX = 4;
+    const int kTilesY = 2;
+    const uint32_t kContents = 12;
+
+    std::unique_ptr<Frame> source = createFrame(kTilesX, kTilesY);
+    std::unique_ptr<Frame> target = createFrame(kTilesX, kTilesY);
+
+    // The capacity is smaller than the number of tiles in a packet, so tiles are evicted in every
+    // packet.
+    VideoTileCache encoder_cache(6, false);
+    VideoTileCache decoder_cache(6, true);
+
+    std::vector<Point> tiles;
+    for (int y = 0; y < kTilesY; ++y)
+    {
+        for (int x = 0; x < kTilesX; ++x)
+            tiles.emplace_back(x * kTileSize, y * kTileSize);
+    }
+
+    uint32_t random = 1;
+    size_t cached_count = 0;
+    size_t new_count = 0;
+
+    for (int i = 0; i < 200; ++i)
+    {
+        // Contents repeat within a packet and between packets.
+        for (const auto& pos : tiles)
+        {
+            random = random * 1103515245U + 12345U;
+            fillTile(source.get(), pos, (random >> 16) % kContents);
+        }
+
+        TestPacket packet = encode(&encoder_cache, *source, tiles);
+        ASSERT_EQ(packet.cached_tiles.size() + packet.new_tiles.size(), tiles.size());
+
+        cached_count += packet.cached_tiles.size();
+        new_count += packet.new_tiles.size();
+
+        // Every tile which the encoder takes from its cache must be in the cache of the decoder.
+        ASSERT_TRUE(decode(&decoder_cache, packet, *source, target.get())) << "Packet " << i;
+
+        for (const auto& pos : tiles)
+            ASSERT_TRUE(equalTiles(*source, pos, *target, pos)) << "Packet " << i;
+    }
+
+    EXPECT_NE(cached_count, 0U);
+    EXPECT_NE(new_count, 0U);
+}
+
+} // namespace base
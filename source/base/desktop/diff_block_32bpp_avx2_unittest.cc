@@ -0,0 +1,317 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/aligned_memory.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+
+#include <gtest/gtest.h>
+#include <libyuv/cpu_id.h>
+
+namespace base {
+
+namespace {
+
+using AlignedBuffer = std::unique_ptr<uint8_t, AlignedFreeDeleter>;
+
+// Run 900 times to mimic 1280x720.
+const int kTimesToRun = 900;
+const int kBytesPerPixel = 4;
+const int kAlignment = 16;
+
+void generateData(uint8_t* data, int size)
+{
+    for (int i = 0; i < size; ++i)
+        data[i] = i;
+}
+
+int fullBlockSize(int block_size)
+{
+    return block_size * block_size * kBytesPerPixel;
+}
+
+void prepareBuffers(AlignedBuffer* block1, AlignedBuffer* block2, int block_size, int alignment)
+{
+    int full_block_size = fullBlockSize(block_size);
+
+    block1->reset(reinterpret_cast<uint8_t*>(alignedAlloc(full_block_size, alignment)));
+    block2->reset(reinterpret_cast<uint8_t*>(alignedAlloc(full_block_size, alignment)));
+
+    generateData(block1->get(), full_block_size);
+
+    memcpy(block2->get(), block1->get(), full_block_size);
+}
+
+using DiffFullBlockFunc = uint8_t(*)(const uint8_t*, const uint8_t*, int);
+
+// Compares two synthetic frames block by block the same way as Differ does. Every
+// |changed_block_interval| block of the second frame has a changed pixel in its last row, which is
+// the worst case for the kernels that stop at the first changed row. Zero means that the frames
+// are equal.
+void benchmarkFrame(DiffFullBlockFunc func, int width, int height, int changed_block_interval)
+{
+    static const int kBlockSize = 16;
+    static const int kFrameCount = 60;
+
+    const int bytes_per_row = width * kBytesPerPixel;
+    const int frame_size = bytes_per_row * height;
+    const int blocks_x = width / kBlockSize;
+    const int blocks_y = height / kBlockSize;
+
+    AlignedBuffer frame1(reinterpret_cast<uint8_t*>(alignedAlloc(frame_size, kAlignment)));
+    AlignedBuffer frame2(reinterpret_cast<uint8_t*>(alignedAlloc(frame_size, kAlignment)));
+
+    generateData(frame1.get(), frame_size);
+    memcpy(frame2.get(), frame1.get(), frame_size);
+
+    int expected_count = 0;
+
+    if (changed_block_interval != 0)
+    {
+        for (int block = 0; block < blocks_x * blocks_y; block += changed_block_interval)
+        {
+            int x = (block % blocks_x) * kBlockSize;
+            int y = (block / blocks_x) * kBlockSize + kBlockSize - 1;
+
+            frame2.get()[y * bytes_per_row + x * kBytesPerPixel] += 1;
+            ++expected_count;
+        }
+    }
+
+    for (int i = 0; i < kFrameCount; ++i)
+    {
+        int count = 0;
+
+        for (int y = 0; y < blocks_y; ++y)
+        {
+            const int offset = y * kBlockSize * bytes_per_row;
+
+            for (int x = 0; x < blocks_x; ++x)
+            {
+                const int block_offset = offset + x * kBlockSize * kBytesPerPixel;
+
+                count += func(frame1.get() + block_offset, frame2.get() + block_offset,
+                              bytes_per_row);
+            }
+        }
+
+        EXPECT_EQ(expected_count, count);
+    }
+}
+
+void benchmarkFunc(DiffFullBlockFunc func, int width, int height)
+{
+    // No changes, 1%, 10% and 100% of changed blocks.
+    for (int changed_block_interval : { 0, 100, 10, 1 })
+        benchmarkFrame(func, width, height, changed_block_interval);
+}
+
+} // namespace
+
+TEST(diff_block_avx2, block_difference_test_same)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    AlignedBuffer block1;
+    AlignedBuffer block2;
+
+    {
+        static const int kBlockSize = 32;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+
+        // These blocks should match.
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_32x32_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(0, result);
+        }
+    }
+
+    {
+        static const int kBlockSize = 16;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+
+        // These blocks should match.
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_16x16_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(0, result);
+        }
+    }
+}
+
+TEST(diff_block_avx2, block_difference_test_last)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    AlignedBuffer block1;
+    AlignedBuffer block2;
+
+    {
+        static const int kBlockSize = 32;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[fullBlockSize(kBlockSize) - 2] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_32x32_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+
+    {
+        static const int kBlockSize = 16;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[fullBlockSize(kBlockSize) - 2] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_16x16_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+}
+
+TEST(diff_block_avx2, block_difference_test_mid)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    AlignedBuffer block1;
+    AlignedBuffer block2;
+
+    {
+        static const int kBlockSize = 32;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[fullBlockSize(kBlockSize) / 2 + 1] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_32x32_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+
+    {
+        static const int kBlockSize = 16;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[fullBlockSize(kBlockSize) / 2 + 1] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_16x16_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+}
+
+TEST(diff_block_avx2, block_difference_test_first)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    AlignedBuffer block1;
+    AlignedBuffer block2;
+
+    {
+        static const int kBlockSize = 32;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[0] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_32x32_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+
+    {
+        static const int kBlockSize = 16;
+
+        prepareBuffers(&block1, &block2, kBlockSize, kAlignment);
+        block2.get()[0] += 1;
+
+        for (int i = 0; i < kTimesToRun; ++i)
+        {
+            int result = diffFullBlock_32bpp_16x16_AVX2(
+                block1.get(), block2.get(), kBlockSize * kBytesPerPixel);
+            EXPECT_EQ(1, result);
+        }
+    }
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_1080p_c)
+{
+    benchmarkFunc(diffFullBlock_32bpp_16x16_C, 1920, 1080);
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_1080p_sse2)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
+        return;
+
+    benchmarkFunc(diffFullBlock_32bpp_16x16_SSE2, 1920, 1080);
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_1080p_avx2)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    benchmarkFunc(diffFullBlock_32bpp_16x16_AVX2, 1920, 1080);
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_4k_c)
+{
+    benchmarkFunc(diffFullBlock_32bpp_16x16_C, 3840, 2160);
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_4k_sse2)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
+        return;
+
+    benchmarkFunc(diffFullBlock_32bpp_16x16_SSE2, 3840, 2160);
+}
+
+TEST(diff_block_avx2, DISABLED_benchmark_4k_avx2)
+{
+    if (!libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+        return;
+
+    benchmarkFunc(diffFullBlock_32bpp_16x16_AVX2, 3840, 2160);
+}
+
+} // namespace base
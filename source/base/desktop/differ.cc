@@ -19,10 +19,17 @@
 #include "base/desktop/differ.h"
 
 #include "base/logging.h"
-#include "base/desktop/diff_block_32bpp_sse2.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
 #include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_neon.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+#include "base/threading/thread_pool.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
 #include <libyuv/cpu_id.h>
 
 namespace base {
@@ -33,6 +40,16 @@ const int kBlockSize = 16;
 const int kBytesPerPixel = 4;
 const int kBytesPerBlock = kBlockSize * kBytesPerPixel;
 
+// Frames smaller than this (a bit less than 4K) are compared on the calling thread: for them the
+// cost of waking up the threads is comparable to the comparison itself.
+const int kMinPixelsForThreads = 3200 * 1800;
+
+// Each band must contain at least this number of block rows.
+const int kMinRowsPerBand = 16;
+
+// The comparison is limited by memory bandwidth, so more threads do not help much.
+const size_t kMaxThreadCount = 4;
+
 // Check for diffs in upper-left portion of the block. The size of the portion to check is
 // specified by the |width| and |height| values.
 // Note that if we force the capturer to always return images whose width and height are multiples
@@ -55,11 +72,48 @@ uint8_t diffPartialBlock(const uint8_t* prev_image,
     return 0U;
 }
 
+// Calculates a 64-bit hash of |size| bytes. The main loop is the round of xxHash64 on four
+// independent lanes, which is several times faster than base::crc32 and is limited by the
+// memory bandwidth rather than by the calculation.
+uint64_t hashBand(const uint8_t* data, size_t size)
+{
+    static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+    auto round = [](uint64_t acc, uint64_t value)
+    {
+        acc += value * kPrime2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * kPrime1;
+    };
+
+    uint64_t acc[4] = { kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1 };
+    const uint8_t* end = data + size;
+
+    while (end - data >= 32)
+    {
+        uint64_t values[4];
+        memcpy(values, data, sizeof(values));
+
+        acc[0] = round(acc[0], values[0]);
+        acc[1] = round(acc[1], values[1]);
+        acc[2] = round(acc[2], values[2]);
+        acc[3] = round(acc[3], values[3]);
+
+        data += 32;
+    }
+
+    uint64_t hash = round(round(acc[0], acc[1]), round(acc[2], acc[3])) + size;
+
+    while (data < end)
+        hash = round(hash, *data++);
 
+    return hash;
+}
 
 } // namespace
 
-Differ::Differ(const Size& size)
+Differ::Differ(const Size& size, size_t thread_count)
     : screen_rect_(Rect::makeSize(size)),
       bytes_per_row_(size.width() * kBytesPerPixel),
       diff_width_(((size.width() + kBlockSize - 1) / kBlockSize) + 1),
@@ -91,31 +145,90 @@ Differ::Differ(const Size& size)
 
     diff_full_block_func_ = diffFunction();
     CHECK(diff_full_block_func_);
+
+    if (!thread_count)
+    {
+        if (size.width() * size.height() >= kMinPixelsForThreads)
+        {
+            thread_count = std::min(
+                static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1U)),
+                kMaxThreadCount);
+        }
+        else
+        {
+            thread_count = 1;
+        }
+    }
+
+    band_count_ = std::clamp(
+        static_cast<size_t>(full_blocks_y_ / kMinRowsPerBand), size_t(1), thread_count);
+    if (band_count_ > 1)
+        thread_pool_ = std::make_unique<ThreadPool>(band_count_ - 1);
+
+    LOG(LS_INFO) << "Bands: " << band_count_;
+}
+
+Differ::~Differ() = default;
+
+void Differ::setBandHashingEnabled(bool enable)
+{
+    if (enable == !!row_hashes_)
+        return;
+
+    LOG(LS_INFO) << "Band hashing " << (enable ? "enabled" : "disabled");
+
+    if (enable)
+        row_hashes_ = std::make_unique<uint64_t[]>(static_cast<size_t>(full_blocks_y_ + 1));
+    else
+        row_hashes_.reset();
+
+    row_hashes_valid_ = false;
+    last_image_ = nullptr;
 }
 
 // static
 Differ::DiffFullBlockFunc Differ::diffFunction()
 {
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (libyuv::TestCpuFlag(libyuv::kCpuHasAVX2))
+    {
+        LOG(LS_INFO) << "AVX2 differ loaded";
+
+        if constexpr (kBlockSize == 16)
+            return diffFullBlock_32bpp_16x16_AVX2;
+        else if constexpr (kBlockSize == 32)
+            return diffFullBlock_32bpp_32x32_AVX2;
+    }
+
     if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
     {
-#if defined(ARCH_CPU_X86_FAMILY)
         LOG(LS_INFO) << "SSE2 differ loaded";
 
         if constexpr (kBlockSize == 16)
             return diffFullBlock_32bpp_16x16_SSE2;
         else if constexpr (kBlockSize == 32)
             return diffFullBlock_32bpp_32x32_SSE2;
-#endif // defined(ARCH_CPU_X86_FAMILY)
     }
-    else
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+#if defined(ARCH_CPU_ARM64)
+    if (libyuv::TestCpuFlag(libyuv::kCpuHasNEON))
     {
-        LOG(LS_INFO) << "C differ loaded";
+        LOG(LS_INFO) << "NEON differ loaded";
 
         if constexpr (kBlockSize == 16)
-            return diffFullBlock_32bpp_16x16_C;
+            return diffFullBlock_32bpp_16x16_NEON;
         else if constexpr (kBlockSize == 32)
-            return diffFullBlock_32bpp_32x32_C;
+            return diffFullBlock_32bpp_32x32_NEON;
     }
+#endif // defined(ARCH_CPU_ARM64)
+
+    LOG(LS_INFO) << "C differ loaded";
+
+    if constexpr (kBlockSize == 16)
+        return diffFullBlock_32bpp_16x16_C;
+    else if constexpr (kBlockSize == 32)
+        return diffFullBlock_32bpp_32x32_C;
 
     return nullptr;
 }
@@ -123,21 +236,73 @@ Differ::DiffFullBlockFunc Differ::diffFunction()
 // Identify all of the blocks that contain changed pixels.
 void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image)
 {
-    const uint8_t* prev_block_row_start = prev_image;
-    const uint8_t* curr_block_row_start = curr_image;
+    if (band_count_ > 1)
+    {
+        std::mutex lock;
+        std::condition_variable event;
+        size_t pending_bands = band_count_ - 1;
+
+        const int rows_per_band = full_blocks_y_ / static_cast<int>(band_count_);
+
+        for (size_t i = 1; i < band_count_; ++i)
+        {
+            const int first_row = static_cast<int>(i) * rows_per_band;
+            const int last_row =
+                (i == band_count_ - 1) ? full_blocks_y_ : first_row + rows_per_band;
+
+            thread_pool_->postTask([&, first_row, last_row]()
+            {
+                markDirtyBlockRows(prev_image, curr_image, first_row, last_row);
+
+                std::scoped_lock scoped_lock(lock);
+                if (--pending_bands == 0)
+                    event.notify_one();
+            });
+        }
+
+        // The bands do not overlap, so each thread writes only its own rows of |diff_info_|.
+        markDirtyBlockRows(prev_image, curr_image, 0, rows_per_band);
+
+        std::unique_lock unique_lock(lock);
+        while (pending_bands != 0)
+            event.wait(unique_lock);
+    }
+    else
+    {
+        markDirtyBlockRows(prev_image, curr_image, 0, full_blocks_y_);
+    }
+
+    markDirtyPartialRow(prev_image, curr_image);
+}
+
+void Differ::markDirtyBlockRows(const uint8_t* prev_image, const uint8_t* curr_image,
+                                int first_row, int last_row)
+{
+    const uint8_t* prev_block_row_start = prev_image + first_row * block_stride_y_;
+    const uint8_t* curr_block_row_start = curr_image + first_row * block_stride_y_;
 
     // Offset from the start of one diff_info row to the next.
     const int diff_stride = diff_width_;
 
-    uint8_t* is_diff_row_start = diff_info_.get();
+    uint8_t* is_diff_row_start = diff_info_.get() + first_row * diff_stride;
 
-    for (int y = 0; y < full_blocks_y_; ++y)
+    for (int y = first_row; y < last_row; ++y)
     {
         const uint8_t* prev_block = prev_block_row_start;
         const uint8_t* curr_block = curr_block_row_start;
 
         uint8_t* is_different = is_diff_row_start;
 
+        if (isRowUnchanged(y, curr_block_row_start, block_stride_y_))
+        {
+            memset(is_diff_row_start, 0, static_cast<size_t>(diff_stride));
+
+            prev_block_row_start += block_stride_y_;
+            curr_block_row_start += block_stride_y_;
+            is_diff_row_start += diff_stride;
+            continue;
+        }
+
         for (int x = 0; x < full_blocks_x_; ++x)
         {
             // Mark this block as being modified so that it gets incorporated into a dirty rect.
@@ -166,15 +331,24 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
 
         is_diff_row_start += diff_stride;
     }
+}
 
+void Differ::markDirtyPartialRow(const uint8_t* prev_image, const uint8_t* curr_image)
+{
     // If the screen height is not a multiple of the block size, then this handles the last partial
     // row. This situation is far more common than the 'partial column' case.
     if (partial_row_height_ != 0)
     {
-        const uint8_t* prev_block = prev_block_row_start;
-        const uint8_t* curr_block = curr_block_row_start;
+        const uint8_t* prev_block = prev_image + full_blocks_y_ * block_stride_y_;
+        const uint8_t* curr_block = curr_image + full_blocks_y_ * block_stride_y_;
 
-        uint8_t* is_different = is_diff_row_start;
+        uint8_t* is_different = diff_info_.get() + full_blocks_y_ * diff_width_;
+
+        if (isRowUnchanged(full_blocks_y_, curr_block, partial_row_height_ * bytes_per_row_))
+        {
+            memset(is_different, 0, static_cast<size_t>(diff_width_));
+            return;
+        }
 
         for (int x = 0; x < full_blocks_x_; ++x)
         {
@@ -201,6 +375,18 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
     }
 }
 
+bool Differ::isRowUnchanged(int row, const uint8_t* curr_row, int size)
+{
+    if (!row_hashes_)
+        return false;
+
+    const uint64_t hash = hashBand(curr_row, static_cast<size_t>(size));
+    const bool unchanged = row_hashes_valid_ && row_hashes_[row] == hash;
+
+    row_hashes_[row] = hash;
+    return unchanged;
+}
+
 // After the dirty blocks have been identified, this routine merges adjacent blocks into a region.
 // The goal is to minimize the region that covers the dirty blocks.
 void Differ::mergeBlocks(Region* dirty_region)
@@ -290,9 +476,15 @@ void Differ::calcDirtyRegion(const uint8_t* prev_image,
 {
     dirty_region->clear();
 
+    // The saved hashes describe the image passed as |curr_image| in the previous call. They can
+    // be used only if it is now passed as |prev_image|.
+    row_hashes_valid_ = row_hashes_ && prev_image == last_image_;
+
     // Identify all the blocks that contain changed pixels.
     markDirtyBlocks(prev_image, curr_image);
 
+    last_image_ = curr_image;
+
     // Now that we've identified the blocks that have changed, merge adjacent blocks to minimize
     // the number of rects that we return.
     mergeBlocks(dirty_region);
@@ -26,12 +26,25 @@
 
 namespace base {
 
+class ThreadPool;
+
 // Class to search for changed regions of the screen.
+// For large frames the blocks are compared on several threads, each of them handles its own band
+// of block rows.
 class Differ
 {
 public:
-    explicit Differ(const Size& size);
-    ~Differ() = default;
+    // If |thread_count| is 0, the number of threads is chosen depending on the frame size and the
+    // number of processors. Small frames are always compared on the calling thread.
+    explicit Differ(const Size& size, size_t thread_count = 0);
+    ~Differ();
+
+    // When band hashing is enabled, a hash is kept for every row of blocks of the previous image.
+    // Rows whose hash has not changed are skipped without reading the previous image, which
+    // halves the memory traffic for mostly static screens. It requires that the image passed as
+    // |curr_image| is passed as |prev_image| in the next call and is not modified in between;
+    // otherwise all rows are compared.
+    void setBandHashingEnabled(bool enable);
 
     void calcDirtyRegion(const uint8_t* prev_image,
                          const uint8_t* curr_image,
@@ -43,6 +56,10 @@ private:
     static DiffFullBlockFunc diffFunction();
 
     void markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image);
+    void markDirtyBlockRows(const uint8_t* prev_image, const uint8_t* curr_image,
+                            int first_row, int last_row);
+    void markDirtyPartialRow(const uint8_t* prev_image, const uint8_t* curr_image);
+    bool isRowUnchanged(int row, const uint8_t* curr_row, int size);
     void mergeBlocks(Region* dirty_region);
 
     const Rect screen_rect_;
@@ -59,6 +76,15 @@ private:
     std::unique_ptr<uint8_t[]> diff_info_;
     DiffFullBlockFunc diff_full_block_func_;
 
+    // Number of bands the block rows are split into. The first band is handled by the calling
+    // thread, the others by |thread_pool_|.
+    size_t band_count_ = 1;
+    std::unique_ptr<ThreadPool> thread_pool_;
+
+    std::unique_ptr<uint64_t[]> row_hashes_;
+    bool row_hashes_valid_ = false;
+    const uint8_t* last_image_ = nullptr;
+
     DISALLOW_COPY_AND_ASSIGN(Differ);
 };
 
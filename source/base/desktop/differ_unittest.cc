@@ -0,0 +1,305 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/differ.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const int kBytesPerPixel = 4;
+
+class TestFrames
+{
+public:
+    explicit TestFrames(const Size& size)
+        : size_(size),
+          prev_(static_cast<size_t>(size.width() * size.height() * kBytesPerPixel)),
+          curr_(prev_.size())
+    {
+        for (size_t i = 0; i < prev_.size(); ++i)
+            prev_[i] = static_cast<uint8_t>(i);
+
+        memcpy(curr_.data(), prev_.data(), prev_.size());
+    }
+
+    void changePixel(int x, int y)
+    {
+        curr_[static_cast<size_t>((y * size_.width() + x) * kBytesPerPixel)] += 1;
+    }
+
+    // The current frame becomes the previous one and the new current frame gets its contents.
+    void nextFrame()
+    {
+        prev_.swap(curr_);
+        memcpy(curr_.data(), prev_.data(), prev_.size());
+    }
+
+    // Changes one pixel in every |interval| block of 16x16 pixels.
+    void changeBlocks(int interval)
+    {
+        int index = 0;
+
+        for (int y = 0; y < size_.height(); y += 16)
+        {
+            for (int x = 0; x < size_.width(); x += 16)
+            {
+                if (index++ % interval == 0)
+                    changePixel(x, y);
+            }
+        }
+    }
+
+    const uint8_t* prev() const { return prev_.data(); }
+    const uint8_t* curr() const { return curr_.data(); }
+
+private:
+    const Size size_;
+    std::vector<uint8_t> prev_;
+    std::vector<uint8_t> curr_;
+};
+
+void benchmarkDiffer(const Size& size, size_t thread_count)
+{
+    static const int kFrameCount = 100;
+
+    TestFrames frames(size);
+    frames.changeBlocks(10);
+
+    Differ differ(size, thread_count);
+    Region region;
+
+    for (int i = 0; i < kFrameCount; ++i)
+    {
+        differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+        EXPECT_FALSE(region.isEmpty());
+    }
+}
+
+void benchmarkBandHashing(int changed_block_interval, bool band_hashing)
+{
+    static const int kFrameCount = 100;
+    const Size kSize(3840, 2160);
+
+    TestFrames frames(kSize);
+    Differ differ(kSize, 1);
+    differ.setBandHashingEnabled(band_hashing);
+
+    Region region;
+
+    for (int i = 0; i < kFrameCount; ++i)
+    {
+        frames.nextFrame();
+
+        // Only the pixels changed in this frame are different, the ones changed in the previous
+        // frame stay as they are.
+        if (changed_block_interval != 0)
+            frames.changeBlocks(changed_block_interval);
+
+        differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+        EXPECT_EQ(region.isEmpty(), changed_block_interval == 0);
+    }
+}
+
+} // namespace
+
+TEST(differ_test, no_changes)
+{
+    const Size kSize(1920, 1080);
+
+    TestFrames frames(kSize);
+    Differ differ(kSize);
+    Region region;
+
+    differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+    EXPECT_TRUE(region.isEmpty());
+}
+
+TEST(differ_test, changed_pixel)
+{
+    const Size kSize(1920, 1080);
+
+    TestFrames frames(kSize);
+    frames.changePixel(100, 1079);
+
+    Differ differ(kSize);
+    Region region;
+
+    differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+    EXPECT_TRUE(region.equals(Region(Rect::makeXYWH(96, 1072, 16, 8))));
+}
+
+TEST(differ_test, threads_give_same_result)
+{
+    // The size is not a multiple of the block size to cover the partial blocks.
+    const Size kSize(3850, 2170);
+
+    std::mt19937 engine(123);
+    std::uniform_int_distribution<int> x_distribution(0, kSize.width() - 1);
+    std::uniform_int_distribution<int> y_distribution(0, kSize.height() - 1);
+
+    TestFrames frames(kSize);
+
+    for (int i = 0; i < 500; ++i)
+        frames.changePixel(x_distribution(engine), y_distribution(engine));
+
+    frames.changePixel(kSize.width() - 1, kSize.height() - 1);
+
+    Differ single_thread_differ(kSize, 1);
+    Region expected;
+    single_thread_differ.calcDirtyRegion(frames.prev(), frames.curr(), &expected);
+    EXPECT_FALSE(expected.isEmpty());
+
+    for (size_t thread_count : { 0, 2, 3, 4, 8 })
+    {
+        Differ differ(kSize, thread_count);
+
+        // Repeat to make sure that the state is reset between frames.
+        for (int i = 0; i < 3; ++i)
+        {
+            Region region;
+            differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+            EXPECT_TRUE(region.equals(expected)) << "threads: " << thread_count;
+        }
+    }
+}
+
+TEST(differ_test, band_hashing_gives_same_result)
+{
+    const Size kSize(1930, 1090);
+
+    std::mt19937 engine(321);
+    std::uniform_int_distribution<int> x_distribution(0, kSize.width() - 1);
+    std::uniform_int_distribution<int> y_distribution(0, kSize.height() - 1);
+    std::uniform_int_distribution<int> count_distribution(0, 3);
+
+    TestFrames frames(kSize);
+
+    Differ expected_differ(kSize, 1);
+    Differ differ(kSize, 1);
+    differ.setBandHashingEnabled(true);
+
+    Differ threaded_differ(kSize, 4);
+    threaded_differ.setBandHashingEnabled(true);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        frames.nextFrame();
+
+        const int count = count_distribution(engine);
+        for (int j = 0; j < count; ++j)
+            frames.changePixel(x_distribution(engine), y_distribution(engine));
+
+        if (i % 10 == 0)
+            frames.changePixel(kSize.width() - 1, kSize.height() - 1);
+
+        Region expected;
+        expected_differ.calcDirtyRegion(frames.prev(), frames.curr(), &expected);
+
+        Region region;
+        differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+        EXPECT_TRUE(region.equals(expected)) << "frame: " << i;
+
+        threaded_differ.calcDirtyRegion(frames.prev(), frames.curr(), &region);
+        EXPECT_TRUE(region.equals(expected)) << "frame: " << i;
+    }
+}
+
+TEST(differ_test, band_hashing_with_other_images)
+{
+    const Size kSize(640, 480);
+
+    TestFrames frames1(kSize);
+    TestFrames frames2(kSize);
+    frames2.changePixel(10, 10);
+
+    Differ differ(kSize);
+    differ.setBandHashingEnabled(true);
+
+    Region region;
+    differ.calcDirtyRegion(frames2.prev(), frames2.curr(), &region);
+    EXPECT_FALSE(region.isEmpty());
+
+    // The previous image is not the one passed as the current image in the last call, so the
+    // hashes must not be used.
+    differ.calcDirtyRegion(frames1.prev(), frames2.curr(), &region);
+    EXPECT_FALSE(region.isEmpty());
+}
+
+TEST(differ_test, DISABLED_benchmark_4k_1_thread)
+{
+    benchmarkDiffer(Size(3840, 2160), 1);
+}
+
+TEST(differ_test, DISABLED_benchmark_4k_2_threads)
+{
+    benchmarkDiffer(Size(3840, 2160), 2);
+}
+
+TEST(differ_test, DISABLED_benchmark_4k_4_threads)
+{
+    benchmarkDiffer(Size(3840, 2160), 4);
+}
+
+TEST(differ_test, DISABLED_benchmark_8k_1_thread)
+{
+    benchmarkDiffer(Size(7680, 4320), 1);
+}
+
+TEST(differ_test, DISABLED_benchmark_8k_2_threads)
+{
+    benchmarkDiffer(Size(7680, 4320), 2);
+}
+
+TEST(differ_test, DISABLED_benchmark_8k_4_threads)
+{
+    benchmarkDiffer(Size(7680, 4320), 4);
+}
+
+TEST(differ_test, DISABLED_benchmark_8k_8_threads)
+{
+    benchmarkDiffer(Size(7680, 4320), 8);
+}
+
+TEST(differ_test, DISABLED_benchmark_idle_compare)
+{
+    benchmarkBandHashing(0, false);
+}
+
+TEST(differ_test, DISABLED_benchmark_idle_band_hashing)
+{
+    benchmarkBandHashing(0, true);
+}
+
+TEST(differ_test, DISABLED_benchmark_busy_compare)
+{
+    benchmarkBandHashing(5, false);
+}
+
+TEST(differ_test, DISABLED_benchmark_busy_band_hashing)
+{
+    benchmarkBandHashing(5, true);
+}
+
+} // namespace base
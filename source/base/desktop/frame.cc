@@ -64,6 +64,35 @@ void Frame::copyPixelsFrom(const Frame& src_frame, const Point& src_pos, const R
     copyPixelsFrom(src_frame.frameDataAtPos(src_pos), src_frame.stride(), dest_rect);
 }
 
+void Frame::movePixels(const Rect& source_rect, const Point& target_pos)
+{
+    DCHECK(Rect::makeSize(size()).containsRect(source_rect));
+    DCHECK(Rect::makeSize(size()).containsRect(
+        Rect::makeXYWH(target_pos, source_rect.size())));
+
+    const size_t bytes_per_row = static_cast<size_t>(format_.bytesPerPixel() * source_rect.width());
+
+    uint8_t* source = frameDataAtPos(source_rect.topLeft());
+    uint8_t* target = frameDataAtPos(target_pos);
+    int row_stride = stride();
+
+    // When the area moves down, the rows are copied from the bottom so that the source rows are
+    // not overwritten before they are copied.
+    if (target_pos.y() > source_rect.y())
+    {
+        source += stride() * (source_rect.height() - 1);
+        target += stride() * (source_rect.height() - 1);
+        row_stride = -row_stride;
+    }
+
+    for (int y = 0; y < source_rect.height(); ++y)
+    {
+        memmove(target, source, bytes_per_row);
+        source += row_stride;
+        target += row_stride;
+    }
+}
+
 uint8_t* Frame::frameDataAtPos(const Point& pos) const
 {
     return frameDataAtPos(pos.x(), pos.y());
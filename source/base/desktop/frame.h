@@ -45,6 +45,10 @@ public:
     void copyPixelsFrom(const uint8_t* src_buffer, int src_stride, const Rect& dest_rect);
     void copyPixelsFrom(const Frame& src_frame, const Point& src_pos, const Rect& dest_rect);
 
+    // Moves the pixels of |source_rect| to |target_pos| within the frame. The source and target
+    // areas may overlap.
+    void movePixels(const Rect& source_rect, const Point& target_pos);
+
     const Region& constUpdatedRegion() const { return updated_region_; }
     Region* updatedRegion() { return &updated_region_; }
 
@@ -70,4 +70,46 @@ TEST(FrameTest, Performance)
     }
 }
 
+TEST(FrameTest, MovePixels)
+{
+    const Size kSize(64, 64);
+
+    auto frame = FrameSimple::create(kSize, PixelFormat::ARGB());
+    auto expected = FrameSimple::create(kSize, PixelFormat::ARGB());
+
+    for (int y = 0; y < kSize.height(); ++y)
+    {
+        for (int x = 0; x < kSize.width(); ++x)
+        {
+            uint32_t pixel = static_cast<uint32_t>(y * kSize.width() + x);
+            memcpy(frame->frameDataAtPos(x, y), &pixel, sizeof(pixel));
+        }
+    }
+
+    struct
+    {
+        Rect source_rect;
+        Point target_pos;
+    } cases[] =
+    {
+        { Rect::makeXYWH(0, 10, 64, 40), Point(0, 0) },  // Up.
+        { Rect::makeXYWH(0, 0, 64, 40), Point(0, 10) },  // Down.
+        { Rect::makeXYWH(10, 5, 40, 50), Point(0, 5) },  // Left.
+        { Rect::makeXYWH(0, 5, 40, 50), Point(10, 5) },  // Right.
+        { Rect::makeXYWH(0, 0, 30, 30), Point(20, 20) }  // Down and right.
+    };
+
+    for (size_t i = 0; i < std::size(cases); ++i)
+    {
+        expected->copyPixelsFrom(*frame, Point(0, 0), Rect::makeSize(kSize));
+        expected->copyPixelsFrom(*frame, cases[i].source_rect.topLeft(),
+                                 Rect::makeXYWH(cases[i].target_pos, cases[i].source_rect.size()));
+
+        frame->movePixels(cases[i].source_rect, cases[i].target_pos);
+
+        EXPECT_EQ(memcmp(frame->frameData(), expected->frameData(),
+                         static_cast<size_t>(frame->stride() * kSize.height())), 0) << i;
+    }
+}
+
 } // namespace base
@@ -0,0 +1,297 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/move_detector.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+// Rectangles smaller than this in any dimension are not checked.
+const int kMinRectSize = 64;
+
+// Lines are first compared by a strip in the middle of the rectangle. The edges of the rectangle
+// often contain scroll bars which move differently from the content.
+const int kMinStripLength = 16;
+const int kMaxStripLength = 256;
+
+// Minimum number of lines that must agree on the offset.
+const int kMinVotes = 8;
+
+// Minimum size of the moved area.
+const int kMinMoveLength = 32;
+const int kMinMoveWidth = 64;
+
+uint64_t hashLine(const uint32_t* pixels, int count)
+{
+    static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+    uint64_t hash = kPrime2;
+
+    for (int i = 0; i < count; ++i)
+    {
+        hash ^= pixels[i] * kPrime2;
+        hash = ((hash << 31) | (hash >> 33)) * kPrime1;
+    }
+
+    return hash;
+}
+
+// Lines of the same color (for example, the background of a document) match any other such line
+// and cannot be used to find the offset.
+bool isFlatLine(const uint32_t* pixels, int count)
+{
+    for (int i = 1; i < count; ++i)
+    {
+        if (pixels[i] != pixels[0])
+            return false;
+    }
+
+    return true;
+}
+
+uint32_t pixelAt(const Frame& frame, bool vertical, int line, int pos)
+{
+    uint32_t pixel;
+
+    if (vertical)
+        memcpy(&pixel, frame.frameDataAtPos(pos, line), sizeof(pixel));
+    else
+        memcpy(&pixel, frame.frameDataAtPos(line, pos), sizeof(pixel));
+
+    return pixel;
+}
+
+// Reads |count| pixels of |line| starting at position |from|.
+void readLine(const Frame& frame, bool vertical, int line, int from, int count, uint32_t* out)
+{
+    if (vertical)
+    {
+        memcpy(out, frame.frameDataAtPos(from, line), static_cast<size_t>(count) * sizeof(*out));
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        out[i] = pixelAt(frame, false, line, from + i);
+}
+
+} // namespace
+
+bool MoveDetector::detect(const Frame& prev_frame,
+                          const Frame& curr_frame,
+                          const Region& updated_region,
+                          Move* move)
+{
+    DCHECK(move);
+
+    if (prev_frame.size() != curr_frame.size())
+        return false;
+
+    if (prev_frame.format().bytesPerPixel() != 4 || curr_frame.format().bytesPerPixel() != 4)
+        return false;
+
+    // When a document is scrolled, the largest rectangle of the updated region is usually the
+    // scrolled area.
+    Rect largest_rect;
+    int64_t largest_area = 0;
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+        const int64_t area = static_cast<int64_t>(rect.width()) * rect.height();
+
+        if (area > largest_area)
+        {
+            largest_rect = rect;
+            largest_area = area;
+        }
+    }
+
+    largest_rect.intersectWith(Rect::makeSize(curr_frame.size()));
+
+    if (largest_rect.width() < kMinRectSize || largest_rect.height() < kMinRectSize)
+        return false;
+
+    return detectAlongAxis(prev_frame, curr_frame, largest_rect, true, move) ||
+           detectAlongAxis(prev_frame, curr_frame, largest_rect, false, move);
+}
+
+bool MoveDetector::detectAlongAxis(const Frame& prev_frame, const Frame& curr_frame,
+                                   const Rect& rect, bool vertical, Move* move)
+{
+    const int first_line = vertical ? rect.top() : rect.left();
+    const int line_count = vertical ? rect.height() : rect.width();
+    const int first_pos = vertical ? rect.left() : rect.top();
+    const int last_pos = vertical ? rect.right() : rect.bottom();
+
+    const int strip_length = std::min((last_pos - first_pos) / 2, kMaxStripLength);
+    if (strip_length < kMinStripLength)
+        return false;
+
+    const int strip_start = first_pos + (last_pos - first_pos - strip_length) / 2;
+
+    prev_line_.resize(static_cast<size_t>(strip_length));
+    curr_line_.resize(static_cast<size_t>(strip_length));
+    prev_hashes_.resize(static_cast<size_t>(line_count));
+    curr_hashes_.resize(static_cast<size_t>(line_count));
+    curr_is_flat_.assign(static_cast<size_t>(line_count), false);
+    prev_lines_.clear();
+    votes_.clear();
+
+    for (int i = 0; i < line_count; ++i)
+    {
+        readLine(prev_frame, vertical, first_line + i, strip_start, strip_length,
+                 prev_line_.data());
+        prev_hashes_[i] = hashLine(prev_line_.data(), strip_length);
+
+        if (!isFlatLine(prev_line_.data(), strip_length))
+        {
+            auto result = prev_lines_.emplace(prev_hashes_[i], i);
+
+            // A line that occurs several times cannot be used to find the offset.
+            if (!result.second)
+                result.first->second = -1;
+        }
+
+        readLine(curr_frame, vertical, first_line + i, strip_start, strip_length,
+                 curr_line_.data());
+        curr_hashes_[i] = hashLine(curr_line_.data(), strip_length);
+        curr_is_flat_[i] = isFlatLine(curr_line_.data(), strip_length);
+    }
+
+    // Every unique line of the current frame votes for the offset of its source line.
+    for (int i = 0; i < line_count; ++i)
+    {
+        if (curr_is_flat_[i])
+            continue;
+
+        auto result = prev_lines_.find(curr_hashes_[i]);
+        if (result == prev_lines_.end() || result->second == -1 || result->second == i)
+            continue;
+
+        ++votes_[result->second - i];
+    }
+
+    int offset = 0;
+    int offset_votes = 0;
+
+    for (const auto& vote : votes_)
+    {
+        if (vote.second > offset_votes)
+        {
+            offset = vote.first;
+            offset_votes = vote.second;
+        }
+    }
+
+    if (offset_votes < kMinVotes)
+        return false;
+
+    // Find the longest run of lines which are equal to the lines of the previous frame shifted by
+    // the offset.
+    const int begin = std::max(0, -offset);
+    const int end = std::min(line_count, line_count - offset);
+
+    int run_start = 0;
+    int run_length = 0;
+    int current_start = begin;
+
+    for (int i = begin; i <= end; ++i)
+    {
+        bool equal = false;
+
+        if (i < end && curr_hashes_[i] == prev_hashes_[i + offset])
+        {
+            readLine(prev_frame, vertical, first_line + i + offset, strip_start, strip_length,
+                     prev_line_.data());
+            readLine(curr_frame, vertical, first_line + i, strip_start, strip_length,
+                     curr_line_.data());
+
+            equal = prev_line_ == curr_line_;
+        }
+
+        if (!equal)
+        {
+            if (i - current_start > run_length)
+            {
+                run_start = current_start;
+                run_length = i - current_start;
+            }
+
+            current_start = i + 1;
+        }
+    }
+
+    if (run_length < kMinMoveLength)
+        return false;
+
+    // Extend the strip to both sides while the pixels of the run are equal.
+    auto is_pos_equal = [&](int pos)
+    {
+        for (int i = run_start; i < run_start + run_length; ++i)
+        {
+            if (pixelAt(curr_frame, vertical, first_line + i, pos) !=
+                pixelAt(prev_frame, vertical, first_line + i + offset, pos))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    int move_start = strip_start;
+    while (move_start > first_pos && is_pos_equal(move_start - 1))
+        --move_start;
+
+    int move_end = strip_start + strip_length;
+    while (move_end < last_pos && is_pos_equal(move_end))
+        ++move_end;
+
+    if (move_end - move_start < kMinMoveWidth)
+        return false;
+
+    Rect target_rect;
+
+    if (vertical)
+    {
+        target_rect = Rect::makeLTRB(move_start, first_line + run_start,
+                                     move_end, first_line + run_start + run_length);
+        move->source_rect = target_rect;
+        move->source_rect.translate(0, offset);
+    }
+    else
+    {
+        target_rect = Rect::makeLTRB(first_line + run_start, move_start,
+                                     first_line + run_start + run_length, move_end);
+        move->source_rect = target_rect;
+        move->source_rect.translate(offset, 0);
+    }
+
+    move->target_pos = target_rect.topLeft();
+    return true;
+}
+
+} // namespace base
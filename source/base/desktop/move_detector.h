@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_DESKTOP_MOVE_DETECTOR_H
+#define BASE_DESKTOP_MOVE_DETECTOR_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace base {
+
+class Frame;
+class Region;
+
+// Finds an area of the screen that was moved as a whole between two frames, for example when a
+// document is scrolled. Such an area can be sent as a copy of the pixels of the previous frame
+// instead of encoding it again.
+// Only vertical and horizontal moves inside the largest rectangle of the updated region are
+// detected.
+class MoveDetector
+{
+public:
+    MoveDetector() = default;
+    ~MoveDetector() = default;
+
+    struct Move
+    {
+        // Area of the previous frame that was moved.
+        Rect source_rect;
+
+        // Position of |source_rect| in the current frame.
+        Point target_pos;
+    };
+
+    // Returns true if the pixels at |move->target_pos| of |curr_frame| are the same as the pixels
+    // of |move->source_rect| of |prev_frame|. Both frames must have the same size and 32 bits per
+    // pixel.
+    bool detect(const Frame& prev_frame,
+                const Frame& curr_frame,
+                const Region& updated_region,
+                Move* move);
+
+private:
+    // If |vertical| is true, moves along the Y axis are detected and the lines are rows of pixels.
+    // Otherwise moves along the X axis are detected and the lines are columns.
+    bool detectAlongAxis(const Frame& prev_frame, const Frame& curr_frame, const Rect& rect,
+                         bool vertical, Move* move);
+
+    std::vector<uint32_t> prev_line_;
+    std::vector<uint32_t> curr_line_;
+    std::vector<uint64_t> prev_hashes_;
+    std::vector<uint64_t> curr_hashes_;
+    std::vector<bool> curr_is_flat_;
+    std::unordered_map<uint64_t, int> prev_lines_;
+    std::unordered_map<int, int> votes_;
+
+    DISALLOW_COPY_AND_ASSIGN(MoveDetector);
+};
+
+} // namespace base
+
+#endif // BASE_DESKTOP_MOVE_DETECTOR_H
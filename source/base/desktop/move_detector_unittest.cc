@@ -0,0 +1,134 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/move_detector.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(1280, 1024);
+
+void setPixel(Frame* frame, int x, int y, uint32_t pixel)
+{
+    memcpy(frame->frameDataAtPos(x, y), &pixel, sizeof(pixel));
+}
+
+// Fills |rect| of the frame with random pixels, which looks like a text document to the detector:
+// every line is unique.
+void fillRandom(Frame* frame, const Rect& rect, std::mt19937* engine)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        for (int x = rect.left(); x < rect.right(); ++x)
+            setPixel(frame, x, y, static_cast<uint32_t>((*engine)()));
+    }
+}
+
+class MoveDetectorTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        prev_ = FrameSimple::create(kFrameSize, PixelFormat::ARGB());
+        curr_ = FrameSimple::create(kFrameSize, PixelFormat::ARGB());
+
+        fillRandom(prev_.get(), Rect::makeSize(kFrameSize), &engine_);
+        curr_->copyPixelsFrom(*prev_, Point(0, 0), Rect::makeSize(kFrameSize));
+    }
+
+    std::mt19937 engine_ { 1 };
+    std::unique_ptr<Frame> prev_;
+    std::unique_ptr<Frame> curr_;
+    MoveDetector detector_;
+};
+
+} // namespace
+
+TEST_F(MoveDetectorTest, ScrollDown)
+{
+    // The document is scrolled down by 40 pixels: the content moves up and new lines appear at
+    // the bottom.
+    const Rect kDocumentRect = Rect::makeXYWH(100, 100, 800, 600);
+
+    curr_->movePixels(Rect::makeXYWH(100, 140, 800, 560), Point(100, 100));
+    fillRandom(curr_.get(), Rect::makeXYWH(100, 660, 800, 40), &engine_);
+
+    MoveDetector::Move move;
+    ASSERT_TRUE(detector_.detect(*prev_, *curr_, Region(kDocumentRect), &move));
+    EXPECT_EQ(move.source_rect, Rect::makeXYWH(100, 140, 800, 560));
+    EXPECT_EQ(move.target_pos, Point(100, 100));
+}
+
+TEST_F(MoveDetectorTest, ScrollUpWithScrollBar)
+{
+    const Rect kDocumentRect = Rect::makeXYWH(200, 50, 700, 800);
+
+    curr_->movePixels(Rect::makeXYWH(200, 50, 684, 720), Point(200, 130));
+    fillRandom(curr_.get(), Rect::makeXYWH(200, 50, 684, 80), &engine_);
+
+    // The scroll bar on the right side of the document changes differently.
+    fillRandom(curr_.get(), Rect::makeXYWH(884, 50, 16, 800), &engine_);
+
+    MoveDetector::Move move;
+    ASSERT_TRUE(detector_.detect(*prev_, *curr_, Region(kDocumentRect), &move));
+    EXPECT_EQ(move.source_rect, Rect::makeXYWH(200, 50, 684, 720));
+    EXPECT_EQ(move.target_pos, Point(200, 130));
+}
+
+TEST_F(MoveDetectorTest, ScrollRight)
+{
+    const Rect kDocumentRect = Rect::makeXYWH(0, 0, 1000, 500);
+
+    curr_->movePixels(Rect::makeXYWH(0, 0, 900, 500), Point(100, 0));
+    fillRandom(curr_.get(), Rect::makeXYWH(0, 0, 100, 500), &engine_);
+
+    MoveDetector::Move move;
+    ASSERT_TRUE(detector_.detect(*prev_, *curr_, Region(kDocumentRect), &move));
+    EXPECT_EQ(move.source_rect, Rect::makeXYWH(0, 0, 900, 500));
+    EXPECT_EQ(move.target_pos, Point(100, 0));
+}
+
+TEST_F(MoveDetectorTest, NoMove)
+{
+    const Rect kRect = Rect::makeXYWH(100, 100, 500, 500);
+
+    fillRandom(curr_.get(), kRect, &engine_);
+
+    MoveDetector::Move move;
+    EXPECT_FALSE(detector_.detect(*prev_, *curr_, Region(kRect), &move));
+}
+
+TEST_F(MoveDetectorTest, SmallArea)
+{
+    const Rect kRect = Rect::makeXYWH(100, 100, 500, 40);
+
+    curr_->movePixels(Rect::makeXYWH(100, 110, 500, 30), Point(100, 100));
+
+    MoveDetector::Move move;
+    EXPECT_FALSE(detector_.detect(*prev_, *curr_, Region(kRect), &move));
+}
+
+} // namespace base
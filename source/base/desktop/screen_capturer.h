@@ -83,6 +83,10 @@ public:
     virtual const MouseCursor* captureCursor() = 0;
     virtual Point cursorPosition() = 0;
 
+    // Returns the number of frame buffers the capturer uses in turn. The frame returned by
+    // captureFrame() is not changed by the next |frameQueueLength() - 1| captures.
+    virtual int frameQueueLength() const { return 1; }
+
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
     SharedMemoryFactory* sharedMemoryFactory() const;
 
@@ -111,11 +115,12 @@ protected:
         FrameType* currentFrame() const;
         FrameType* previousFrame() const;
 
+        static const int kQueueLength = 2;
+
     private:
         // Index of the current frame.
         int current_ = 0;
 
-        static const int kQueueLength = 2;
         std::unique_ptr<FrameType> frames_[kQueueLength];
 
         DISALLOW_COPY_AND_ASSIGN(FrameQueue);
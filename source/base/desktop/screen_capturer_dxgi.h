@@ -49,6 +49,7 @@ public:
     const Frame* captureFrame(Error* error) override;
     const MouseCursor* captureCursor() override;
     Point cursorPosition() override;
+    int frameQueueLength() const override { return FrameQueue<DxgiFrame>::kQueueLength; }
 
 protected:
     // ScreenCapturer implementation.
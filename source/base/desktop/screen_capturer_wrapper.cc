@@ -259,6 +259,14 @@ void ScreenCapturerWrapper::captureFrame()
     delegate_->onScreenCaptured(frame, mouse_cursor);
 }
 
+int ScreenCapturerWrapper::frameQueueLength() const
+{
+    if (!screen_capturer_)
+        return 1;
+
+    return screen_capturer_->frameQueueLength();
+}
+
 void ScreenCapturerWrapper::setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory)
 {
     shared_memory_factory_ = shared_memory_factory;
@@ -55,6 +55,7 @@ public:
 
     void selectScreen(ScreenCapturer::ScreenId screen_id, const Size& resolution);
     void captureFrame();
+    int frameQueueLength() const;
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
     void enableWallpaper(bool enable);
     void enableEffects(bool enable);
@@ -56,6 +56,7 @@ public:
     const Frame* captureFrame(Error* error) override;
     const MouseCursor* captureCursor() override;
     Point cursorPosition() override;
+    int frameQueueLength() const override { return FrameQueue<Frame>::kQueueLength; }
 
 protected:
     // ScreenCapturer implementation.
@@ -0,0 +1,105 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/log_queue.h"
+
+namespace base {
+
+LogQueue::LogQueue()
+    : head_(&stub_),
+      tail_(&stub_)
+{
+    // Nothing
+}
+
+LogQueue::~LogQueue()
+{
+    Entry entry;
+    while (pop(&entry))
+    {
+        // Nothing
+    }
+}
+
+uint64_t LogQueue::push(LoggingSeverity severity, std::string&& message)
+{
+    Node* node = new Node();
+    node->entry.severity = severity;
+    node->entry.message = std::move(message);
+
+    // The counter is incremented before the node becomes visible so that size() never underflows.
+    uint64_t sequence_number = pushed_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    pushNode(node);
+    return sequence_number;
+}
+
+bool LogQueue::pop(Entry* entry)
+{
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_)
+    {
+        if (!next)
+            return false;
+
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (!next)
+    {
+        if (tail != head_.load(std::memory_order_acquire))
+        {
+            // The producer has already replaced the head, but has not yet linked the node.
+            return false;
+        }
+
+        // The last node can only be extracted if there is another one after it.
+        pushNode(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+    }
+
+    tail_ = next;
+    *entry = std::move(tail->entry);
+    delete tail;
+
+    popped_.fetch_add(1, std::memory_order_seq_cst);
+    return true;
+}
+
+size_t LogQueue::size() const
+{
+    // The number of extracted messages is read first. It can never exceed the number of added
+    // messages read after it.
+    uint64_t popped = popped_.load(std::memory_order_seq_cst);
+    uint64_t pushed = pushed_.load(std::memory_order_seq_cst);
+    return static_cast<size_t>(pushed - popped);
+}
+
+void LogQueue::pushNode(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+} // namespace base
@@ -0,0 +1,74 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_LOG_QUEUE_H
+#define BASE_LOG_QUEUE_H
+
+#include "base/logging.h"
+
+#include <atomic>
+
+namespace base {
+
+// Lock-free multiple-producer single-consumer queue of log messages (intrusive queue by Dmitry
+// Vyukov). Method push() can be called from any thread, method pop() only from one thread at a
+// time.
+class LogQueue
+{
+public:
+    struct Entry
+    {
+        LoggingSeverity severity = LOG_LS_INFO;
+        std::string message;
+    };
+
+    LogQueue();
+    ~LogQueue();
+
+    // Adds a message to the queue. Returns the sequence number of the message (starts from 1).
+    uint64_t push(LoggingSeverity severity, std::string&& message);
+
+    // Extracts the oldest message from the queue. Returns false if the queue is empty or if the
+    // next message is still being added by a producer.
+    bool pop(Entry* entry);
+
+    // Number of messages that were added to the queue but have not yet been extracted.
+    size_t size() const;
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next { nullptr };
+        Entry entry;
+    };
+
+    void pushNode(Node* node);
+
+    std::atomic<Node*> head_;
+    Node* tail_;
+    Node stub_;
+
+    std::atomic<uint64_t> pushed_ { 0 };
+    std::atomic<uint64_t> popped_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(LogQueue);
+};
+
+} // namespace base
+
+#endif // BASE_LOG_QUEUE_H
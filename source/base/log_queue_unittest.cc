@@ -0,0 +1,284 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/log_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const size_t kThreadCount = 8;
+
+std::string makeMessage(size_t thread_index, size_t message_index)
+{
+    return std::to_string(thread_index) + ':' + std::to_string(message_index);
+}
+
+// Parses the message created by makeMessage().
+void parseMessage(const std::string& message, size_t* thread_index, size_t* message_index)
+{
+    size_t pos = message.find(':');
+    ASSERT_NE(pos, std::string::npos);
+
+    *thread_index = std::stoul(message.substr(0, pos));
+    *message_index = std::stoul(message.substr(pos + 1));
+}
+
+// Messages are pushed from |kThreadCount| threads and popped from the calling thread.
+std::chrono::milliseconds runLogQueue(size_t message_count)
+{
+    LogQueue queue;
+    std::vector<std::thread> threads;
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back([&queue, i, message_count]()
+        {
+            for (size_t j = 0; j < message_count; ++j)
+                queue.push(LOG_LS_INFO, makeMessage(i, j));
+        });
+    }
+
+    LogQueue::Entry entry;
+    size_t popped = 0;
+
+    while (popped < kThreadCount * message_count)
+    {
+        if (queue.pop(&entry))
+            ++popped;
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+}
+
+// Same as runLogQueue(), but the queue is protected by a mutex.
+std::chrono::milliseconds runLockedQueue(size_t message_count)
+{
+    std::mutex lock;
+    std::deque<std::string> queue;
+    std::vector<std::thread> threads;
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back([&lock, &queue, i, message_count]()
+        {
+            for (size_t j = 0; j < message_count; ++j)
+            {
+                std::string message = makeMessage(i, j);
+
+                std::scoped_lock scoped_lock(lock);
+                queue.emplace_back(std::move(message));
+            }
+        });
+    }
+
+    size_t popped = 0;
+
+    while (popped < kThreadCount * message_count)
+    {
+        std::scoped_lock scoped_lock(lock);
+        while (!queue.empty())
+        {
+            queue.pop_front();
+            ++popped;
+        }
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+}
+
+} // namespace
+
+TEST(log_queue_test, empty)
+{
+    LogQueue queue;
+    LogQueue::Entry entry;
+
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_FALSE(queue.pop(&entry));
+}
+
+TEST(log_queue_test, single_thread)
+{
+    LogQueue queue;
+
+    EXPECT_EQ(queue.push(LOG_LS_INFO, "first"), 1u);
+    EXPECT_EQ(queue.push(LOG_LS_ERROR, "second"), 2u);
+    EXPECT_EQ(queue.size(), 2u);
+
+    LogQueue::Entry entry;
+
+    ASSERT_TRUE(queue.pop(&entry));
+    EXPECT_EQ(entry.severity, LOG_LS_INFO);
+    EXPECT_EQ(entry.message, "first");
+
+    // The last message is extracted too.
+    ASSERT_TRUE(queue.pop(&entry));
+    EXPECT_EQ(entry.severity, LOG_LS_ERROR);
+    EXPECT_EQ(entry.message, "second");
+
+    EXPECT_FALSE(queue.pop(&entry));
+    EXPECT_EQ(queue.size(), 0u);
+
+    // The queue can be used after it has been emptied.
+    queue.push(LOG_LS_WARNING, "third");
+    ASSERT_TRUE(queue.pop(&entry));
+    EXPECT_EQ(entry.message, "third");
+    EXPECT_FALSE(queue.pop(&entry));
+}
+
+TEST(log_queue_test, messages_left_in_queue)
+{
+    LogQueue queue;
+
+    for (int i = 0; i < 100; ++i)
+        queue.push(LOG_LS_INFO, "message");
+
+    // Remaining messages are released in the destructor.
+    EXPECT_EQ(queue.size(), 100u);
+}
+
+TEST(log_queue_test, multiple_producers)
+{
+    static const size_t kMessageCount = 10000;
+
+    LogQueue queue;
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back([&queue, i]()
+        {
+            for (size_t j = 0; j < kMessageCount; ++j)
+                queue.push(LOG_LS_INFO, makeMessage(i, j));
+        });
+    }
+
+    // Messages of each thread must be extracted in the order in which they were added.
+    std::vector<size_t> next_index(kThreadCount, 0);
+    LogQueue::Entry entry;
+    size_t popped = 0;
+
+    while (popped < kThreadCount * kMessageCount)
+    {
+        if (!queue.pop(&entry))
+            continue;
+
+        size_t thread_index;
+        size_t message_index;
+        parseMessage(entry.message, &thread_index, &message_index);
+
+        ASSERT_LT(thread_index, kThreadCount);
+        ASSERT_EQ(message_index, next_index[thread_index]);
+
+        ++next_index[thread_index];
+        ++popped;
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_FALSE(queue.pop(&entry));
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(log_queue_test, DISABLED_benchmark_contention)
+{
+    static const size_t kMessageCount = 200000;
+
+    std::chrono::milliseconds lock_free_time = runLogQueue(kMessageCount);
+    std::chrono::milliseconds locked_time = runLockedQueue(kMessageCount);
+
+    RecordProperty("threads", static_cast<int>(kThreadCount));
+    RecordProperty("messages_per_thread", static_cast<int>(kMessageCount));
+    RecordProperty("lock_free_queue_ms", static_cast<int>(lock_free_time.count()));
+    RecordProperty("locked_queue_ms", static_cast<int>(locked_time.count()));
+}
+
+TEST(log_queue_test, DISABLED_benchmark_logging)
+{
+    static const size_t kMessageCount = 100000;
+
+    std::filesystem::path log_dir = std::filesystem::temp_directory_path();
+    log_dir.append("aspia_log_queue_test");
+
+    LoggingSettings settings;
+    settings.destination = LOG_TO_FILE;
+    settings.min_log_level = LOG_LS_INFO;
+    settings.log_dir = log_dir;
+    settings.max_log_file_age = 0;
+
+    ASSERT_TRUE(initLogging(settings));
+
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back([i]()
+        {
+            for (size_t j = 0; j < kMessageCount; ++j)
+                LOG(LS_INFO) << "Benchmark message " << j << " from thread " << i;
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::chrono::milliseconds logging_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+
+    // Waits until all messages are written.
+    shutdownLogging();
+
+    std::chrono::milliseconds total_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+
+    RecordProperty("threads", static_cast<int>(kThreadCount));
+    RecordProperty("messages_per_thread", static_cast<int>(kMessageCount));
+    RecordProperty("logged_ms", static_cast<int>(logging_time.count()));
+    RecordProperty("written_ms", static_cast<int>(total_time.count()));
+
+    std::error_code ignored_code;
+    std::filesystem::remove_all(log_dir, ignored_code);
+
+    initLogging();
+}
+
+} // namespace base
@@ -21,10 +21,12 @@
 #include "base/debug.h"
 #include "base/endian_util.h"
 #include "base/environment.h"
+#include "base/log_queue.h"
 #include "base/system_time.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/unicode.h"
 
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
 #include <mutex>
@@ -48,11 +50,25 @@
 
 namespace base {
 
+std::string logFilePrefix();
+
 namespace {
 
 const size_t kDefaultMaxLogFileSize = 2 * 1024 * 1024; // 2 Mb.
 const size_t kDefaultMaxLogFileAge = 14; // 14 days.
 
+// Interval after which the background writer writes and flushes the accumulated messages.
+constexpr std::chrono::milliseconds kFlushInterval { 100 };
+
+// Number of pending messages after which the background writer is woken up before the interval.
+const size_t kMaxPendingMessages = 512;
+
+// Maximum number of messages written by the background writer between two flushes.
+const size_t kMaxBatchSize = 4096;
+
+// Maximum time a FATAL message waits for pending messages to be written.
+constexpr std::chrono::seconds kFatalFlushTimeout { 2 };
+
 LoggingSeverity g_min_log_level = LOG_LS_WARNING;
 LoggingDestination g_logging_destination = LOG_DEFAULT;
 
@@ -170,6 +186,288 @@ bool initLoggingUnlocked(const std::string& prefix)
     return true;
 }
 
+void writeToStderr(const std::string& text)
+{
+    if (text.empty())
+        return;
+
+    fwrite(text.data(), text.size(), 1, stderr);
+    fflush(stderr);
+}
+
+// Adds |message| to the stderr buffer if needed and writes it to the log file without flushing.
+// |g_log_file_lock| must be locked when the output to the file is enabled.
+void writeMessageUnlocked(LoggingSeverity severity,
+                          const std::string& message,
+                          std::string* stderr_buffer)
+{
+    if ((g_logging_destination & LOG_TO_STDOUT) != 0)
+    {
+        debugPrint(message.data());
+        stderr_buffer->append(message);
+    }
+    else if (severity >= LOG_LS_ERROR)
+    {
+        // When we're only outputting to a log file, above a certain log level, we
+        // should still output to stderr so that we can better detect and diagnose
+        // problems with unit tests, especially on the buildbots.
+        stderr_buffer->append(message);
+    }
+
+    // Write to log file.
+    if ((g_logging_destination & LOG_TO_FILE) != 0)
+    {
+        if (g_log_file.tellp() >= g_max_log_file_size)
+        {
+            // The maximum size of the log file has been exceeded. Close the current log file and
+            // create a new one.
+            initLoggingUnlocked(logFilePrefix());
+        }
+
+        g_log_file.write(message.c_str(), message.size());
+    }
+}
+
+// Writes the messages to stderr and the log file on a background thread. Messages are passed
+// through a lock-free queue and written in batches with one flush per batch. The batch is written
+// every |kFlushInterval|, when |kMaxPendingMessages| accumulate or immediately for ERROR and
+// FATAL messages.
+class LogWriter
+{
+public:
+    LogWriter() = default;
+    ~LogWriter() { stop(); }
+
+    void start();
+    void stop();
+
+    // Adds the message to the queue. Can be called from any thread. Returns false if the message
+    // must be written synchronously: the writer is not running or the method is called from the
+    // writer thread. In this case |message| is not changed.
+    bool write(LoggingSeverity severity, std::string& message);
+
+    // Waits until all messages added before the call are written. Used before the process is
+    // crashed by a FATAL message.
+    void flush();
+
+private:
+    void run();
+    void wakeUp();
+    bool isWriterThread() const;
+
+    // Writes pending messages. Returns true if the queue was empty at the end of the batch.
+    bool writeBatch();
+
+    LogQueue queue_;
+
+    std::mutex control_lock_;
+    std::thread thread_;
+    std::atomic<std::thread::id> thread_id_;
+    std::atomic_bool running_ { false };
+    std::atomic_bool wakeup_requested_ { false };
+
+    // Number of threads that are adding a message to the queue right now.
+    std::atomic<int> writing_count_ { 0 };
+
+    std::mutex lock_;
+    std::condition_variable wakeup_event_;
+    std::condition_variable flushed_event_;
+    bool stop_requested_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flushed_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(LogWriter);
+};
+
+void LogWriter::start()
+{
+    std::scoped_lock control_lock(control_lock_);
+
+    if (thread_.joinable())
+        return;
+
+    {
+        std::scoped_lock lock(lock_);
+        stop_requested_ = false;
+    }
+
+    thread_ = std::thread(&LogWriter::run, this);
+    thread_id_.store(thread_.get_id());
+    running_.store(true);
+}
+
+void LogWriter::stop()
+{
+    std::scoped_lock control_lock(control_lock_);
+
+    if (!thread_.joinable())
+        return;
+
+    // New messages are written synchronously from now on.
+    running_.store(false);
+
+    // Wait for the threads that saw the writer running to finish adding their messages. Both
+    // this and write() use sequentially consistent operations, so either the writer sees the
+    // message or the producer sees that the writer is stopped.
+    while (writing_count_.load() != 0)
+        std::this_thread::yield();
+
+    {
+        std::scoped_lock lock(lock_);
+        stop_requested_ = true;
+    }
+
+    // Threads waiting for a flush must not wait for the stopped writer.
+    wakeup_event_.notify_one();
+    flushed_event_.notify_all();
+
+    thread_.join();
+    thread_id_.store(std::thread::id());
+
+    // Write messages that were added while the thread was stopping.
+    while (!writeBatch())
+    {
+        // Nothing
+    }
+}
+
+bool LogWriter::write(LoggingSeverity severity, std::string& message)
+{
+    writing_count_.fetch_add(1);
+
+    if (!running_.load() || isWriterThread())
+    {
+        writing_count_.fetch_sub(1);
+        return false;
+    }
+
+    queue_.push(severity, std::move(message));
+    writing_count_.fetch_sub(1);
+
+    if (severity >= LOG_LS_ERROR || queue_.size() >= kMaxPendingMessages)
+        wakeUp();
+
+    return true;
+}
+
+void LogWriter::flush()
+{
+    if (!running_.load() || isWriterThread())
+        return;
+
+    std::unique_lock lock(lock_);
+
+    // The batch started after this request drains the queue including all previous messages.
+    uint64_t flush_request = ++flush_requested_;
+    wakeup_event_.notify_one();
+
+    flushed_event_.wait_for(lock, kFatalFlushTimeout, [&]()
+    {
+        return flushed_ >= flush_request || stop_requested_;
+    });
+}
+
+bool LogWriter::isWriterThread() const
+{
+    return thread_id_.load() == std::this_thread::get_id();
+}
+
+void LogWriter::run()
+{
+    bool drained = true;
+
+    for (;;)
+    {
+        uint64_t flush_request;
+        bool stop_requested;
+
+        {
+            std::unique_lock lock(lock_);
+
+            if (drained)
+            {
+                wakeup_event_.wait_for(lock, kFlushInterval, [this]()
+                {
+                    return stop_requested_ || flush_requested_ != flushed_ ||
+                           wakeup_requested_.load(std::memory_order_relaxed);
+                });
+            }
+
+            wakeup_requested_.store(false, std::memory_order_relaxed);
+            flush_request = flush_requested_;
+            stop_requested = stop_requested_;
+        }
+
+        drained = writeBatch();
+
+        if (drained)
+        {
+            {
+                std::scoped_lock lock(lock_);
+                flushed_ = flush_request;
+            }
+
+            flushed_event_.notify_all();
+        }
+
+        if (stop_requested && drained)
+            break;
+    }
+}
+
+void LogWriter::wakeUp()
+{
+    if (wakeup_requested_.exchange(true, std::memory_order_relaxed))
+        return;
+
+    // Locking guarantees that the notification is not lost between the predicate check and the
+    // wait in the writer thread.
+    std::scoped_lock lock(lock_);
+    wakeup_event_.notify_one();
+}
+
+bool LogWriter::writeBatch()
+{
+    if (queue_.size() == 0)
+        return true;
+
+    std::string stderr_buffer;
+    LogQueue::Entry entry;
+    bool drained = false;
+
+    {
+        std::scoped_lock lock(g_log_file_lock);
+
+        for (size_t count = 0; count < kMaxBatchSize;)
+        {
+            if (!queue_.pop(&entry))
+            {
+                if (queue_.size() == 0)
+                {
+                    drained = true;
+                    break;
+                }
+
+                // The producer has not yet finished adding the message.
+                std::this_thread::yield();
+                continue;
+            }
+
+            writeMessageUnlocked(entry.severity, entry.message, &stderr_buffer);
+            ++count;
+        }
+
+        if ((g_logging_destination & LOG_TO_FILE) != 0)
+            g_log_file.flush();
+    }
+
+    writeToStderr(stderr_buffer);
+    return drained;
+}
+
+// Destroyed before |g_log_file|, so the thread is stopped while the file is still valid.
+LogWriter g_log_writer;
+
 } // namespace
 
 // This is never instantiated, it's just used for EAT_STREAM_PARAMETERS to have
@@ -299,6 +597,8 @@ bool initLogging(const LoggingSettings& settings)
             return false;
     }
 
+    g_log_writer.start();
+
     LOG(LS_INFO) << "Executable file: " << execFilePath();
     if (g_logging_destination & LOG_TO_FILE)
     {
@@ -323,6 +623,9 @@ void shutdownLogging()
 {
     LOG(LS_INFO) << "Logging finished";
 
+    // Write all pending messages before closing the file.
+    g_log_writer.stop();
+
     std::scoped_lock lock(g_log_file_lock);
     g_log_file.close();
 }
@@ -428,36 +731,26 @@ LogMessage::~LogMessage()
 
     std::string message(stream_.str());
 
-    if ((g_logging_destination & LOG_TO_STDOUT) != 0)
-    {
-        debugPrint(message.data());
-
-        fwrite(message.data(), message.size(), 1, stderr);
-        fflush(stderr);
-    }
-    else if (severity_ >= LOG_LS_ERROR)
-    {
-        // When we're only outputting to a log file, above a certain log level, we
-        // should still output to stderr so that we can better detect and diagnose
-        // problems with unit tests, especially on the buildbots.
-        fwrite(message.data(), message.size(), 1, stderr);
-        fflush(stderr);
-    }
+    // A FATAL message is written synchronously after the pending messages, because the process
+    // is crashed right after it.
+    if (severity_ == LOG_LS_FATAL)
+        g_log_writer.flush();
 
-    // Write to log file.
-    if ((g_logging_destination & LOG_TO_FILE) != 0)
+    if (severity_ == LOG_LS_FATAL || !g_log_writer.write(severity_, message))
     {
-        std::scoped_lock lock(g_log_file_lock);
+        // Logging is not initialized or already finished, or the message is logged from the
+        // writer thread. Write the message synchronously.
+        std::string stderr_buffer;
 
-        if (g_log_file.tellp() >= g_max_log_file_size)
         {
-            // The maximum size of the log file has been exceeded. Close the current log file and
-            // create a new one.
-            initLoggingUnlocked(logFilePrefix());
+            std::scoped_lock lock(g_log_file_lock);
+
+            writeMessageUnlocked(severity_, message, &stderr_buffer);
+            if ((g_logging_destination & LOG_TO_FILE) != 0)
+                g_log_file.flush();
         }
 
-        g_log_file.write(message.c_str(), message.size());
-        g_log_file.flush();
+        writeToStderr(stderr_buffer);
     }
 
     if (severity_ == LOG_LS_FATAL)
@@ -0,0 +1,101 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/bandwidth_estimator.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Queueing delay at which the channel is considered to be free.
+const BandwidthEstimator::Milliseconds kLowQueueDelay { 50 };
+
+// Queueing delay at which the channel is considered to be overloaded regardless of its trend.
+const BandwidthEstimator::Milliseconds kHighQueueDelay { 300 };
+
+// Growth of the queueing delay between intervals which means that the queue is building up.
+const BandwidthEstimator::Milliseconds kDelayGrowth { 20 };
+
+// If there were no writes for this time, the interval is not used for the estimation.
+const BandwidthEstimator::Milliseconds kMaxInterval { 5000 };
+
+} // namespace
+
+// static
+const BandwidthEstimator::Milliseconds BandwidthEstimator::kInterval { 500 };
+
+BandwidthEstimator::BandwidthEstimator() = default;
+
+BandwidthEstimator::~BandwidthEstimator() = default;
+
+void BandwidthEstimator::onBytesWritten(
+    size_t bytes, const Milliseconds& queue_delay, const TimePoint& now)
+{
+    if (interval_start_ == TimePoint())
+        interval_start_ = now;
+
+    interval_bytes_ += static_cast<int64_t>(bytes);
+    interval_delay_ = std::max(interval_delay_, queue_delay);
+
+    const Milliseconds elapsed = std::chrono::duration_cast<Milliseconds>(now - interval_start_);
+    if (elapsed < kInterval)
+        return;
+
+    if (elapsed <= kMaxInterval || interval_delay_ >= kHighQueueDelay)
+        updateEstimate(elapsed);
+
+    interval_start_ = now;
+    interval_bytes_ = 0;
+    last_delay_ = interval_delay_;
+    interval_delay_ = Milliseconds::zero();
+}
+
+void BandwidthEstimator::updateEstimate(const Milliseconds& elapsed)
+{
+    const int64_t delivered = interval_bytes_ * 1000 / elapsed.count();
+    int64_t bandwidth = bandwidth_;
+
+    if (interval_delay_ >= kHighQueueDelay ||
+        (interval_delay_ >= kLowQueueDelay && interval_delay_ >= last_delay_ + kDelayGrowth))
+    {
+        // The messages are waiting in the queue: the sender produces more data than the channel
+        // delivers. Go below the delivered rate to drain the queue. A single interval may include
+        // a pause of the sender, so the estimate is reduced at most by half at a time.
+        bandwidth = std::max(delivered, bandwidth_ / 2) * 85 / 100;
+        is_measured_ = true;
+    }
+    else if (interval_delay_ < kLowQueueDelay && delivered * 2 >= bandwidth_)
+    {
+        // The channel is used and there is no queue. Probe for a higher bandwidth.
+        bandwidth = bandwidth_ * 108 / 100;
+    }
+
+    bandwidth = std::clamp(bandwidth, kMinBandwidth, kMaxBandwidth);
+    if (bandwidth == bandwidth_)
+        return;
+
+    DLOG(LS_INFO) << "Bandwidth: " << bandwidth_ << " to " << bandwidth << " (delivered: "
+                  << delivered << ", delay: " << interval_delay_.count() << "ms)";
+    bandwidth_ = bandwidth;
+}
+
+} // namespace base
@@ -0,0 +1,80 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_NET_BANDWIDTH_ESTIMATOR_H
+#define BASE_NET_BANDWIDTH_ESTIMATOR_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace base {
+
+// Estimates the bandwidth of the outgoing direction of a channel from the completions of socket
+// writes. Every interval the amount of the delivered data is compared with the time that the
+// messages spent in the send queue:
+// - if the queueing delay is high or grows, the estimate is reduced below the delivered rate;
+// - if there is no queue and the channel is actually used, the estimate is slowly increased;
+// - otherwise (the sender has nothing to send) the estimate is kept.
+class BandwidthEstimator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using Milliseconds = std::chrono::milliseconds;
+
+    // All values are in bytes per second.
+    static constexpr int64_t kInitialBandwidth = 1000 * 1000 / 8; // 1 Mbit/s.
+    static constexpr int64_t kMinBandwidth = 128 * 1000 / 8; // 128 kbit/s.
+    static constexpr int64_t kMaxBandwidth = 1000 * 1000 * 1000 / 8; // 1 Gbit/s.
+
+    static const Milliseconds kInterval;
+
+    BandwidthEstimator();
+    ~BandwidthEstimator();
+
+    // Must be called when the socket has accepted |bytes| of data. |queue_delay| is the time that
+    // the oldest of the written messages spent from its addition to the queue until now.
+    void onBytesWritten(size_t bytes, const Milliseconds& queue_delay, const TimePoint& now);
+
+    // Returns the current estimate in bytes per second.
+    int64_t bandwidth() const { return bandwidth_; }
+
+    // Returns true if the estimate has been reduced because of a queue at least once. Until then
+    // the estimate is only a lower bound of the bandwidth (the initial value or what the sender
+    // has actually used) and must not be taken as a limit.
+    bool isMeasured() const { return is_measured_; }
+
+private:
+    void updateEstimate(const Milliseconds& elapsed);
+
+    int64_t bandwidth_ = kInitialBandwidth;
+    bool is_measured_ = false;
+
+    TimePoint interval_start_;
+    int64_t interval_bytes_ = 0;
+    Milliseconds interval_delay_ { 0 };
+    Milliseconds last_delay_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(BandwidthEstimator);
+};
+
+} // namespace base
+
+#endif // BASE_NET_BANDWIDTH_ESTIMATOR_H
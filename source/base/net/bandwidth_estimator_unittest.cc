@@ -0,0 +1,140 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/bandwidth_estimator.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+using Milliseconds = BandwidthEstimator::Milliseconds;
+
+// Simulates a sender which writes |rate| bytes per second in 50 ms steps during |duration|.
+BandwidthEstimator::TimePoint simulate(BandwidthEstimator* estimator,
+                                       BandwidthEstimator::TimePoint now,
+                                       int64_t rate,
+                                       const Milliseconds& queue_delay,
+                                       const Milliseconds& duration)
+{
+    const Milliseconds kStep(50);
+
+    for (Milliseconds time(0); time < duration; time += kStep)
+    {
+        now += kStep;
+        estimator->onBytesWritten(
+            static_cast<size_t>(rate * kStep.count() / 1000), queue_delay, now);
+    }
+
+    return now;
+}
+
+} // namespace
+
+TEST(BandwidthEstimatorTest, Initial)
+{
+    BandwidthEstimator estimator;
+    EXPECT_EQ(estimator.bandwidth(), BandwidthEstimator::kInitialBandwidth);
+    EXPECT_FALSE(estimator.isMeasured());
+}
+
+TEST(BandwidthEstimatorTest, GrowsWhenChannelIsFree)
+{
+    BandwidthEstimator estimator;
+    BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+
+    // The sender always uses the whole estimate and there is no queue.
+    for (int i = 0; i < 20; ++i)
+    {
+        now = simulate(&estimator, now, estimator.bandwidth(), Milliseconds(5),
+                       BandwidthEstimator::kInterval);
+    }
+
+    EXPECT_GT(estimator.bandwidth(), BandwidthEstimator::kInitialBandwidth * 3);
+    EXPECT_FALSE(estimator.isMeasured());
+}
+
+TEST(BandwidthEstimatorTest, KeptWhenSenderIsIdle)
+{
+    BandwidthEstimator estimator;
+    BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+
+    // The sender writes much less than the estimate.
+    now = simulate(&estimator, now, BandwidthEstimator::kInitialBandwidth / 10, Milliseconds(1),
+                   Milliseconds(10000));
+
+    EXPECT_EQ(estimator.bandwidth(), BandwidthEstimator::kInitialBandwidth);
+    EXPECT_FALSE(estimator.isMeasured());
+}
+
+TEST(BandwidthEstimatorTest, DropsOnQueueingDelay)
+{
+    BandwidthEstimator estimator;
+    BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+
+    // The channel delivers only 40 KB/s and the messages wait in the queue.
+    const int64_t kDelivered = 40000;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        now = simulate(&estimator, now, kDelivered, Milliseconds(400),
+                       BandwidthEstimator::kInterval);
+    }
+
+    EXPECT_LT(estimator.bandwidth(), kDelivered);
+    EXPECT_GE(estimator.bandwidth(), BandwidthEstimator::kMinBandwidth);
+    EXPECT_TRUE(estimator.isMeasured());
+}
+
+TEST(BandwidthEstimatorTest, DropsOnDelayGrowth)
+{
+    BandwidthEstimator estimator;
+    BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+
+    const int64_t kDelivered = BandwidthEstimator::kInitialBandwidth * 3 / 4;
+
+    now = simulate(&estimator, now, kDelivered, Milliseconds(60), BandwidthEstimator::kInterval);
+    const int64_t bandwidth = estimator.bandwidth();
+
+    now = simulate(&estimator, now, kDelivered, Milliseconds(100), BandwidthEstimator::kInterval);
+    EXPECT_LT(estimator.bandwidth(), bandwidth);
+}
+
+TEST(BandwidthEstimatorTest, Limits)
+{
+    BandwidthEstimator estimator;
+    BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+
+    for (int i = 0; i < 50; ++i)
+    {
+        now = simulate(&estimator, now, 0, Milliseconds(1000), BandwidthEstimator::kInterval);
+    }
+
+    EXPECT_EQ(estimator.bandwidth(), BandwidthEstimator::kMinBandwidth);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        now = simulate(&estimator, now, estimator.bandwidth(), Milliseconds(0),
+                       BandwidthEstimator::kInterval);
+    }
+
+    EXPECT_EQ(estimator.bandwidth(), BandwidthEstimator::kMaxBandwidth);
+}
+
+} // namespace base
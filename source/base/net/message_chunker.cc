@@ -0,0 +1,187 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "base/net/message_chunker.h"
+
+#include "base/logging.h"
+#include "base/net/network_channel.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// The lower bits of the flags contain the priority of the message, the upper bit is set for all
+// chunks of a message except the last one.
+const uint8_t kChunkPriorityMask = 0x03;
+const uint8_t kChunkMoreFlag = 0x80;
+
+} // namespace
+
+MessageChunker::MessageChunker() = default;
+
+MessageChunker::~MessageChunker() = default;
+
+void MessageChunker::add(WriteTask&& task)
+{
+    const size_t priority = static_cast<size_t>(task.priority());
+    DCHECK_LT(priority, WriteTask::kPriorityCount);
+
+    // Elements of std::deque are not moved on insertion at the end, so the pieces of the current
+    // batch remain valid.
+    queue_[priority].emplace_back(std::move(task));
+}
+
+size_t MessageChunker::pendingMessages() const
+{
+    size_t count = 0;
+
+    for (const auto& queue : queue_)
+        count += queue.size();
+
+    return count;
+}
+
+size_t MessageChunker::prepareBatch(
+    size_t max_count, size_t max_size, const FrameSizeCallback& frame_size)
+{
+    DCHECK(batch_.empty());
+
+    size_t total_size = 0;
+    batch_time_ = WriteTask::TimePoint::max();
+
+    for (size_t i = 0; i < WriteTask::kPriorityCount; ++i)
+    {
+        size_t offset = offset_[i];
+
+        for (const auto& task : queue_[i])
+        {
+            if (task.data().empty())
+                return 0;
+
+            do
+            {
+                Piece piece = { &task, offset, task.data().size() - offset, true };
+
+                if (chunk_size_ && task.type() == WriteTask::Type::USER_DATA &&
+                    piece.size > chunk_size_)
+                {
+                    piece.size = chunk_size_;
+                    piece.last = false;
+                }
+
+                const size_t piece_frame_size = frame_size(task, piece.size);
+                if (!piece_frame_size)
+                    return 0;
+
+                if (!batch_.empty() &&
+                    (batch_.size() >= max_count || total_size + piece_frame_size > max_size))
+                {
+                    return total_size;
+                }
+
+                total_size += piece_frame_size;
+                offset += piece.size;
+                batch_.emplace_back(piece);
+                batch_time_ = std::min(batch_time_, task.time());
+            }
+            while (!batch_.back().last);
+
+            offset = 0;
+        }
+    }
+
+    return total_size;
+}
+
+void MessageChunker::completeBatch(std::vector<uint8_t>* written_channels)
+{
+    for (const auto& piece : batch_)
+    {
+        const size_t priority = static_cast<size_t>(piece.task->priority());
+
+        if (!piece.last)
+        {
+            offset_[priority] += piece.size;
+            continue;
+        }
+
+        std::deque<WriteTask>& queue = queue_[priority];
+        DCHECK_EQ(&queue.front(), piece.task);
+
+        if (piece.task->type() == WriteTask::Type::USER_DATA)
+            written_channels->emplace_back(piece.task->channelId());
+
+        queue.pop_front();
+        offset_[priority] = 0;
+    }
+
+    batch_.clear();
+}
+
+// static
+uint8_t MessageChunker::chunkFlags(const Piece& piece)
+{
+    uint8_t flags = static_cast<uint8_t>(piece.task->priority());
+    if (!piece.last)
+        flags |= kChunkMoreFlag;
+
+    return flags;
+}
+
+MessageAssembler::MessageAssembler() = default;
+
+MessageAssembler::~MessageAssembler() = default;
+
+MessageAssembler::Status MessageAssembler::add(uint8_t flags, uint8_t channel_id, ByteArray* data)
+{
+    const size_t priority = flags & kChunkPriorityMask;
+    if (priority >= WriteTask::kPriorityCount)
+        return Status::INVALID;
+
+    ByteArray& buffer = buffer_[priority];
+
+    // The message is not split into chunks.
+    if (!(flags & kChunkMoreFlag) && buffer.empty())
+        return Status::COMPLETE;
+
+    // Chunks of one message have the same priority and channel id.
+    if (!buffer.empty() && channel_id_[priority] != channel_id)
+        return Status::INVALID;
+
+    if (buffer.size() + data->size() > NetworkChannel::kMaxMessageSize)
+    {
+        LOG(LS_ERROR) << "Too big chunked message";
+        return Status::INVALID;
+    }
+
+    channel_id_[priority] = channel_id;
+    buffer.insert(buffer.end(), data->begin(), data->end());
+
+    if (flags & kChunkMoreFlag)
+        return Status::INCOMPLETE;
+
+    // The last chunk of the message is received.
+    data->swap(buffer);
+    buffer.clear();
+    return Status::COMPLETE;
+}
+
+} // namespace base
@@ -0,0 +1,129 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#ifndef BASE_NET_MESSAGE_CHUNKER_H
+#define BASE_NET_MESSAGE_CHUNKER_H
+
+#include "base/macros_magic.h"
+#include "base/net/write_task.h"
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace base {
+
+// Outgoing messages are kept in a queue for each priority. Every write operation takes messages
+// starting with the queue of the highest priority. If chunking is enabled, large user messages are
+// split into chunks, so a message with a higher priority does not wait until a large message with
+// a lower priority is written entirely.
+//
+// Every chunk is written with a byte of flags (see chunkFlags()). The receiver assembles the
+// chunks with MessageAssembler.
+class MessageChunker
+{
+public:
+    // Part of a message written by the current write operation.
+    struct Piece
+    {
+        const WriteTask* task;
+        size_t offset; // Offset of the piece in the message data.
+        size_t size; // Size of the message data in the piece.
+        bool last; // The piece completes the message.
+    };
+
+    // Returns the size of the frame for |size| bytes of |task| data or 0 if the message cannot be
+    // written.
+    using FrameSizeCallback = std::function<size_t(const WriteTask& task, size_t size)>;
+
+    MessageChunker();
+    ~MessageChunker();
+
+    // If |chunk_size| is not 0, user messages larger than |chunk_size| are split into chunks.
+    void setChunkSize(size_t chunk_size) { chunk_size_ = chunk_size; }
+    size_t chunkSize() const { return chunk_size_; }
+
+    void add(WriteTask&& task);
+
+    // Returns the number of messages that are not written entirely.
+    size_t pendingMessages() const;
+
+    // Selects the pieces for the next write operation. Pieces are added until the batch contains
+    // |max_count| pieces or the next piece does not fit into |max_size| bytes. The first piece is
+    // added regardless of its size. Returns the total size of the frames or 0 if a message cannot
+    // be written.
+    size_t prepareBatch(size_t max_count, size_t max_size, const FrameSizeCallback& frame_size);
+
+    // Pieces of the current write operation.
+    const std::vector<Piece>& batch() const { return batch_; }
+    bool isWriting() const { return !batch_.empty(); }
+
+    // Time when the oldest message of the batch was added to the queue.
+    const WriteTask::TimePoint& batchTime() const { return batch_time_; }
+
+    // Removes the written pieces from the queues. Channel ids of the user messages which have been
+    // written entirely are added to |written_channels|.
+    void completeBatch(std::vector<uint8_t>* written_channels);
+
+    // Returns the byte with flags which is written before the data of |piece|.
+    static uint8_t chunkFlags(const Piece& piece);
+
+private:
+    std::deque<WriteTask> queue_[WriteTask::kPriorityCount];
+
+    // Size of the data of the first message in each queue which has already been written.
+    size_t offset_[WriteTask::kPriorityCount] = { 0 };
+
+    size_t chunk_size_ = 0;
+    std::vector<Piece> batch_;
+    WriteTask::TimePoint batch_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(MessageChunker);
+};
+
+// Assembles the messages received in chunks. The chunks of messages with different priorities can
+// be interleaved, the chunks of one message are received in order.
+class MessageAssembler
+{
+public:
+    enum class Status
+    {
+        COMPLETE,   // |data| contains the whole message.
+        INCOMPLETE, // More chunks are expected.
+        INVALID     // The chunk does not match the protocol.
+    };
+
+    MessageAssembler();
+    ~MessageAssembler();
+
+    // Adds the chunk received with |flags| and |channel_id|. If the chunk completes the message,
+    // |data| is replaced with the whole message.
+    Status add(uint8_t flags, uint8_t channel_id, ByteArray* data);
+
+private:
+    // Incomplete messages for each priority.
+    ByteArray buffer_[WriteTask::kPriorityCount];
+    uint8_t channel_id_[WriteTask::kPriorityCount] = { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(MessageAssembler);
+};
+
+} // namespace base
+
+#endif // BASE_NET_MESSAGE_CHUNKER_H
@@ -0,0 +1,321 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+#include "base/net/message_chunker.h"
+
+#include "base/net/network_channel.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+using Priority = WriteTask::Priority;
+
+const size_t kMaxCount = 64;
+const size_t kMaxSize = 64 * 1024;
+
+// One byte of the frame header for every piece.
+size_t frameSize(const WriteTask& /* task */, size_t size)
+{
+    return size + 1;
+}
+
+ByteArray message(size_t size, uint8_t value)
+{
+    ByteArray buffer(size);
+
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = static_cast<uint8_t>(value + i);
+
+    return buffer;
+}
+
+void addMessage(MessageChunker* chunker, uint8_t channel_id, ByteArray&& data, Priority priority)
+{
+    chunker->add(WriteTask(WriteTask::Type::USER_DATA, channel_id, std::move(data), priority));
+}
+
+// A received chunk as the channel would pass it to the assembler.
+struct Chunk
+{
+    uint8_t flags;
+    uint8_t channel_id;
+    ByteArray data;
+};
+
+// Writes one batch of at most |max_count| pieces and adds its chunks to |chunks|.
+void writeBatch(MessageChunker* chunker, size_t max_count, std::vector<Chunk>* chunks)
+{
+    EXPECT_NE(chunker->prepareBatch(max_count, kMaxSize, frameSize), 0U);
+
+    for (const auto& piece : chunker->batch())
+    {
+        const uint8_t* data = piece.task->data().data() + piece.offset;
+
+        chunks->push_back({ MessageChunker::chunkFlags(piece),
+                            piece.task->channelId(),
+                            ByteArray(data, data + piece.size) });
+    }
+
+    std::vector<uint8_t> written_channels;
+    chunker->completeBatch(&written_channels);
+}
+
+} // namespace
+
+TEST(MessageChunkerTest, Priorities)
+{
+    MessageChunker chunker;
+
+    addMessage(&chunker, 1, message(10, 1), Priority::LOW);
+    addMessage(&chunker, 2, message(10, 2), Priority::NORMAL);
+    addMessage(&chunker, 3, message(10, 3), Priority::HIGH);
+    addMessage(&chunker, 4, message(10, 4), Priority::NORMAL);
+
+    EXPECT_EQ(chunker.pendingMessages(), 4U);
+    EXPECT_EQ(chunker.prepareBatch(kMaxCount, kMaxSize, frameSize), 44U);
+    EXPECT_TRUE(chunker.isWriting());
+
+    const std::vector<MessageChunker::Piece>& batch = chunker.batch();
+    ASSERT_EQ(batch.size(), 4U);
+
+    // Messages with the same priority keep their order.
+    const uint8_t kExpectedChannels[] = { 3, 2, 4, 1 };
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        EXPECT_EQ(batch[i].task->channelId(), kExpectedChannels[i]);
+        EXPECT_EQ(batch[i].offset, 0U);
+        EXPECT_EQ(batch[i].size, 10U);
+        EXPECT_TRUE(batch[i].last);
+    }
+
+    std::vector<uint8_t> written_channels;
+    chunker.completeBatch(&written_channels);
+
+    EXPECT_FALSE(chunker.isWriting());
+    EXPECT_EQ(chunker.pendingMessages(), 0U);
+    EXPECT_EQ(written_channels, std::vector<uint8_t>({ 3, 2, 4, 1 }));
+}
+
+TEST(MessageChunkerTest, BatchLimits)
+{
+    MessageChunker chunker;
+
+    // The first message is written regardless of its size.
+    addMessage(&chunker, 1, message(100, 1), Priority::NORMAL);
+    addMessage(&chunker, 2, message(10, 2), Priority::NORMAL);
+    addMessage(&chunker, 3, message(10, 3), Priority::NORMAL);
+    addMessage(&chunker, 4, message(10, 4), Priority::NORMAL);
+
+    std::vector<uint8_t> written_channels;
+
+    EXPECT_EQ(chunker.prepareBatch(kMaxCount, 50, frameSize), 101U);
+    ASSERT_EQ(chunker.batch().size(), 1U);
+    chunker.completeBatch(&written_channels);
+
+    EXPECT_EQ(chunker.prepareBatch(kMaxCount, 25, frameSize), 22U);
+    ASSERT_EQ(chunker.batch().size(), 2U);
+    chunker.completeBatch(&written_channels);
+
+    EXPECT_EQ(chunker.prepareBatch(1, kMaxSize, frameSize), 11U);
+    ASSERT_EQ(chunker.batch().size(), 1U);
+    chunker.completeBatch(&written_channels);
+
+    EXPECT_EQ(written_channels, std::vector<uint8_t>({ 1, 2, 3, 4 }));
+    EXPECT_EQ(chunker.pendingMessages(), 0U);
+}
+
+TEST(MessageChunkerTest, Chunks)
+{
+    MessageChunker chunker;
+    chunker.setChunkSize(10);
+
+    addMessage(&chunker, 5, message(25, 1), Priority::LOW);
+
+    // Service messages are never split.
+    chunker.add(WriteTask(WriteTask::Type::SERVICE_DATA, 0, message(25, 2), Priority::HIGH));
+
+    EXPECT_EQ(chunker.prepareBatch(kMaxCount, kMaxSize, frameSize), 26U + 11U + 11U + 6U);
+
+    const std::vector<MessageChunker::Piece>& batch = chunker.batch();
+    ASSERT_EQ(batch.size(), 4U);
+
+    EXPECT_EQ(batch[0].task->type(), WriteTask::Type::SERVICE_DATA);
+    EXPECT_EQ(batch[0].size, 25U);
+    EXPECT_TRUE(batch[0].last);
+
+    const size_t kExpectedOffset[] = { 0, 10, 20 };
+    const size_t kExpectedSize[] = { 10, 10, 5 };
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const MessageChunker::Piece& piece = batch[i + 1];
+
+        EXPECT_EQ(piece.task->channelId(), 5);
+        EXPECT_EQ(piece.offset, kExpectedOffset[i]);
+        EXPECT_EQ(piece.size, kExpectedSize[i]);
+        EXPECT_EQ(piece.last, i == 2);
+
+        // The priority is in the lower bits, the upper bit is set for all chunks except the last.
+        const uint8_t flags = MessageChunker::chunkFlags(piece);
+        EXPECT_EQ(flags & 0x7F, static_cast<uint8_t>(Priority::LOW));
+        EXPECT_EQ((flags & 0x80) != 0, i != 2);
+    }
+
+    // The written message is reported once.
+    std::vector<uint8_t> written_channels;
+    chunker.completeBatch(&written_channels);
+    EXPECT_EQ(written_channels, std::vector<uint8_t>({ 5 }));
+}
+
+TEST(MessageChunkerTest, Interleaving)
+{
+    MessageChunker chunker;
+    chunker.setChunkSize(10);
+
+    addMessage(&chunker, 1, message(100, 1), Priority::LOW);
+
+    std::vector<uint8_t> written_channels;
+
+    EXPECT_NE(chunker.prepareBatch(2, kMaxSize, frameSize), 0U);
+    ASSERT_EQ(chunker.batch().size(), 2U);
+
+    // Messages added during the write operation do not change the current batch.
+    addMessage(&chunker, 2, message(5, 2), Priority::HIGH);
+    addMessage(&chunker, 3, message(15, 3), Priority::NORMAL);
+
+    EXPECT_EQ(chunker.batch()[1].task->channelId(), 1);
+    chunker.completeBatch(&written_channels);
+    EXPECT_TRUE(written_channels.empty());
+
+    // The messages with a higher priority overtake the rest of the large message.
+    EXPECT_NE(chunker.prepareBatch(4, kMaxSize, frameSize), 0U);
+
+    const std::vector<MessageChunker::Piece>& batch = chunker.batch();
+    ASSERT_EQ(batch.size(), 4U);
+
+    EXPECT_EQ(batch[0].task->channelId(), 2);
+    EXPECT_TRUE(batch[0].last);
+    EXPECT_EQ(batch[1].task->channelId(), 3);
+    EXPECT_FALSE(batch[1].last);
+    EXPECT_EQ(batch[2].task->channelId(), 3);
+    EXPECT_EQ(batch[2].offset, 10U);
+    EXPECT_TRUE(batch[2].last);
+    EXPECT_EQ(batch[3].task->channelId(), 1);
+    EXPECT_EQ(batch[3].offset, 20U);
+    EXPECT_FALSE(batch[3].last);
+
+    chunker.completeBatch(&written_channels);
+    EXPECT_EQ(written_channels, std::vector<uint8_t>({ 2, 3 }));
+    EXPECT_EQ(chunker.pendingMessages(), 1U);
+}
+
+TEST(MessageChunkerTest, InvalidMessage)
+{
+    MessageChunker chunker;
+
+    addMessage(&chunker, 1, ByteArray(), Priority::NORMAL);
+    EXPECT_EQ(chunker.prepareBatch(kMaxCount, kMaxSize, frameSize), 0U);
+
+    MessageChunker chunker2;
+
+    addMessage(&chunker2, 1, message(10, 1), Priority::NORMAL);
+    EXPECT_EQ(chunker2.prepareBatch(kMaxCount, kMaxSize,
+                                    [](const WriteTask& /* task */, size_t /* size */)
+    {
+        return size_t(0);
+    }), 0U);
+}
+
+TEST(MessageAssemblerTest, RoundTrip)
+{
+    MessageChunker chunker;
+    chunker.setChunkSize(16);
+
+    const ByteArray kLow = message(100, 1);
+    const ByteArray kNormal = message(40, 2);
+    const ByteArray kHigh1 = message(20, 3);
+    const ByteArray kHigh2 = message(8, 4);
+
+    addMessage(&chunker, 1, ByteArray(kLow), Priority::LOW);
+    addMessage(&chunker, 2, ByteArray(kNormal), Priority::NORMAL);
+    addMessage(&chunker, 3, ByteArray(kHigh1), Priority::HIGH);
+
+    // Small batches interleave the chunks of the messages with different priorities.
+    std::vector<Chunk> chunks;
+    writeBatch(&chunker, 3, &chunks);
+
+    addMessage(&chunker, 4, ByteArray(kHigh2), Priority::HIGH);
+
+    while (chunker.pendingMessages())
+        writeBatch(&chunker, 2, &chunks);
+
+    MessageAssembler assembler;
+    std::vector<std::pair<uint8_t, ByteArray>> received;
+
+    for (auto& chunk : chunks)
+    {
+        MessageAssembler::Status status =
+            assembler.add(chunk.flags, chunk.channel_id, &chunk.data);
+        ASSERT_NE(status, MessageAssembler::Status::INVALID);
+
+        if (status == MessageAssembler::Status::COMPLETE)
+            received.emplace_back(chunk.channel_id, chunk.data);
+    }
+
+    ASSERT_EQ(received.size(), 4U);
+
+    EXPECT_EQ(received[0].first, 3);
+    EXPECT_EQ(received[0].second, kHigh1);
+    EXPECT_EQ(received[1].first, 4);
+    EXPECT_EQ(received[1].second, kHigh2);
+    EXPECT_EQ(received[2].first, 2);
+    EXPECT_EQ(received[2].second, kNormal);
+    EXPECT_EQ(received[3].first, 1);
+    EXPECT_EQ(received[3].second, kLow);
+}
+
+TEST(MessageAssemblerTest, InvalidChunks)
+{
+    MessageAssembler assembler;
+
+    // Unknown priority.
+    ByteArray data = message(10, 1);
+    EXPECT_EQ(assembler.add(0x03, 1, &data), MessageAssembler::Status::INVALID);
+
+    // A message without chunks is passed as is.
+    EXPECT_EQ(assembler.add(0x01, 1, &data), MessageAssembler::Status::COMPLETE);
+    EXPECT_EQ(data, message(10, 1));
+
+    // All chunks of a message must have the same channel id.
+    EXPECT_EQ(assembler.add(0x81, 1, &data), MessageAssembler::Status::INCOMPLETE);
+    EXPECT_EQ(assembler.add(0x01, 2, &data), MessageAssembler::Status::INVALID);
+
+    // The assembled message cannot exceed the maximum message size.
+    MessageAssembler assembler2;
+    ByteArray chunk(NetworkChannel::kMaxMessageSize / 2 + 1);
+
+    EXPECT_EQ(assembler2.add(0x82, 1, &chunk), MessageAssembler::Status::INCOMPLETE);
+    EXPECT_EQ(assembler2.add(0x82, 1, &chunk), MessageAssembler::Status::INVALID);
+}
+
+} // namespace base
@@ -29,11 +29,29 @@
 #include "base/strings/unicode.h"
 
 #include <asio/connect.hpp>
-#include <asio/read.hpp>
 #include <asio/write.hpp>
 
+#include <algorithm>
+
 namespace base {
 
+namespace {
+
+// Limits for the number of messages and bytes which are written by one operation. The first
+// message in the queue is always written entirely, regardless of its size.
+const size_t kMaxWriteBatchMessages = 64;
+const size_t kMaxWriteBatchSize = 64 * 1024;
+
+// Minimum size of the buffer for reading from the socket. The buffer is increased if the message
+// does not fit into it.
+const size_t kReadBufferSize = 16 * 1024;
+
+// If chunking is enabled, messages are written in chunks of this size. A message with a higher
+// priority waits no longer than one write batch.
+const size_t kChunkSize = 16 * 1024;
+
+} // namespace
+
 TcpChannel::TcpChannel()
     : proxy_(new TcpChannelProxy(MessageLoop::current()->taskRunner(), this)),
       io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
@@ -139,6 +157,32 @@ bool TcpChannel::isPaused() const
     return paused_;
 }
 
+bool TcpChannel::isPeerDisconnected()
+{
+    if (!connected_)
+        return true;
+
+    std::error_code error_code;
+
+    // Peek one byte without blocking. A closed connection is readable with no data.
+    const bool non_blocking = socket_.non_blocking();
+    socket_.non_blocking(true, error_code);
+    if (error_code)
+        return false;
+
+    uint8_t byte;
+    size_t size = socket_.receive(
+        asio::buffer(&byte, sizeof(byte)), asio::socket_base::message_peek, error_code);
+
+    std::error_code ignored_code;
+    socket_.non_blocking(non_blocking, ignored_code);
+
+    if (error_code == asio::error::would_block || error_code == asio::error::try_again)
+        return false;
+
+    return error_code || size == 0;
+}
+
 void TcpChannel::pause()
 {
     paused_ = true;
@@ -151,29 +195,18 @@ void TcpChannel::resume()
 
     paused_ = false;
 
-    switch (state_)
-    {
-        // We already have an incomplete read operation.
-        case ReadState::READ_SIZE:
-        case ReadState::READ_USER_DATA:
-        case ReadState::READ_SERVICE_HEADER:
-        case ReadState::READ_SERVICE_DATA:
-            return;
-
-        default:
-            break;
-    }
-
-    // If we have a message that was received before the pause command.
-    if (state_ == ReadState::PENDING)
-        onMessageReceived();
+    // We already have an incomplete read operation or the messages are being processed now.
+    if (state_ != ReadState::IDLE)
+        return;
 
-    doReadSize();
+    // If we have messages that were received before the pause command, then we notify about them
+    // and continue reading.
+    processReadBuffer();
 }
 
-void TcpChannel::send(uint8_t channel_id, ByteArray&& buffer)
+void TcpChannel::send(uint8_t channel_id, ByteArray&& buffer, Priority priority)
 {
-    addWriteTask(WriteTask::Type::USER_DATA, channel_id, std::move(buffer));
+    addWriteTask(WriteTask::Type::USER_DATA, channel_id, std::move(buffer), priority);
 }
 
 bool TcpChannel::setNoDelay(bool enable)
@@ -250,6 +283,18 @@ bool TcpChannel::hasChannelIdSupport() const
     return channel_id_support_;
 }
 
+void TcpChannel::setChunkingSupport(bool enable)
+{
+    DCHECK(!enable || channel_id_support_);
+    chunking_support_ = enable;
+    write_queue_.setChunkSize(enable ? kChunkSize : 0);
+}
+
+bool TcpChannel::hasChunkingSupport() const
+{
+    return chunking_support_;
+}
+
 bool TcpChannel::setReadBufferSize(size_t size)
 {
     asio::socket_base::receive_buffer_size option(static_cast<int>(size));
@@ -341,20 +386,41 @@ void TcpChannel::onErrorOccurred(const Location& location, ErrorCode error_code)
 void TcpChannel::onMessageWritten(uint8_t channel_id)
 {
     if (listener_)
-        listener_->onTcpMessageWritten(channel_id, write_queue_.size());
+        listener_->onTcpMessageWritten(channel_id, pendingMessages());
 }
 
-void TcpChannel::onMessageReceived()
+void TcpChannel::onMessageReceived(const uint8_t* data, size_t size)
 {
-    uint8_t* read_data = read_buffer_.data();
-    size_t read_size = read_buffer_.size();
+    const uint8_t* read_data = data;
+    size_t read_size = size;
     uint8_t channel_id = 0;
 
     if (channel_id_support_)
     {
+        if (read_size <= sizeof(channel_id))
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
         read_data += sizeof(channel_id);
         read_size -= sizeof(channel_id);
-        channel_id = read_buffer_[0];
+        channel_id = data[0];
+    }
+
+    uint8_t flags = 0;
+
+    if (chunking_support_)
+    {
+        if (read_size <= sizeof(flags))
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        flags = read_data[0];
+        read_data += sizeof(flags);
+        read_size -= sizeof(flags);
     }
 
     resizeBuffer(&decrypt_buffer_, decryptor_->decryptedDataSize(read_size));
@@ -365,79 +431,81 @@ void TcpChannel::onMessageReceived()
         return;
     }
 
+    if (chunking_support_)
+    {
+        // Large messages are received in chunks.
+        MessageAssembler::Status status =
+            message_assembler_.add(flags, channel_id, &decrypt_buffer_);
+
+        if (status == MessageAssembler::Status::INVALID)
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        if (status == MessageAssembler::Status::INCOMPLETE)
+            return;
+    }
+
     if (listener_)
         listener_->onTcpMessageReceived(channel_id, decrypt_buffer_);
 }
 
-void TcpChannel::addWriteTask(WriteTask::Type type, uint8_t channel_id, ByteArray&& data)
+void TcpChannel::addWriteTask(
+    WriteTask::Type type, uint8_t channel_id, ByteArray&& data, Priority priority)
 {
-    const bool schedule_write = write_queue_.empty();
-
     // Add the buffer to the queue for sending.
-    write_queue_.emplace(type, channel_id, std::move(data));
+    write_queue_.add(WriteTask(type, channel_id, std::move(data), priority));
 
-    if (schedule_write)
+    // If a write operation is in progress, the message will be written after it is completed.
+    if (!write_queue_.isWriting())
         doWrite();
 }
 
+bool TcpChannel::reloadWriteQueues()
+{
+    if (!proxy_->reloadWriteQueue(&reload_queue_))
+        return false;
+
+    for (auto& task : reload_queue_)
+        write_queue_.add(std::move(task));
+
+    reload_queue_.clear();
+    return true;
+}
+
 void TcpChannel::doWrite()
 {
-    const WriteTask& task = write_queue_.front();
-    const ByteArray& source_buffer = task.data();
-    const uint8_t channel_id = task.channelId();
+    DCHECK(!write_queue_.isWriting());
 
-    if (source_buffer.empty())
+    // Select the messages (or their chunks) which will be written at this time.
+    const size_t total_size = write_queue_.prepareBatch(
+        kMaxWriteBatchMessages, kMaxWriteBatchSize,
+        std::bind(&TcpChannel::frameSize, this, std::placeholders::_1, std::placeholders::_2));
+    if (!total_size)
     {
         onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
         return;
     }
 
-    if (task.type() == WriteTask::Type::USER_DATA)
-    {
-        // Calculate the size of the encrypted message.
-        size_t target_data_size = encryptor_->encryptedDataSize(source_buffer.size());
-        if (channel_id_support_)
-            target_data_size += sizeof(channel_id);
-
-        if (target_data_size > kMaxMessageSize)
-        {
-            LOG(LS_ERROR) << "Too big outgoing message: " << target_data_size;
-            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-            return;
-        }
-
-        asio::const_buffer variable_size = variable_size_writer_.variableSize(target_data_size);
+    resizeBuffer(&write_buffer_, total_size);
 
-        resizeBuffer(&write_buffer_, variable_size.size() + target_data_size);
-
-        // Copy the size of the message to the buffer.
-        memcpy(write_buffer_.data(), variable_size.data(), variable_size.size());
-
-        uint8_t* write_buffer = write_buffer_.data() + variable_size.size();
-        if (channel_id_support_)
-        {
-            // Copy the channel id to the buffer.
-            memcpy(write_buffer, &channel_id, sizeof(channel_id));
-            write_buffer += sizeof(channel_id);
-        }
+    uint8_t* write_buffer = write_buffer_.data();
 
-        // Encrypt the message.
-        if (!encryptor_->encrypt(source_buffer.data(), source_buffer.size(), write_buffer))
+    for (const auto& piece : write_queue_.batch())
+    {
+        size_t written = writeMessage(piece, write_buffer);
+        if (!written)
         {
             onErrorOccurred(FROM_HERE, ErrorCode::ACCESS_DENIED);
             return;
         }
-    }
-    else
-    {
-        DCHECK_EQ(task.type(), WriteTask::Type::SERVICE_DATA);
-
-        resizeBuffer(&write_buffer_, source_buffer.size());
 
-        // Service data does not need encryption. Copy the source buffer.
-        memcpy(write_buffer_.data(), source_buffer.data(), source_buffer.size());
+        write_buffer += written;
     }
 
+    DCHECK(write_buffer == write_buffer_.data() + write_buffer_.size());
+
     // Send the buffer to the recipient.
     asio::async_write(socket_,
                       asio::buffer(write_buffer_.data(), write_buffer_.size()),
@@ -447,148 +515,168 @@ void TcpChannel::doWrite()
                                 std::placeholders::_2));
 }
 
-void TcpChannel::onWrite(const std::error_code& error_code, size_t bytes_transferred)
+size_t TcpChannel::frameSize(const WriteTask& task, size_t size)
 {
-    if (error_code)
+    if (task.type() == WriteTask::Type::SERVICE_DATA)
+        return size;
+
+    // The whole message must fit into the buffer of the receiver after assembling.
+    if (encryptor_->encryptedDataSize(task.data().size()) > kMaxMessageSize)
     {
-        onErrorOccurred(FROM_HERE, error_code);
-        return;
+        LOG(LS_ERROR) << "Too big outgoing message: " << task.data().size();
+        return 0;
     }
 
-    DCHECK(!write_queue_.empty());
-
-    // Update TX statistics.
-    addTxBytes(bytes_transferred);
-
-    const WriteTask& task = write_queue_.front();
-    WriteTask::Type task_type = task.type();
-    uint8_t channel_id = task.channelId();
-
-    // Delete the sent message from the queue.
-    write_queue_.pop();
-
-    // If the queue is not empty, then we send the following message.
-    bool schedule_write = !write_queue_.empty() || proxy_->reloadWriteQueue(&write_queue_);
+    // Calculate the size of the encrypted message.
+    size_t target_data_size = encryptor_->encryptedDataSize(size);
+    if (channel_id_support_)
+        target_data_size += sizeof(uint8_t);
+    if (chunking_support_)
+        target_data_size += sizeof(uint8_t);
 
-    if (task_type == WriteTask::Type::USER_DATA)
-        onMessageWritten(channel_id);
+    if (target_data_size > kMaxMessageSize)
+    {
+        LOG(LS_ERROR) << "Too big outgoing message: " << target_data_size;
+        return 0;
+    }
 
-    if (schedule_write)
-        doWrite();
+    return variable_size_writer_.variableSize(target_data_size).size() + target_data_size;
 }
 
-void TcpChannel::doReadSize()
+size_t TcpChannel::writeMessage(const MessageChunker::Piece& piece, uint8_t* buffer)
 {
-    state_ = ReadState::READ_SIZE;
-    asio::async_read(socket_,
-                     variable_size_reader_.buffer(),
-                     std::bind(&TcpChannel::onReadSize,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
-}
+    const WriteTask& task = *piece.task;
+    const ByteArray& source_buffer = task.data();
 
-void TcpChannel::onReadSize(const std::error_code& error_code, size_t bytes_transferred)
-{
-    if (error_code)
+    if (task.type() == WriteTask::Type::SERVICE_DATA)
     {
-        onErrorOccurred(FROM_HERE, error_code);
-        return;
+        // Service data does not need encryption. Copy the source buffer.
+        memcpy(buffer, source_buffer.data(), source_buffer.size());
+        return source_buffer.size();
     }
 
-    // Update RX statistics.
-    addRxBytes(bytes_transferred);
+    DCHECK_LE(piece.offset + piece.size, source_buffer.size());
 
-    std::optional<size_t> size = variable_size_reader_.messageSize();
-    if (size.has_value())
-    {
-        size_t message_size = *size;
+    const uint8_t channel_id = task.channelId();
 
-        if (message_size > kMaxMessageSize)
-        {
-            LOG(LS_ERROR) << "Too big incoming message: " << message_size;
-            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-            return;
-        }
+    size_t target_data_size = encryptor_->encryptedDataSize(piece.size);
+    if (channel_id_support_)
+        target_data_size += sizeof(channel_id);
+    if (chunking_support_)
+        target_data_size += sizeof(uint8_t);
 
-        // If the message size is 0 (in other words, the first received byte is 0), then you need
-        // to start reading the service message.
-        if (!message_size)
-        {
-            doReadServiceHeader();
-            return;
-        }
+    asio::const_buffer variable_size = variable_size_writer_.variableSize(target_data_size);
+
+    // Copy the size of the message to the buffer.
+    memcpy(buffer, variable_size.data(), variable_size.size());
+    buffer += variable_size.size();
 
-        doReadUserData(message_size);
+    if (channel_id_support_)
+    {
+        // Copy the channel id to the buffer.
+        memcpy(buffer, &channel_id, sizeof(channel_id));
+        buffer += sizeof(channel_id);
     }
-    else
+
+    if (chunking_support_)
     {
-        doReadSize();
+        *buffer = MessageChunker::chunkFlags(piece);
+        buffer += sizeof(uint8_t);
     }
-}
 
-void TcpChannel::doReadUserData(size_t length)
-{
-    resizeBuffer(&read_buffer_, length);
+    // Encrypt the message.
+    if (!encryptor_->encrypt(source_buffer.data() + piece.offset, piece.size, buffer))
+        return 0;
 
-    state_ = ReadState::READ_USER_DATA;
-    asio::async_read(socket_,
-                     asio::buffer(read_buffer_.data(), read_buffer_.size()),
-                     std::bind(&TcpChannel::onReadUserData,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+    return variable_size.size() + target_data_size;
 }
 
-void TcpChannel::onReadUserData(const std::error_code& error_code, size_t bytes_transferred)
+void TcpChannel::onWrite(const std::error_code& error_code, size_t bytes_transferred)
 {
-    DCHECK_EQ(state_, ReadState::READ_USER_DATA);
-
     if (error_code)
     {
         onErrorOccurred(FROM_HERE, error_code);
         return;
     }
 
-    // Update RX statistics.
-    addRxBytes(bytes_transferred);
+    DCHECK(write_queue_.isWriting());
 
-    DCHECK_EQ(bytes_transferred, read_buffer_.size());
+    // Update TX statistics.
+    addTxBytes(bytes_transferred);
 
-    if (paused_)
+    // The oldest message of the batch has been waiting longer than the others.
+    const BandwidthEstimator::TimePoint now = BandwidthEstimator::Clock::now();
+    const BandwidthEstimator::Milliseconds queue_delay =
+        std::chrono::duration_cast<BandwidthEstimator::Milliseconds>(
+            now - write_queue_.batchTime());
+    bandwidth_estimator_.onBytesWritten(bytes_transferred, queue_delay, now);
+
+    written_channels_.clear();
+
+    // Delete the sent messages from the queues.
+    write_queue_.completeBatch(&written_channels_);
+
+    // Add the messages sent from other threads. They can overtake the rest of the queued messages
+    // with a lower priority.
+    reloadWriteQueues();
+
+    for (const auto& channel_id : written_channels_)
+        onMessageWritten(channel_id);
+
+    // If the queues are not empty, then we send the following messages. The listener could
+    // already start writing the message it sent from the notification.
+    if (!write_queue_.isWriting() && write_queue_.pendingMessages() != 0)
+        doWrite();
+}
+
+void TcpChannel::doRead(size_t frame_size)
+{
+    if (read_begin_ == read_end_)
     {
-        state_ = ReadState::PENDING;
-        return;
+        // All received data has been processed.
+        read_begin_ = 0;
+        read_end_ = 0;
+    }
+    else if (read_begin_ &&
+             (read_end_ == read_buffer_.size() || read_begin_ + frame_size > read_buffer_.size()))
+    {
+        // Move the beginning of the incomplete message to the start of the buffer.
+        memmove(read_buffer_.data(), read_buffer_.data() + read_begin_, read_end_ - read_begin_);
+        read_end_ -= read_begin_;
+        read_begin_ = 0;
     }
 
-    onMessageReceived();
-
-    if (paused_)
+    size_t buffer_size = std::max(kReadBufferSize, frame_size);
+    if (read_buffer_.size() < buffer_size)
     {
-        state_ = ReadState::IDLE;
-        return;
+        read_buffer_.resize(buffer_size);
     }
+    else if (buffer_size == kReadBufferSize && read_buffer_.size() > kReadBufferSize &&
+             read_end_ - read_begin_ < kReadBufferSize)
+    {
+        // The large message has been processed. Release the memory taken by it.
+        ByteArray buffer(kReadBufferSize);
+        memcpy(buffer.data(), read_buffer_.data() + read_begin_, read_end_ - read_begin_);
 
-    doReadSize();
-}
+        read_end_ -= read_begin_;
+        read_begin_ = 0;
+        read_buffer_.swap(buffer);
+    }
 
-void TcpChannel::doReadServiceHeader()
-{
-    resizeBuffer(&read_buffer_, sizeof(ServiceHeader));
+    DCHECK_LT(read_end_, read_buffer_.size());
 
-    state_ = ReadState::READ_SERVICE_HEADER;
-    asio::async_read(socket_,
-                     asio::buffer(read_buffer_.data(), read_buffer_.size()),
-                     std::bind(&TcpChannel::onReadServiceHeader,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+    state_ = ReadState::READING;
+    socket_.async_read_some(asio::buffer(read_buffer_.data() + read_end_,
+                                         read_buffer_.size() - read_end_),
+                            std::bind(&TcpChannel::onRead,
+                                      this,
+                                      std::placeholders::_1,
+                                      std::placeholders::_2));
 }
 
-void TcpChannel::onReadServiceHeader(const std::error_code& error_code, size_t bytes_transferred)
+void TcpChannel::onRead(const std::error_code& error_code, size_t bytes_transferred)
 {
-    DCHECK_EQ(state_, ReadState::READ_SERVICE_HEADER);
-    DCHECK_EQ(read_buffer_.size(), sizeof(ServiceHeader));
+    DCHECK(state_ == ReadState::READING);
 
     if (error_code)
     {
@@ -596,103 +684,125 @@ void TcpChannel::onReadServiceHeader(const std::error_code& error_code, size_t b
         return;
     }
 
-    DCHECK_EQ(bytes_transferred, read_buffer_.size());
-
     // Update RX statistics.
     addRxBytes(bytes_transferred);
 
-    ServiceHeader* header = reinterpret_cast<ServiceHeader*>(read_buffer_.data());
-    if (header->length > kMaxMessageSize)
-    {
-        LOG(LS_INFO) << "Too big service message: " << header->length;
-        onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-        return;
-    }
+    read_end_ += bytes_transferred;
+    DCHECK_LE(read_end_, read_buffer_.size());
+
+    processReadBuffer();
+}
+
+void TcpChannel::processReadBuffer()
+{
+    state_ = ReadState::PROCESSING;
 
-    if (header->type == KEEP_ALIVE)
+    size_t frame_size = 0;
+
+    while (connected_ && !paused_)
     {
-        // Keep alive packet must always contain data.
-        if (!header->length)
+        const uint8_t* data = read_buffer_.data() + read_begin_;
+        const size_t available = read_end_ - read_begin_;
+
+        frame_size = 0;
+
+        size_t message_size = 0;
+        size_t size_length = VariableSizeReader::read(data, available, &message_size);
+        if (!size_length)
+        {
+            // The message size has not yet been received completely.
+            break;
+        }
+
+        if (message_size > kMaxMessageSize)
         {
+            LOG(LS_ERROR) << "Too big incoming message: " << message_size;
             onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
             return;
         }
 
-        doReadServiceData(header->length);
-    }
-    else
-    {
-        onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-        return;
-    }
-}
+        // If the message size is 0 (in other words, the first received byte is 0), then this is
+        // the service message.
+        if (!message_size)
+        {
+            frame_size = size_length + sizeof(ServiceHeader);
+            if (available < frame_size)
+                break;
 
-void TcpChannel::doReadServiceData(size_t length)
-{
-    DCHECK_EQ(read_buffer_.size(), sizeof(ServiceHeader));
-    DCHECK_EQ(state_, ReadState::READ_SERVICE_HEADER);
-    DCHECK_GT(length, 0u);
+            ServiceHeader header;
+            memcpy(&header, data + size_length, sizeof(header));
 
-    read_buffer_.resize(read_buffer_.size() + length);
+            if (header.length > kMaxMessageSize)
+            {
+                LOG(LS_INFO) << "Too big service message: " << header.length;
+                onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+                return;
+            }
 
-    // Now we read the data after the header.
-    state_ = ReadState::READ_SERVICE_DATA;
-    asio::async_read(socket_,
-                     asio::buffer(read_buffer_.data() + sizeof(ServiceHeader),
-                                  read_buffer_.size() - sizeof(ServiceHeader)),
-                     std::bind(&TcpChannel::onReadServiceData,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
-}
+            // Keep alive packet must always contain data.
+            if (header.type != KEEP_ALIVE || !header.length)
+            {
+                onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+                return;
+            }
 
-void TcpChannel::onReadServiceData(const std::error_code& error_code, size_t bytes_transferred)
-{
-    DCHECK_EQ(state_, ReadState::READ_SERVICE_DATA);
-    DCHECK_GT(read_buffer_.size(), sizeof(ServiceHeader));
+            frame_size += header.length;
+            if (available < frame_size)
+                break;
 
-    if (error_code)
+            read_begin_ += frame_size;
+            onServiceMessageReceived(
+                header, data + size_length + sizeof(ServiceHeader), header.length);
+        }
+        else
+        {
+            frame_size = size_length + message_size;
+            if (available < frame_size)
+                break;
+
+            read_begin_ += frame_size;
+            onMessageReceived(data + size_length, message_size);
+        }
+
+        frame_size = 0;
+    }
+
+    if (!connected_)
+        return;
+
+    if (paused_)
     {
-        onErrorOccurred(FROM_HERE, error_code);
+        // The remaining messages will be processed after calling resume().
+        state_ = ReadState::IDLE;
         return;
     }
 
-    // Update RX statistics.
-    addRxBytes(bytes_transferred);
-
-    // Incoming buffer contains a service header.
-    ServiceHeader* header = reinterpret_cast<ServiceHeader*>(read_buffer_.data());
+    doRead(frame_size);
+}
 
-    DCHECK_EQ(bytes_transferred, read_buffer_.size() - sizeof(ServiceHeader));
-    DCHECK_LE(header->length, kMaxMessageSize);
+void TcpChannel::onServiceMessageReceived(
+    const ServiceHeader& header, const uint8_t* data, size_t size)
+{
+    DCHECK_EQ(header.length, size);
+    DCHECK_LE(header.length, kMaxMessageSize);
 
-    if (header->type == KEEP_ALIVE)
+    if (header.type == KEEP_ALIVE)
     {
-        if (header->flags & KEEP_ALIVE_PING)
+        if (header.flags & KEEP_ALIVE_PING)
         {
             // Send pong.
-            sendKeepAlive(KEEP_ALIVE_PONG,
-                          read_buffer_.data() + sizeof(ServiceHeader),
-                          read_buffer_.size() - sizeof(ServiceHeader));
+            sendKeepAlive(KEEP_ALIVE_PONG, data, size);
         }
         else
         {
-            if (read_buffer_.size() < (sizeof(ServiceHeader) + header->length))
-            {
-                onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-                return;
-            }
-
-            if (header->length != keep_alive_counter_.size())
+            if (header.length != keep_alive_counter_.size())
             {
                 onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
                 return;
             }
 
             // Pong must contain the same data as ping.
-            if (memcmp(read_buffer_.data() + sizeof(ServiceHeader),
-                       keep_alive_counter_.data(),
-                       keep_alive_counter_.size()) != 0)
+            if (memcmp(data, keep_alive_counter_.data(), keep_alive_counter_.size()) != 0)
             {
                 onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
                 return;
@@ -727,8 +837,6 @@ void TcpChannel::onReadServiceData(const std::error_code& error_code, size_t byt
         onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
         return;
     }
-
-    doReadSize();
 }
 
 void TcpChannel::onKeepAliveInterval(const std::error_code& error_code)
@@ -796,8 +904,8 @@ void TcpChannel::sendKeepAlive(uint8_t flags, const void* data, size_t size)
     memcpy(buffer.data() + sizeof(uint8_t), &header, sizeof(header));
     memcpy(buffer.data() + sizeof(uint8_t) + sizeof(header), data, size);
 
-    // Add a task to the queue.
-    addWriteTask(WriteTask::Type::SERVICE_DATA, 0, std::move(buffer));
+    // Add a task to the queue. Service messages are not delayed by user data.
+    addWriteTask(WriteTask::Type::SERVICE_DATA, 0, std::move(buffer), Priority::HIGH);
 }
 
 } // namespace base
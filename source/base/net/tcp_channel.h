@@ -20,6 +20,8 @@
 #define BASE_NET_TCP_CHANNEL_H
 
 #include "base/memory/byte_array.h"
+#include "base/net/bandwidth_estimator.h"
+#include "base/net/message_chunker.h"
 #include "base/net/network_channel.h"
 #include "base/net/variable_size.h"
 #include "base/net/write_task.h"
@@ -28,7 +30,7 @@
 #include <asio/ip/tcp.hpp>
 #include <asio/high_resolution_timer.hpp>
 
-#include <queue>
+#include <deque>
 
 namespace base {
 
@@ -41,6 +43,8 @@ class TcpServer;
 class TcpChannel : public NetworkChannel
 {
 public:
+    using Priority = WriteTask::Priority;
+
     // Constructor available for client.
     TcpChannel();
     ~TcpChannel() override;
@@ -81,6 +85,10 @@ public:
     // then the return value is undefined.
     bool isPaused() const;
 
+    // Checks without reading data whether the peer has closed the connection. Used for channels
+    // that are not yet being read.
+    bool isPeerDisconnected();
+
     // Pauses the channel. After calling the method, new messages will not be read from the socket.
     // If at the time the method was called, the message was read, then notification of this
     // message will be received only after calling method resume().
@@ -90,8 +98,9 @@ public:
     void resume();
 
     // Sending a message. The method call is thread safe. After the call, the message will be added
-    // to the queue to be sent.
-    void send(uint8_t channel_id, ByteArray&& buffer);
+    // to the queue to be sent. Messages with a higher |priority| overtake the queued messages with
+    // a lower priority.
+    void send(uint8_t channel_id, ByteArray&& buffer, Priority priority = Priority::NORMAL);
 
     // Disable or enable the algorithm of Nagle.
     bool setNoDelay(bool enable);
@@ -104,10 +113,21 @@ public:
     void setChannelIdSupport(bool enable);
     bool hasChannelIdSupport() const;
 
+    // If enabled, large messages are written in chunks and the chunks of messages with a higher
+    // priority are interleaved with them. Both peers must enable it. Requires channel id support.
+    void setChunkingSupport(bool enable);
+    bool hasChunkingSupport() const;
+
     bool setReadBufferSize(size_t size);
     bool setWriteBufferSize(size_t size);
 
-    size_t pendingMessages() const { return write_queue_.size(); }
+    size_t pendingMessages() const { return write_queue_.pendingMessages(); }
+
+    // Returns the estimated bandwidth of the outgoing direction in bytes per second.
+    int64_t estimatedBandwidth() const { return bandwidth_estimator_.bandwidth(); }
+
+    // Returns true if the estimated bandwidth is limited by the channel, not by the sender.
+    bool isBandwidthMeasured() const { return bandwidth_estimator_.isMeasured(); }
 
     base::HostId hostId() const { return host_id_; }
     void setHostId(base::HostId host_id) { host_id_ = host_id; }
@@ -128,12 +148,9 @@ private:
 
     enum class ReadState
     {
-        IDLE,                // No reads are in progress right now.
-        READ_SIZE,           // Reading the message size.
-        READ_SERVICE_HEADER, // Reading the contents of the service header.
-        READ_SERVICE_DATA,   // Reading the contents of the service data.
-        READ_USER_DATA,      // Reading the contents of the user data.
-        PENDING              // There is a message about which we did not notify.
+        IDLE,      // No reads are in progress right now.
+        READING,   // Reading data from the socket.
+        PROCESSING // Received messages are being processed.
     };
 
     enum ServiceMessageType
@@ -159,24 +176,36 @@ private:
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
     void onErrorOccurred(const Location& location, ErrorCode error_code);
     void onMessageWritten(uint8_t channel_id);
-    void onMessageReceived();
+    void onMessageReceived(const uint8_t* data, size_t size);
+    void onServiceMessageReceived(const ServiceHeader& header, const uint8_t* data, size_t size);
 
-    void addWriteTask(WriteTask::Type type, uint8_t channel_id, ByteArray&& data);
+    void addWriteTask(WriteTask::Type type, uint8_t channel_id, ByteArray&& data,
+                      Priority priority);
 
+    // Moves the messages sent from other threads to the write queues. Returns false if there are
+    // no such messages.
+    bool reloadWriteQueues();
+
+    // Writes several messages (or chunks of messages) from the beginning of the queues with one
+    // operation, starting with the queue of the highest priority. All pieces of the batch are
+    // encrypted into |write_buffer_| one after another.
     void doWrite();
-    void onWrite(const std::error_code& error_code, size_t bytes_transferred);
 
-    void doReadSize();
-    void onReadSize(const std::error_code& error_code, size_t bytes_transferred);
+    // Returns the size of the frame for |size| bytes of |task| data or 0 if the message is too big.
+    size_t frameSize(const WriteTask& task, size_t size);
 
-    void doReadUserData(size_t length);
-    void onReadUserData(const std::error_code& error_code, size_t bytes_transferred);
+    // Writes |piece| of a message with its header to |buffer|. Returns the number of bytes written
+    // or 0 if encryption failed.
+    size_t writeMessage(const MessageChunker::Piece& piece, uint8_t* buffer);
+    void onWrite(const std::error_code& error_code, size_t bytes_transferred);
 
-    void doReadServiceHeader();
-    void onReadServiceHeader(const std::error_code& error_code, size_t bytes_transferred);
+    // Reads as much data as is available in the socket. |frame_size| is the full size of the
+    // incomplete message at the beginning of the buffer (if known).
+    void doRead(size_t frame_size);
+    void onRead(const std::error_code& error_code, size_t bytes_transferred);
 
-    void doReadServiceData(size_t length);
-    void onReadServiceData(const std::error_code& error_code, size_t bytes_transferred);
+    // Notifies about all complete messages in |read_buffer_| until the channel is paused.
+    void processReadBuffer();
 
     void onKeepAliveInterval(const std::error_code& error_code);
     void onKeepAliveTimeout(const std::error_code& error_code);
@@ -200,17 +229,26 @@ private:
     std::unique_ptr<MessageEncryptor> encryptor_;
     std::unique_ptr<MessageDecryptor> decryptor_;
 
-    std::queue<WriteTask> write_queue_;
+    // Queues of outgoing messages for each priority.
+    MessageChunker write_queue_;
+    std::deque<WriteTask> reload_queue_;
     VariableSizeWriter variable_size_writer_;
     ByteArray write_buffer_;
 
+    std::vector<uint8_t> written_channels_;
+    BandwidthEstimator bandwidth_estimator_;
+
     ReadState state_ = ReadState::IDLE;
-    VariableSizeReader variable_size_reader_;
     ByteArray read_buffer_;
+    size_t read_begin_ = 0; // Beginning of the unprocessed data in |read_buffer_|.
+    size_t read_end_ = 0; // End of the received data in |read_buffer_|.
     ByteArray decrypt_buffer_;
 
+    MessageAssembler message_assembler_;
+
     base::HostId host_id_ = base::kInvalidHostId;
     bool channel_id_support_ = false;
+    bool chunking_support_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(TcpChannel);
 };
@@ -31,7 +31,7 @@ TcpChannelProxy::TcpChannelProxy(
     // Nothing
 }
 
-void TcpChannelProxy::send(uint8_t channel_id, ByteArray&& buffer)
+void TcpChannelProxy::send(uint8_t channel_id, ByteArray&& buffer, TcpChannel::Priority priority)
 {
     bool schedule_write;
 
@@ -39,7 +39,8 @@ void TcpChannelProxy::send(uint8_t channel_id, ByteArray&& buffer)
         std::scoped_lock lock(incoming_queue_lock_);
 
         schedule_write = incoming_queue_.empty();
-        incoming_queue_.emplace(WriteTask::Type::USER_DATA, channel_id, std::move(buffer));
+        incoming_queue_.emplace_back(
+            WriteTask::Type::USER_DATA, channel_id, std::move(buffer), priority);
     }
 
     if (!schedule_write)
@@ -58,13 +59,15 @@ void TcpChannelProxy::scheduleWrite()
     if (!channel_)
         return;
 
-    if (!reloadWriteQueue(&channel_->write_queue_))
+    if (!channel_->reloadWriteQueues())
         return;
 
-    channel_->doWrite();
+    // If a write operation is in progress, the messages will be written after it is completed.
+    if (!channel_->write_queue_.isWriting())
+        channel_->doWrite();
 }
 
-bool TcpChannelProxy::reloadWriteQueue(std::queue<WriteTask>* work_queue)
+bool TcpChannelProxy::reloadWriteQueue(std::deque<WriteTask>* work_queue)
 {
     if (!work_queue->empty())
         return false;
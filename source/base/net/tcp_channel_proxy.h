@@ -30,7 +30,8 @@ class TaskRunner;
 class TcpChannelProxy : public std::enable_shared_from_this<TcpChannelProxy>
 {
 public:
-    void send(uint8_t channel_id, ByteArray&& buffer);
+    void send(uint8_t channel_id, ByteArray&& buffer,
+              TcpChannel::Priority priority = TcpChannel::Priority::NORMAL);
 
 private:
     friend class TcpChannel;
@@ -40,13 +41,13 @@ private:
     void willDestroyCurrentChannel();
 
     void scheduleWrite();
-    bool reloadWriteQueue(std::queue<WriteTask>* work_queue);
+    bool reloadWriteQueue(std::deque<WriteTask>* work_queue);
 
     std::shared_ptr<TaskRunner> task_runner_;
 
     TcpChannel* channel_;
 
-    std::queue<WriteTask> incoming_queue_;
+    std::deque<WriteTask> incoming_queue_;
     std::mutex incoming_queue_lock_;
 
     DISALLOW_COPY_AND_ASSIGN(TcpChannelProxy);
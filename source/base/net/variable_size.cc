@@ -20,47 +20,37 @@
 
 #include "base/logging.h"
 
-namespace base {
-
-VariableSizeReader::VariableSizeReader() = default;
-
-VariableSizeReader::~VariableSizeReader() = default;
-
-asio::mutable_buffer VariableSizeReader::buffer()
-{
-    DCHECK_LT(pos_, std::size(buffer_));
+#include <algorithm>
 
-    return asio::mutable_buffer(&buffer_[pos_], sizeof(uint8_t));
-}
+namespace base {
 
-std::optional<size_t> VariableSizeReader::messageSize()
+// static
+size_t VariableSizeReader::read(const uint8_t* data, size_t size, size_t* message_size)
 {
-    DCHECK_LT(pos_, std::size(buffer_));
+    DCHECK(data || !size);
+    DCHECK(message_size);
 
-    if (pos_ == 3 || !(buffer_[pos_] & 0x80))
+    for (size_t pos = 0; pos < std::min(size, size_t(4)); ++pos)
     {
-        size_t result = buffer_[0] & 0x7F;
+        if (pos != 3 && (data[pos] & 0x80))
+            continue;
 
-        if (pos_ >= 1)
-            result += (buffer_[1] & 0x7F) << 7;
+        size_t result = data[0] & 0x7F;
 
-        if (pos_ >= 2)
-            result += (buffer_[2] & 0x7F) << 14;
+        if (pos >= 1)
+            result += (data[1] & 0x7F) << 7;
 
-        if (pos_ >= 3)
-            result += buffer_[3] << 21;
+        if (pos >= 2)
+            result += (data[2] & 0x7F) << 14;
 
-        memset(buffer_, 0, std::size(buffer_));
-        pos_ = 0;
+        if (pos >= 3)
+            result += static_cast<size_t>(data[3]) << 21;
 
-        return result;
+        *message_size = result;
+        return pos + 1;
     }
-    else
-    {
-        ++pos_;
 
-        return std::nullopt;
-    }
+    return 0;
 }
 
 VariableSizeWriter::VariableSizeWriter() = default;
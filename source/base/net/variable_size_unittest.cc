@@ -0,0 +1,61 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/variable_size.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(VariableSizeTest, WriteRead)
+{
+    const size_t kTestTable[] =
+    {
+        0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0x1FFFF, 0x20000, 0x7FFFFFF, 0x1FFFFFFF
+    };
+
+    const size_t kExpectedLength[] = { 1, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+
+    for (size_t i = 0; i < std::size(kTestTable); ++i)
+    {
+        VariableSizeWriter writer;
+        asio::const_buffer buffer = writer.variableSize(kTestTable[i]);
+        EXPECT_EQ(buffer.size(), kExpectedLength[i]);
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+        size_t message_size = 0;
+
+        // Incomplete size.
+        for (size_t j = 0; j < buffer.size(); ++j)
+            EXPECT_EQ(VariableSizeReader::read(data, j, &message_size), 0U);
+
+        EXPECT_EQ(VariableSizeReader::read(data, buffer.size(), &message_size), buffer.size());
+        EXPECT_EQ(message_size, kTestTable[i]);
+    }
+}
+
+TEST(VariableSizeTest, ReadWithPayload)
+{
+    const uint8_t kData[] = { 0x85, 0x01, 0xAA, 0xBB };
+
+    size_t message_size = 0;
+    EXPECT_EQ(VariableSizeReader::read(kData, std::size(kData), &message_size), 2U);
+    EXPECT_EQ(message_size, 0x85U);
+}
+
+} // namespace base
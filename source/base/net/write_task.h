@@ -19,8 +19,11 @@
 #ifndef BASE_NET_WRITE_TASK_H
 #define BASE_NET_WRITE_TASK_H
 
+#include "base/macros_magic.h"
 #include "base/memory/byte_array.h"
 
+#include <chrono>
+
 namespace base {
 
 class WriteTask
@@ -28,22 +31,42 @@ class WriteTask
 public:
     enum class Type { SERVICE_DATA, USER_DATA };
 
-    WriteTask(Type type, uint8_t channel_id, ByteArray&& data)
+    // Messages with a higher priority are written before the messages with a lower priority that
+    // were added earlier. The order of messages with the same priority is kept.
+    enum class Priority { HIGH = 0, NORMAL = 1, LOW = 2 };
+    static constexpr size_t kPriorityCount = 3;
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    WriteTask(Type type, uint8_t channel_id, ByteArray&& data, Priority priority = Priority::NORMAL)
         : type_(type),
           channel_id_(channel_id),
-          data_(std::move(data))
+          priority_(priority),
+          data_(std::move(data)),
+          time_(std::chrono::steady_clock::now())
     {
         // Nothing
     }
 
+    WriteTask(WriteTask&& other) = default;
+    WriteTask& operator=(WriteTask&& other) = default;
+
     Type type() const { return type_; }
     uint8_t channelId() const { return channel_id_; }
+    Priority priority() const { return priority_; }
     const ByteArray& data() const { return data_; }
 
+    // Time when the task was added to the queue.
+    const TimePoint& time() const { return time_; }
+
 private:
-    const Type type_;
-    const uint8_t channel_id_;
-    const ByteArray data_;
+    Type type_;
+    uint8_t channel_id_;
+    Priority priority_;
+    ByteArray data_;
+    TimePoint time_;
+
+    DISALLOW_COPY_AND_ASSIGN(WriteTask);
 };
 
 } // namespace base
@@ -28,7 +28,6 @@ namespace base {
 namespace {
 
 constexpr uint8_t kChannelIdAuthenticator = 0;
-constexpr std::chrono::minutes kTimeout{ 1 };
 
 } // namespace
 
@@ -63,7 +62,7 @@ void Authenticator::start(std::unique_ptr<TcpChannel> channel, Callback callback
 
     // If authentication does not complete within the specified time interval, an error will be
     // raised.
-    timer_.start(kTimeout, std::bind(
+    timer_.start(timeout_, std::bind(
         &Authenticator::finish, this, FROM_HERE, ErrorCode::UNKNOWN_ERROR));
 
     channel_->setListener(this);
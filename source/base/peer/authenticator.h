@@ -54,11 +54,24 @@ public:
 
     using Callback = std::function<void(ErrorCode error_code)>;
 
+    // If authentication does not complete within this interval, it fails.
+    static constexpr std::chrono::minutes kDefaultTimeout { 1 };
+
+    // Sets the authentication timeout. Must be called before start().
+    void setTimeout(const std::chrono::milliseconds& timeout) { timeout_ = timeout; }
+
+    // Sets the optional channel features (see proto::ChannelFeature) which this peer uses if the
+    // remote peer supports them too. Must be called before start().
+    void setFeatures(uint32_t features) { features_ = features; }
+
     void start(std::unique_ptr<TcpChannel> channel, Callback callback);
 
     [[nodiscard]] proto::Identify identify() const { return identify_; }
     [[nodiscard]] proto::Encryption encryption() const { return encryption_; }
     [[nodiscard]] const Version& peerVersion() const { return peer_version_; }
+
+    // Returns the channel features which are supported by both peers.
+    [[nodiscard]] uint32_t negotiatedFeatures() const { return features_ & peer_features_; }
     [[nodiscard]] const std::string& peerOsName() const { return peer_os_name_; }
     [[nodiscard]] const std::string& peerComputerName() const { return peer_computer_name_; }
     [[nodiscard]] uint32_t sessionType() const { return session_type_; }
@@ -84,6 +97,7 @@ protected:
     void setPeerVersion(const proto::Version& version);
     void setPeerOsName(const std::string& name);
     void setPeerComputerName(const std::string& name);
+    void setPeerFeatures(uint32_t features) { peer_features_ = features; }
 
     // base::TcpChannel::Listener implementation.
     void onTcpConnected() final;
@@ -100,16 +114,19 @@ protected:
     ByteArray decrypt_iv_;
 
     uint32_t session_type_ = 0; // Selected session type.
+    uint32_t features_ = 0; // Channel features supported by this peer.
     std::string user_name_;
 
 private:
     WaitableTimer timer_;
+    std::chrono::milliseconds timeout_ = kDefaultTimeout;
     std::unique_ptr<TcpChannel> channel_;
     Callback callback_;
     State state_ = State::STOPPED;
     Version peer_version_; // Remote peer version.
     std::string peer_os_name_;
     std::string peer_computer_name_;
+    uint32_t peer_features_ = 0;
 };
 
 } // namespace base
@@ -416,6 +416,7 @@ bool ClientAuthenticator::readSessionChallenge(const ByteArray& buffer)
     setPeerVersion(challenge->version());
     setPeerOsName(challenge->os_name());
     setPeerComputerName(challenge->computer_name());
+    setPeerFeatures(challenge->features());
 
     LOG(LS_INFO) << "Server Version: " << peerVersion();
     LOG(LS_INFO) << "Server Name: " << challenge->computer_name();
@@ -439,6 +440,7 @@ void ClientAuthenticator::sendSessionResponse()
     response->set_os_name(SysInfo::operatingSystemName());
     response->set_computer_name(SysInfo::computerName());
     response->set_cpu_cores(static_cast<uint32_t>(SysInfo::processorThreads()));
+    response->set_features(features_);
 
     LOG(LS_INFO) << "Sending: SessionResponse";
     sendMessage(*response);
@@ -23,12 +23,14 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/sys_info.h"
+#include "base/task_runner.h"
 #include "base/crypto/generic_hash.h"
 #include "base/crypto/random.h"
 #include "base/crypto/srp_constants.h"
 #include "base/crypto/srp_math.h"
 #include "base/peer/user_list.h"
 #include "base/strings/unicode.h"
+#include "base/threading/thread_pool.h"
 
 namespace base {
 
@@ -54,14 +56,18 @@ const char* identifyToString(proto::Identify identify)
 } // namespace
 
 ServerAuthenticator::ServerAuthenticator(std::shared_ptr<TaskRunner> task_runner)
-    : Authenticator(std::move(task_runner))
+    : Authenticator(task_runner),
+      task_runner_(std::move(task_runner)),
+      alive_token_(std::make_shared<int>(0))
 {
     LOG(LS_INFO) << "Ctor";
+    DCHECK(task_runner_);
 }
 
 ServerAuthenticator::~ServerAuthenticator()
 {
     LOG(LS_INFO) << "Dtor";
+    alive_token_.reset();
 }
 
 void ServerAuthenticator::setUserList(base::local_shared_ptr<UserListBase> user_list)
@@ -132,6 +138,11 @@ bool ServerAuthenticator::setAnonymousAccess(
     return true;
 }
 
+void ServerAuthenticator::setCryptoPool(std::shared_ptr<ThreadPool> crypto_pool)
+{
+    crypto_pool_ = std::move(crypto_pool);
+}
+
 bool ServerAuthenticator::onStarted()
 {
     internal_state_ = InternalState::READ_CLIENT_HELLO;
@@ -174,6 +185,14 @@ bool ServerAuthenticator::onStarted()
 
 void ServerAuthenticator::onReceived(const ByteArray& buffer)
 {
+    if (crypto_pending_)
+    {
+        // The peer must wait for our reply before sending the next message.
+        LOG(LS_ERROR) << "Unexpected message while calculation is in progress";
+        finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
+        return;
+    }
+
     switch (internal_state_)
     {
         case InternalState::READ_CLIENT_HELLO:
@@ -311,8 +330,6 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
         }
     }
 
-    std::unique_ptr<proto::ServerHello> server_hello = std::make_unique<proto::ServerHello>();
-
     if (key_pair_.isValid())
     {
         ByteArray peer_public_key = fromStdString(client_hello->public_key());
@@ -326,25 +343,53 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
 
         if (!peer_public_key.empty() && !decrypt_iv_.empty())
         {
-            ByteArray temp = key_pair_.sessionKey(peer_public_key);
-            if (temp.empty())
+            struct Job
             {
-                finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
-                return;
-            }
+                KeyPair key_pair;
+                ByteArray peer_public_key;
+                ByteArray session_key;
+            };
+
+            std::shared_ptr<Job> job = std::make_shared<Job>();
+            job->key_pair = std::move(key_pair_);
+            job->peer_public_key = std::move(peer_public_key);
 
-            session_key_ = GenericHash::hash(GenericHash::Type::BLAKE2s256, temp);
-            if (session_key_.empty())
+            postCryptoTask([job]()
             {
-                finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
-                return;
-            }
+                ByteArray temp = job->key_pair.sessionKey(job->peer_public_key);
+                if (!temp.empty())
+                    job->session_key = GenericHash::hash(GenericHash::Type::BLAKE2s256, temp);
+            },
+            [this, job, encryption]()
+            {
+                key_pair_ = std::move(job->key_pair);
 
-            DCHECK(!encrypt_iv_.empty());
-            server_hello->set_iv(toStdString(encrypt_iv_));
+                if (job->session_key.empty())
+                {
+                    finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
+                    return;
+                }
+
+                session_key_ = std::move(job->session_key);
+                doServerHello(encryption);
+            });
+            return;
         }
     }
 
+    doServerHello(encryption);
+}
+
+void ServerAuthenticator::doServerHello(uint32_t encryption)
+{
+    std::unique_ptr<proto::ServerHello> server_hello = std::make_unique<proto::ServerHello>();
+
+    if (!session_key_.empty())
+    {
+        DCHECK(!encrypt_iv_.empty());
+        server_hello->set_iv(toStdString(encrypt_iv_));
+    }
+
     bool has_aes_ni = false;
 
 #if defined(ARCH_CPU_X86_FAMILY)
@@ -393,6 +438,22 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
 
     LOG(LS_INFO) << "Username: '" << user_name_ << "'";
 
+    struct Job
+    {
+        BigNum N;
+        BigNum g;
+        BigNum s;
+        BigNum v;
+        BigNum b;
+        BigNum B;
+
+        // If the user is not found, the verifier is calculated from the seed key.
+        std::u16string user_name;
+        ByteArray seed_key;
+    };
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+
     do
     {
         std::u16string user_name_utf16 = base::utf16FromUtf8(user_name_);
@@ -429,10 +490,10 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
             std::optional<SrpNgPair> Ng_pair = pairByGroup(user.group);
             if (Ng_pair.has_value())
             {
-                N_ = BigNum::fromStdString(Ng_pair->first);
-                g_ = BigNum::fromStdString(Ng_pair->second);
-                s_ = BigNum::fromByteArray(user.salt);
-                v_ = BigNum::fromByteArray(user.verifier);
+                job->N = BigNum::fromStdString(Ng_pair->first);
+                job->g = BigNum::fromStdString(Ng_pair->second);
+                job->s = BigNum::fromByteArray(user.salt);
+                job->v = BigNum::fromByteArray(user.verifier);
                 break;
             }
             else
@@ -447,16 +508,38 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
         hash.addData(seed_key);
         hash.addData(user_name_);
 
-        N_ = BigNum::fromStdString(kSrpNgPair_8192.first);
-        g_ = BigNum::fromStdString(kSrpNgPair_8192.second);
-        s_ = BigNum::fromByteArray(hash.result());
-        v_ = SrpMath::calc_v(user_name_utf16, seed_key, s_, N_, g_);
+        job->N = BigNum::fromStdString(kSrpNgPair_8192.first);
+        job->g = BigNum::fromStdString(kSrpNgPair_8192.second);
+        job->s = BigNum::fromByteArray(hash.result());
+        job->user_name = std::move(user_name_utf16);
+        job->seed_key = std::move(seed_key);
     }
     while (false);
 
-    b_ = BigNum::fromByteArray(Random::byteArray(128)); // 1024 bits.
-    B_ = SrpMath::calc_B(b_, N_, g_, v_);
+    job->b = BigNum::fromByteArray(Random::byteArray(128)); // 1024 bits.
 
+    postCryptoTask([job]()
+    {
+        if (!job->seed_key.empty())
+            job->v = SrpMath::calc_v(job->user_name, job->seed_key, job->s, job->N, job->g);
+
+        job->B = SrpMath::calc_B(job->b, job->N, job->g, job->v);
+    },
+    [this, job]()
+    {
+        N_ = std::move(job->N);
+        g_ = std::move(job->g);
+        s_ = std::move(job->s);
+        v_ = std::move(job->v);
+        b_ = std::move(job->b);
+        B_ = std::move(job->B);
+
+        doServerKeyExchange();
+    });
+}
+
+void ServerAuthenticator::doServerKeyExchange()
+{
     if (!N_.isValid() || !g_.isValid() || !s_.isValid() || !B_.isValid())
     {
         finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
@@ -500,7 +583,36 @@ void ServerAuthenticator::onClientKeyExchange(const ByteArray& buffer)
         return;
     }
 
-    ByteArray srp_key = createSrpKey();
+    struct Job
+    {
+        BigNum A;
+        BigNum B;
+        BigNum N;
+        BigNum v;
+        BigNum b;
+        ByteArray srp_key;
+    };
+
+    // SRP parameters are no longer needed after the key is calculated.
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->A = std::move(A_);
+    job->B = std::move(B_);
+    job->N = std::move(N_);
+    job->v = std::move(v_);
+    job->b = std::move(b_);
+
+    postCryptoTask([job]()
+    {
+        job->srp_key = createSrpKey(job->A, job->B, job->N, job->v, job->b);
+    },
+    [this, job]()
+    {
+        onSrpKeyReady(job->srp_key);
+    });
+}
+
+void ServerAuthenticator::onSrpKeyReady(const ByteArray& srp_key)
+{
     if (srp_key.empty())
     {
         finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
@@ -552,6 +664,7 @@ void ServerAuthenticator::doSessionChallenge()
     session_challenge->set_os_name(SysInfo::operatingSystemName());
     session_challenge->set_computer_name(SysInfo::computerName());
     session_challenge->set_cpu_cores(static_cast<uint32_t>(SysInfo::processorThreads()));
+    session_challenge->set_features(features_);
 
     LOG(LS_INFO) << "Sending: SessionChallenge";
     sendMessage(*session_challenge);
@@ -572,6 +685,7 @@ void ServerAuthenticator::onSessionResponse(const ByteArray& buffer)
     setPeerVersion(session_response->version());
     setPeerOsName(session_response->os_name());
     setPeerComputerName(session_response->computer_name());
+    setPeerFeatures(session_response->features());
 
     LOG(LS_INFO) << "Client Session Type: " << session_response->session_type();
     LOG(LS_INFO) << "Client Version: " << peerVersion();
@@ -597,18 +711,61 @@ void ServerAuthenticator::onSessionResponse(const ByteArray& buffer)
     finish(FROM_HERE, ErrorCode::SUCCESS);
 }
 
-ByteArray ServerAuthenticator::createSrpKey()
+// static
+ByteArray ServerAuthenticator::createSrpKey(
+    const BigNum& A, const BigNum& B, const BigNum& N, const BigNum& v, const BigNum& b)
 {
-    if (!SrpMath::verify_A_mod_N(A_, N_))
+    if (!SrpMath::verify_A_mod_N(A, N))
     {
         LOG(LS_ERROR) << "SrpMath::verify_A_mod_N failed";
         return ByteArray();
     }
 
-    BigNum u = SrpMath::calc_u(A_, B_, N_);
-    BigNum server_key = SrpMath::calcServerKey(A_, v_, u, b_, N_);
+    BigNum u = SrpMath::calc_u(A, B, N);
+    BigNum server_key = SrpMath::calcServerKey(A, v, u, b, N);
 
     return server_key.toByteArray();
 }
 
+void ServerAuthenticator::postCryptoTask(CryptoTask work, CryptoTask reply)
+{
+    if (!crypto_pool_)
+    {
+        work();
+        reply();
+        return;
+    }
+
+    crypto_pending_ = true;
+
+    std::weak_ptr<int> alive_token = alive_token_;
+    std::shared_ptr<TaskRunner> task_runner = task_runner_;
+
+    crypto_pool_->postTask([this, alive_token, task_runner, work, reply]()
+    {
+        work();
+
+        task_runner->postTask([this, alive_token, reply]()
+        {
+            // The authenticator can be destroyed while the calculation is in progress.
+            if (alive_token.expired())
+                return;
+
+            onCryptoTaskDone(reply);
+        });
+    });
+}
+
+void ServerAuthenticator::onCryptoTaskDone(const CryptoTask& reply)
+{
+    DCHECK(task_runner_->belongsToCurrentThread());
+    crypto_pending_ = false;
+
+    // Authentication could be finished by a timeout or a network error.
+    if (state() != State::PENDING)
+        return;
+
+    reply();
+}
+
 } // namespace base
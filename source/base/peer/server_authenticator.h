@@ -27,6 +27,7 @@
 
 namespace base {
 
+class ThreadPool;
 class UserListBase;
 
 class ServerAuthenticator : public Authenticator
@@ -53,6 +54,11 @@ public:
     // By default, anonymous access is disabled.
     [[nodiscard]] bool setAnonymousAccess(AnonymousAccess anonymous_access, uint32_t session_types);
 
+    // Sets the pool on which key agreement and SRP calculations are performed. The results are
+    // returned to the task runner of the authenticator. If the pool is not set, the calculations
+    // are performed on the task runner.
+    void setCryptoPool(std::shared_ptr<ThreadPool> crypto_pool);
+
 protected:
     // Authenticator implementation.
     [[nodiscard]] bool onStarted() override;
@@ -60,12 +66,30 @@ protected:
     void onWritten() override;
 
 private:
+    using CryptoTask = std::function<void()>;
+
     void onClientHello(const ByteArray& buffer);
+    void doServerHello(uint32_t encryption);
     void onIdentify(const ByteArray& buffer);
+    void doServerKeyExchange();
     void onClientKeyExchange(const ByteArray& buffer);
+    void onSrpKeyReady(const ByteArray& srp_key);
     void doSessionChallenge();
     void onSessionResponse(const ByteArray& buffer);
-    [[nodiscard]] ByteArray createSrpKey();
+    [[nodiscard]] static ByteArray createSrpKey(
+        const BigNum& A, const BigNum& B, const BigNum& N, const BigNum& v, const BigNum& b);
+
+    // Executes |work| on the crypto pool and then |reply| on the task runner. |work| must not
+    // access members of the authenticator, because it can be destroyed before |work| completes.
+    void postCryptoTask(CryptoTask work, CryptoTask reply);
+    void onCryptoTaskDone(const CryptoTask& reply);
+
+    std::shared_ptr<TaskRunner> task_runner_;
+    std::shared_ptr<ThreadPool> crypto_pool_;
+
+    // Replies from the crypto pool are ignored after the token is destroyed.
+    std::shared_ptr<int> alive_token_;
+    bool crypto_pending_ = false;
 
     base::local_shared_ptr<UserListBase> user_list_;
 
@@ -21,6 +21,7 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/peer/user_list_base.h"
+#include "base/threading/thread_pool.h"
 
 namespace base {
 
@@ -56,13 +57,71 @@ void ServerAuthenticatorManager::setAnonymousAccess(
     anonymous_session_types_ = session_types;
 }
 
+void ServerAuthenticatorManager::setFeatures(uint32_t features)
+{
+    features_ = features;
+}
+
+void ServerAuthenticatorManager::setCryptoThreads(size_t count)
+{
+    crypto_pool_ = std::make_shared<ThreadPool>(count);
+    LOG(LS_INFO) << "Crypto pool started with " << crypto_pool_->threadCount() << " threads";
+}
+
+void ServerAuthenticatorManager::setMaxConcurrentHandshakes(size_t count)
+{
+    max_concurrent_handshakes_ = count;
+}
+
 void ServerAuthenticatorManager::addNewChannel(std::unique_ptr<TcpChannel> channel)
 {
     DCHECK(channel);
 
+    if (max_concurrent_handshakes_ && pending_.size() >= max_concurrent_handshakes_)
+    {
+        Clock::time_point now = Clock::now();
+
+        removeExpiredChannels(now);
+        if (waiting_.size() >= kMaxWaitingChannels)
+            removeDisconnectedChannels();
+
+        if (waiting_.size() >= kMaxWaitingChannels)
+        {
+            // The channel is closed when it is destroyed.
+            LOG(LS_WARNING) << "Waiting queue is full (" << waiting_.size()
+                            << "). Channel rejected: " << channel->peerAddress();
+            return;
+        }
+
+        // The channel will be started after one of the current authentications is completed.
+        waiting_.push_back({ std::move(channel), now });
+
+        LOG(LS_INFO) << "Too many authentications in progress (" << pending_.size()
+                     << "). Channel added to the waiting queue (waiting: " << waiting_.size()
+                     << ", crypto queue: " << cryptoQueueDepth() << ")";
+        return;
+    }
+
+    startAuthenticator(std::move(channel), Authenticator::kDefaultTimeout);
+}
+
+size_t ServerAuthenticatorManager::cryptoQueueDepth() const
+{
+    if (!crypto_pool_)
+        return 0;
+
+    return crypto_pool_->pendingTasks();
+}
+
+void ServerAuthenticatorManager::startAuthenticator(std::unique_ptr<TcpChannel> channel,
+                                                    const std::chrono::milliseconds& timeout)
+{
     std::unique_ptr<ServerAuthenticator> authenticator =
         std::make_unique<ServerAuthenticator>(task_runner_);
+    authenticator->setTimeout(timeout);
     authenticator->setUserList(user_list_);
+    authenticator->setCryptoPool(crypto_pool_);
+    authenticator->setFeatures(features_);
 
     if (!private_key_.empty())
     {
@@ -108,6 +167,7 @@ void ServerAuthenticatorManager::onComplete()
                     session_info.computer_name = current->peerComputerName();
                     session_info.user_name     = current->userName();
                     session_info.session_type  = current->sessionType();
+                    session_info.features      = current->negotiatedFeatures();
 
                     delegate_->onNewSession(std::move(session_info));
                 }
@@ -128,6 +188,57 @@ void ServerAuthenticatorManager::onComplete()
                 return;
         }
     }
+
+    Clock::time_point now = Clock::now();
+    removeExpiredChannels(now);
+
+    while (!waiting_.empty() &&
+           (!max_concurrent_handshakes_ || pending_.size() < max_concurrent_handshakes_))
+    {
+        WaitingChannel waiting_channel = std::move(waiting_.front());
+        waiting_.pop_front();
+
+        if (waiting_channel.channel->isPeerDisconnected())
+        {
+            LOG(LS_INFO) << "Waiting channel is disconnected: "
+                         << waiting_channel.channel->peerAddress();
+            continue;
+        }
+
+        // The time spent in the queue is counted against the authentication timeout.
+        std::chrono::milliseconds timeout = Authenticator::kDefaultTimeout -
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - waiting_channel.start_time);
+
+        startAuthenticator(std::move(waiting_channel.channel), timeout);
+    }
+}
+
+void ServerAuthenticatorManager::removeExpiredChannels(const Clock::time_point& now)
+{
+    // Channels are queued in order of arrival, so the oldest ones are at the front.
+    while (!waiting_.empty() && now - waiting_.front().start_time >= Authenticator::kDefaultTimeout)
+    {
+        LOG(LS_INFO) << "Authentication timeout for waiting channel: "
+                     << waiting_.front().channel->peerAddress();
+        waiting_.pop_front();
+    }
+}
+
+void ServerAuthenticatorManager::removeDisconnectedChannels()
+{
+    for (auto it = waiting_.begin(); it != waiting_.end();)
+    {
+        if (it->channel->isPeerDisconnected())
+        {
+            LOG(LS_INFO) << "Waiting channel is disconnected: " << it->channel->peerAddress();
+            it = waiting_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
 }
 
 } // namespace base
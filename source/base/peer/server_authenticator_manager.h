@@ -21,6 +21,8 @@
 
 #include "base/peer/server_authenticator.h"
 
+#include <deque>
+
 namespace base {
 
 class ServerAuthenticatorManager
@@ -42,6 +44,7 @@ public:
         std::string computer_name;
         std::string user_name;
         uint32_t session_type = 0;
+        uint32_t features = 0; // Channel features supported by both peers.
     };
 
     class Delegate
@@ -63,14 +66,59 @@ public:
     void setAnonymousAccess(
         ServerAuthenticator::AnonymousAccess anonymous_access, uint32_t session_types);
 
+    // Sets the optional channel features (see proto::ChannelFeature) offered to the clients.
+    void setFeatures(uint32_t features);
+
+    // Creates a pool of |count| threads for cryptographic calculations of authenticators. If the
+    // method is not called, the calculations are performed on the task runner. If |count| is 0,
+    // the number of threads is equal to the number of processor threads.
+    void setCryptoThreads(size_t count);
+
+    // Sets the maximum number of simultaneous authentications. Channels above the limit are
+    // waiting in the queue (at most |kMaxWaitingChannels|). The authentication timeout of a
+    // waiting channel starts when it is queued. If |count| is 0, the number is unlimited (by
+    // default).
+    void setMaxConcurrentHandshakes(size_t count);
+
+    static const size_t kMaxWaitingChannels = 1024;
+
     // Adds a channel to the authentication queue. After success completion, a session will be
     // created (in a stopped state) and method Delegate::onNewSession will be called.
     // If authentication fails, the channel will be automatically deleted.
     void addNewChannel(std::unique_ptr<TcpChannel> channel);
 
+    // Number of authentications in progress.
+    size_t pendingCount() const { return pending_.size(); }
+
+    // Number of channels waiting for the start of authentication.
+    size_t waitingCount() const { return waiting_.size(); }
+
+    // Number of calculations waiting for a free thread in the crypto pool.
+    size_t cryptoQueueDepth() const;
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct WaitingChannel
+    {
+        std::unique_ptr<TcpChannel> channel;
+        Clock::time_point start_time;
+    };
+
+    void startAuthenticator(std::unique_ptr<TcpChannel> channel,
+                            const std::chrono::milliseconds& timeout);
     void onComplete();
 
+    // Removes waiting channels whose authentication time is over.
+    void removeExpiredChannels(const Clock::time_point& now);
+
+    // Removes waiting channels closed by the peer.
+    void removeDisconnectedChannels();
+
+    std::shared_ptr<ThreadPool> crypto_pool_;
+    size_t max_concurrent_handshakes_ = 0;
+    std::deque<WaitingChannel> waiting_;
+
     std::shared_ptr<TaskRunner> task_runner_;
     base::local_shared_ptr<UserListBase> user_list_;
     std::vector<std::unique_ptr<ServerAuthenticator>> pending_;
@@ -81,6 +129,7 @@ private:
         ServerAuthenticator::AnonymousAccess::DISABLE;
 
     uint32_t anonymous_session_types_ = 0;
+    uint32_t features_ = 0;
 
     Delegate* delegate_;
 
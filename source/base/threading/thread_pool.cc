@@ -0,0 +1,95 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (!thread_count)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+    threads_.reserve(thread_count);
+
+    for (size_t i = 0; i < thread_count; ++i)
+        threads_.emplace_back(&ThreadPool::threadMain, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+    }
+
+    event_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+void ThreadPool::postTask(Task task)
+{
+    DCHECK(task);
+
+    {
+        std::scoped_lock lock(lock_);
+        queue_.emplace(std::move(task));
+    }
+
+    event_.notify_one();
+}
+
+size_t ThreadPool::pendingTasks() const
+{
+    std::scoped_lock lock(lock_);
+    return queue_.size();
+}
+
+void ThreadPool::threadMain()
+{
+    for (;;)
+    {
+        Task task;
+
+        {
+            std::unique_lock lock(lock_);
+
+            while (!stopping_ && queue_.empty())
+                event_.wait(lock);
+
+            if (stopping_)
+                return;
+
+            task = std::move(queue_.front());
+            queue_.pop();
+        }
+
+        task();
+    }
+}
+
+} // namespace base
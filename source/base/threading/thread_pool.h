@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE_THREADING_THREAD_POOL_H
+#define BASE_THREADING_THREAD_POOL_H
+
+#include "base/macros_magic.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+// A fixed set of threads that execute tasks from a shared queue. Tasks are executed in the
+// order in which they were posted, but may run concurrently. Pending tasks that have not started
+// when the pool is destroyed are discarded.
+class ThreadPool
+{
+public:
+    // If |thread_count| is 0, the number of hardware threads is used.
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    using Task = std::function<void()>;
+
+    // Adds a task to the queue. May be called from any thread.
+    void postTask(Task task);
+
+    // Returns the number of threads in the pool.
+    size_t threadCount() const { return threads_.size(); }
+
+    // Returns the number of tasks that are waiting in the queue.
+    size_t pendingTasks() const;
+
+private:
+    void threadMain();
+
+    std::vector<std::thread> threads_;
+
+    mutable std::mutex lock_;
+    std::condition_variable event_;
+    std::queue<Task> queue_;
+    bool stopping_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
+} // namespace base
+
+#endif // BASE_THREADING_THREAD_POOL_H
@@ -0,0 +1,68 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace base {
+
+TEST(ThreadPoolTest, ThreadCount)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.threadCount(), 3U);
+
+    ThreadPool default_pool;
+    EXPECT_GE(default_pool.threadCount(), 1U);
+}
+
+TEST(ThreadPoolTest, RunTasks)
+{
+    static const int kTaskCount = 1000;
+
+    std::atomic_int counter = 0;
+    std::mutex lock;
+    std::condition_variable event;
+
+    {
+        ThreadPool pool(4);
+
+        for (int i = 0; i < kTaskCount; ++i)
+        {
+            pool.postTask([&]()
+            {
+                if (++counter == kTaskCount)
+                {
+                    std::scoped_lock scoped_lock(lock);
+                    event.notify_one();
+                }
+            });
+        }
+
+        std::unique_lock unique_lock(lock);
+        event.wait(unique_lock, [&]() { return counter == kTaskCount; });
+    }
+
+    EXPECT_EQ(counter, kTaskCount);
+}
+
+} // namespace base
@@ -282,6 +282,7 @@ void Client::startAuthentication()
     authenticator_->setUserName(config_.username);
     authenticator_->setPassword(config_.password);
     authenticator_->setSessionType(static_cast<uint32_t>(config_.session_type));
+    authenticator_->setFeatures(proto::CHANNEL_FEATURE_CHUNKING);
 
     authenticator_->start(std::move(channel_),
                           [this](base::ClientAuthenticator::ErrorCode error_code)
@@ -299,6 +300,14 @@ void Client::startAuthentication()
             {
                 LOG(LS_INFO) << "Using channel id support";
                 channel_->setChannelIdSupport(true);
+
+                // Chunking changes the format of messages, so it is used only if the host
+                // reports it.
+                if (authenticator_->negotiatedFeatures() & proto::CHANNEL_FEATURE_CHUNKING)
+                {
+                    LOG(LS_INFO) << "Using chunking support";
+                    channel_->setChunkingSupport(true);
+                }
             }
 
             status_window_proxy_->onConnected();
@@ -24,8 +24,10 @@
 #include "base/codec/audio_decoder_opus.h"
 #include "base/codec/cursor_decoder.h"
 #include "base/codec/video_decoder.h"
+#include "base/codec/video_tile_cache.h"
 #include "base/codec/webm_file_writer.h"
 #include "base/codec/webm_video_encoder.h"
+#include "base/desktop/frame.h"
 #include "base/desktop/mouse_cursor.h"
 #include "client/desktop_control_proxy.h"
 #include "client/desktop_window.h"
@@ -423,6 +425,7 @@ void ClientDesktop::onMetricsRequest()
     metrics.total_tx = totalTx();
     metrics.speed_rx = speedRx();
     metrics.speed_tx = speedTx();
+    metrics.host_bandwidth = host_bandwidth_;
 
     if (min_video_packet_ != std::numeric_limits<size_t>::max())
         metrics.min_video_packet = min_video_packet_;
@@ -571,7 +574,38 @@ void ClientDesktop::readVideoPacket(const proto::VideoPacket& packet)
     min_video_packet_ = std::min(min_video_packet_, packet_size);
     max_video_packet_ = std::max(max_video_packet_, packet_size);
 
-    desktop_window_proxy_->drawFrame();
+    if (packet.bandwidth())
+        host_bandwidth_ = packet.bandwidth();
+
+    // The decoder changes only the moved areas, the cached tiles and the dirty rectangles of the
+    // frame. Only they need to be redrawn.
+    base::Region updated_region;
+
+    for (int i = 0; i < packet.copy_rect_size(); ++i)
+    {
+        const proto::VideoCopyRect& copy_rect = packet.copy_rect(i);
+        updated_region.addRect(base::Rect::makeXYWH(
+            copy_rect.target_x(), copy_rect.target_y(),
+            copy_rect.source_rect().width(), copy_rect.source_rect().height()));
+    }
+
+    for (int i = 0; i < packet.cached_tile_size(); ++i)
+    {
+        const proto::VideoCachedTile& tile = packet.cached_tile(i);
+        updated_region.addRect(base::Rect::makeXYWH(
+            tile.x(), tile.y(), base::VideoTileCache::kTileSize, base::VideoTileCache::kTileSize));
+    }
+
+    for (int i = 0; i < packet.dirty_rect_size(); ++i)
+    {
+        const proto::Rect& dirty_rect = packet.dirty_rect(i);
+        updated_region.addRect(base::Rect::makeXYWH(
+            dirty_rect.x(), dirty_rect.y(), dirty_rect.width(), dirty_rect.height()));
+    }
+
+    updated_region.intersectWith(base::Rect::makeSize(desktop_frame_->size()));
+
+    desktop_window_proxy_->drawFrame(updated_region);
 }
 
 void ClientDesktop::readAudioPacket(const proto::AudioPacket& packet)
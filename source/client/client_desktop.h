@@ -133,6 +133,7 @@ private:
     size_t max_audio_packet_ = 0;
     size_t avg_audio_packet_ = 0;
     int fps_ = 0;
+    int64_t host_bandwidth_ = 0;
     int cursor_shape_count_ = 0;
     int cursor_pos_count_ = 0;
 
@@ -22,6 +22,7 @@
 #include "base/task_runner.h"
 #include "client/file_control_proxy.h"
 #include "client/file_manager_window_proxy.h"
+#include "common/file_packet.h"
 #include "common/file_task_factory.h"
 #include "common/file_task_consumer_proxy.h"
 #include "common/file_task_producer_proxy.h"
@@ -57,10 +58,21 @@ void ClientFileTransfer::setFileManagerWindow(
     file_manager_window_proxy_ = std::move(file_manager_window_proxy);
 }
 
-void ClientFileTransfer::onSessionStarted(const base::Version& /* peer_version */)
+void ClientFileTransfer::onSessionStarted(const base::Version& peer_version)
 {
     LOG(LS_INFO) << "File transfer session started";
 
+    if (peer_version >= base::Version(2, 6, 0))
+    {
+        // The host can receive file packets and requests for them without waiting for replies.
+        remote_task_window_ = common::kMaxFilePacketWindow;
+
+        // The host can send and receive small files in batches.
+        is_batch_supported_ = true;
+    }
+
+    LOG(LS_INFO) << "Remote task window: " << remote_task_window_;
+
     local_task_factory_ = std::make_unique<common::FileTaskFactory>(
         task_producer_proxy_, common::FileTask::Target::LOCAL);
 
@@ -87,14 +99,17 @@ void ClientFileTransfer::onSessionMessageReceived(
     }
     else if (!remote_task_queue_.empty())
     {
+        DCHECK_GT(remote_tasks_sent_, 0u);
+
         // Move the reply to the request and notify the sender.
         remote_task_queue_.front()->setReply(std::move(reply));
 
         // Remove the request from the queue.
-        remote_task_queue_.pop();
+        remote_task_queue_.pop_front();
+        --remote_tasks_sent_;
 
-        // Execute the next request.
-        doNextRemoteTask();
+        // Execute the next requests.
+        doNextRemoteTasks();
     }
     else
     {
@@ -144,24 +159,24 @@ void ClientFileTransfer::doTask(std::shared_ptr<common::FileTask> task)
     }
     else
     {
-        const bool schedule = remote_task_queue_.empty();
-
         // Add the request to the queue.
-        remote_task_queue_.emplace(std::move(task));
+        remote_task_queue_.emplace_back(std::move(task));
 
-        // If the request queue was empty, then run execution.
-        if (schedule)
-            doNextRemoteTask();
+        // If the window is not full, then run execution.
+        doNextRemoteTasks();
     }
 }
 
-void ClientFileTransfer::doNextRemoteTask()
+void ClientFileTransfer::doNextRemoteTasks()
 {
-    if (remote_task_queue_.empty())
-        return;
-
-    // Send a request to the remote computer.
-    sendMessage(proto::HOST_CHANNEL_ID_SESSION, remote_task_queue_.front()->request());
+    while (remote_tasks_sent_ < remote_task_queue_.size() &&
+           remote_tasks_sent_ < remote_task_window_)
+    {
+        // Send a request to the remote computer.
+        sendMessage(proto::HOST_CHANNEL_ID_SESSION,
+                    remote_task_queue_[remote_tasks_sent_]->request());
+        ++remote_tasks_sent_;
+    }
 }
 
 common::FileTaskFactory* ClientFileTransfer::taskFactory(common::FileTask::Target target)
@@ -228,7 +243,8 @@ void ClientFileTransfer::transfer(std::shared_ptr<FileTransferWindowProxy> trans
     DCHECK(!transfer_);
 
     transfer_ = std::make_unique<FileTransfer>(
-        local_worker_->taskRunner(), transfer_window_proxy, task_consumer_proxy_, transfer_type);
+        local_worker_->taskRunner(), transfer_window_proxy, task_consumer_proxy_, transfer_type,
+        remote_task_window_, is_batch_supported_);
 
     transfer_->start(source_path, target_path, items, [this]()
     {
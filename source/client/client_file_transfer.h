@@ -24,7 +24,7 @@
 #include "common/file_task_consumer.h"
 #include "common/file_task_producer.h"
 
-#include <queue>
+#include <deque>
 
 namespace common {
 class FileTaskConsumerProxy;
@@ -67,7 +67,7 @@ protected:
     void onTaskDone(std::shared_ptr<common::FileTask> task) override;
 
 private:
-    void doNextRemoteTask();
+    void doNextRemoteTasks();
 
     common::FileTaskFactory* taskFactory(common::FileTask::Target target);
 
@@ -93,7 +93,12 @@ private:
     std::unique_ptr<common::FileTaskFactory> local_task_factory_;
     std::unique_ptr<common::FileTaskFactory> remote_task_factory_;
 
-    std::queue<std::shared_ptr<common::FileTask>> remote_task_queue_;
+    // Requests are sent to the host without waiting for the previous replies. The host executes
+    // them in order. The first |remote_tasks_sent_| requests of the queue wait for a reply.
+    std::deque<std::shared_ptr<common::FileTask>> remote_task_queue_;
+    size_t remote_tasks_sent_ = 0;
+    size_t remote_task_window_ = 1;
+    bool is_batch_supported_ = false;
     std::unique_ptr<common::FileWorker> local_worker_;
 
     std::shared_ptr<FileControlProxy> file_control_proxy_;
@@ -32,6 +32,9 @@ const int kDefCompressRatio = 8;
 const int kMinCompressRatio = 1;
 const int kMaxCompressRatio = 22;
 
+// 2048 tiles of 64x64 pixels take 32 MB on the client.
+const uint32_t kDefTileCacheSize = 2048;
+
 void serializePixelFormat(const base::PixelFormat& from, proto::PixelFormat* to)
 {
     to->set_bits_per_pixel(from.bitsPerPixel());
@@ -111,6 +114,9 @@ void ConfigFactory::fixupDesktopConfig(proto::DesktopConfig* config)
 
     if (config->audio_encoding() == proto::AUDIO_ENCODING_DEFAULT)
         config->set_audio_encoding(kDefaultAudioEncoding);
+
+    config->set_tile_cache_size(kDefTileCacheSize);
+    config->set_copy_rect(true);
 }
 
 } // namespace client
@@ -29,6 +29,7 @@
 namespace base {
 class Frame;
 class MouseCursor;
+class Region;
 class Size;
 class Version;
 } // namespace base
@@ -61,6 +62,7 @@ public:
         int64_t total_tx = 0;
         int speed_rx = 0;
         int speed_tx = 0;
+        int64_t host_bandwidth = 0;
         int64_t video_packet_count = 0;
         int64_t video_pause_count = 0;
         int64_t video_resume_count = 0;
@@ -103,7 +105,8 @@ public:
     virtual void setFrameError(proto::VideoErrorCode error_code) = 0;
     virtual void setFrame(const base::Size& screen_size,
                           std::shared_ptr<base::Frame> frame) = 0;
-    virtual void drawFrame() = 0;
+    // |updated_region| contains the areas of the frame that have changed since the last call.
+    virtual void drawFrame(const base::Region& updated_region) = 0;
     virtual void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) = 0;
 };
 
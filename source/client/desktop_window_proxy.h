@@ -56,7 +56,7 @@ public:
     std::shared_ptr<base::Frame> allocateFrame(const base::Size& size);
     void setFrameError(proto::VideoErrorCode error_code);
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame);
-    void drawFrame();
+    void drawFrame(const base::Region& updated_region);
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor);
 
 private:
@@ -27,10 +27,20 @@
 #include "common/file_task_producer_proxy.h"
 #include "common/file_packet.h"
 
+#include <algorithm>
+
 namespace client {
 
 namespace {
 
+int64_t packetCount(int64_t file_size)
+{
+    const int64_t packet_size = static_cast<int64_t>(common::kMaxFilePacketSize);
+
+    // An empty file is transferred in one packet.
+    return std::max((file_size + packet_size - 1) / packet_size, int64_t(1));
+}
+
 struct ActionsMap
 {
     FileTransfer::Error::Type type;
@@ -87,14 +97,18 @@ struct ActionsMap
 FileTransfer::FileTransfer(std::shared_ptr<base::TaskRunner> io_task_runner,
                            std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
                            std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy,
-                           Type type)
+                           Type type,
+                           size_t packet_window,
+                           bool batch_small_files)
     : io_task_runner_(io_task_runner),
       transfer_proxy_(std::make_shared<FileTransferProxy>(io_task_runner, this)),
       transfer_window_proxy_(std::move(transfer_window_proxy)),
       task_consumer_proxy_(std::move(task_consumer_proxy)),
       task_producer_proxy_(std::make_shared<common::FileTaskProducerProxy>(this)),
       cancel_timer_(base::WaitableTimer::Type::SINGLE_SHOT, io_task_runner),
-      type_(type)
+      type_(type),
+      packet_window_(std::max(packet_window, size_t(1))),
+      batch_small_files_(batch_small_files)
 {
     // Nothing
 }
@@ -239,6 +253,24 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
     }
     else if (request.has_upload_request())
     {
+        if (batch_size_)
+        {
+            if (reply.error_code() != proto::FILE_ERROR_SUCCESS || !batch_packet_count_)
+            {
+                onBatchFailed();
+                return;
+            }
+
+            is_reading_ = true;
+            is_writing_ = true;
+            packets_in_flight_ = 0;
+            packets_requested_ = 0;
+            packets_left_ = batch_packet_count_;
+
+            requestPackets();
+            return;
+        }
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
             Error::Type error_type = Error::Type::CREATE_FILE;
@@ -250,22 +282,67 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
             return;
         }
 
-        task_consumer_proxy_->doTask(
-            task_factory_source_->packetRequest(proto::FilePacketRequest::NO_FLAGS));
+        is_reading_ = true;
+        is_writing_ = true;
+        packets_in_flight_ = 0;
+        packets_requested_ = 0;
+        packets_left_ = packetCount(frontTask().size());
+
+        requestPackets();
     }
     else if (request.has_packet())
     {
+        if (!is_writing_)
+            return;
+
+        if (batch_packets_writing_)
+            --batch_packets_writing_;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            if (batch_size_)
+            {
+                onBatchFailed();
+                return;
+            }
+
+            is_reading_ = false;
+            is_writing_ = false;
+
             onError(Error::Type::WRITE_FILE, reply.error_code(), frontTask().targetPath());
             return;
         }
 
-        const int64_t full_task_size = frontTask().size();
-        if (full_task_size && total_size_)
+        int64_t full_task_size = frontTask().size();
+        int64_t packet_size = common::kMaxFilePacketSize;
+
+        if (batch_size_)
         {
-            int64_t packet_size = common::kMaxFilePacketSize;
+            std::vector<bool> is_failed(batch_size_, false);
+
+            for (const auto& item : reply.batch_error())
+            {
+                if (item.index() < batch_size_)
+                    is_failed[item.index()] = true;
+            }
 
+            // Only written files are counted. The rest will be transferred separately.
+            packet_size = 0;
+
+            for (const auto& item : request.packet().batch_item())
+            {
+                if (item.index() >= batch_size_ || is_failed[item.index()])
+                    continue;
+
+                batch_done_[item.index()] = true;
+                packet_size += static_cast<int64_t>(item.data().size());
+            }
+
+            full_task_size = batch_total_size_;
+        }
+
+        if (full_task_size && total_size_)
+        {
             task_transfered_size_ += packet_size;
 
             if (task_transfered_size_ > full_task_size)
@@ -290,17 +367,24 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
             }
         }
 
+        if (is_batch_failed_)
+        {
+            if (!batch_packets_writing_)
+                onBatchFailed();
+            return;
+        }
+
         if (request.packet().flags() & proto::FilePacket::LAST_PACKET)
         {
+            is_writing_ = false;
             doNextTask();
             return;
         }
 
-        uint32_t flags = proto::FilePacketRequest::NO_FLAGS;
-        if (is_canceled_)
-            flags = proto::FilePacketRequest::CANCEL;
+        if (packets_in_flight_)
+            --packets_in_flight_;
 
-        task_consumer_proxy_->doTask(task_factory_source_->packetRequest(flags));
+        requestPackets();
     }
     else
     {
@@ -315,6 +399,32 @@ void FileTransfer::sourceReply(const proto::FileRequest& request, const proto::F
 
     if (request.has_download_request())
     {
+        if (batch_size_)
+        {
+            if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+            {
+                onBatchFailed();
+                return;
+            }
+
+            batch_packet_count_ = static_cast<int64_t>(reply.batch_packet_count());
+
+            std::vector<std::string> target_paths;
+            target_paths.reserve(batch_size_);
+
+            for (size_t i = 0; i < batch_size_; ++i)
+                target_paths.emplace_back(tasks_[i].targetPath());
+
+            // Existing files are replaced only if the user has chosen it for all files.
+            auto action = actions_.find(Error::Type::ALREADY_EXISTS);
+            bool overwrite =
+                action != actions_.end() && action->second == Error::ACTION_REPLACE_ALL;
+
+            task_consumer_proxy_->doTask(
+                task_factory_target_->batchUpload(target_paths, overwrite));
+            return;
+        }
+
         Task& front_task = frontTask();
 
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
@@ -328,13 +438,44 @@ void FileTransfer::sourceReply(const proto::FileRequest& request, const proto::F
     }
     else if (request.has_packet_request())
     {
+        if (!is_reading_)
+            return;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            if (batch_size_)
+            {
+                onBatchFailed();
+                return;
+            }
+
+            is_reading_ = false;
+            is_writing_ = false;
+
             onError(Error::Type::READ_FILE, reply.error_code(), frontTask().sourcePath());
             return;
         }
 
-        task_consumer_proxy_->doTask(task_factory_target_->packet(reply.packet()));
+        const proto::FilePacket& packet = reply.packet();
+
+        if (packet.flags() & proto::FilePacket::LAST_PACKET)
+        {
+            // Replies to the packets requested after this one are ignored.
+            is_reading_ = false;
+        }
+        else if (!batch_size_ && (packet.flags() & proto::FilePacket::FIRST_PACKET))
+        {
+            // The size of the file could change after the transfer queue was built.
+            packets_left_ = std::max(
+                packetCount(static_cast<int64_t>(packet.file_size())) - packets_requested_,
+                int64_t(0));
+        }
+
+        if (batch_size_)
+            ++batch_packets_writing_;
+
+        task_consumer_proxy_->doTask(task_factory_target_->packet(packet));
+        requestPackets();
     }
     else
     {
@@ -391,6 +532,10 @@ void FileTransfer::doFrontTask(bool overwrite)
         task_consumer_proxy_->doTask(
             task_factory_target_->createDirectory(front_task.targetPath()));
     }
+    else if (!overwrite && doFrontBatch())
+    {
+        // The batch is started.
+    }
     else
     {
         task_consumer_proxy_->doTask(
@@ -398,18 +543,72 @@ void FileTransfer::doFrontTask(bool overwrite)
     }
 }
 
+bool FileTransfer::doFrontBatch()
+{
+    if (!batch_small_files_ || unbatched_tasks_)
+        return false;
+
+    const int64_t max_item_size = static_cast<int64_t>(common::kMaxFileBatchItemSize);
+    size_t count = 0;
+    int64_t total_size = 0;
+
+    while (count < tasks_.size() && count < common::kMaxFileBatchSize)
+    {
+        const Task& task = tasks_[count];
+
+        if (task.isDirectory() || task.size() < 0 || task.size() > max_item_size)
+            break;
+
+        total_size += task.size();
+        ++count;
+    }
+
+    // It makes no sense to transfer a single file in a batch.
+    if (count < 2)
+        return false;
+
+    batch_size_ = count;
+    batch_total_size_ = total_size;
+    batch_packet_count_ = 0;
+    batch_done_.assign(count, false);
+
+    std::vector<std::string> source_paths;
+    source_paths.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+        source_paths.emplace_back(tasks_[i].sourcePath());
+
+    task_consumer_proxy_->doTask(task_factory_source_->batchDownload(source_paths));
+    return true;
+}
+
 void FileTransfer::doNextTask()
 {
     if (is_canceled_)
     {
         while (!tasks_.empty())
             tasks_.pop_front();
+
+        batch_size_ = 0;
+        unbatched_tasks_ = 0;
+        batch_packets_writing_ = 0;
+        is_batch_failed_ = false;
     }
 
     if (!tasks_.empty())
     {
         // Delete the task only after confirmation of its successful execution.
-        tasks_.pop_front();
+        if (batch_size_)
+        {
+            removeBatch();
+        }
+        else
+        {
+            tasks_.pop_front();
+
+            if (unbatched_tasks_)
+                --unbatched_tasks_;
+        }
     }
 
     if (tasks_.empty())
@@ -424,6 +623,78 @@ void FileTransfer::doNextTask()
     doFrontTask(false);
 }
 
+void FileTransfer::removeBatch()
+{
+    DCHECK_LE(batch_size_, tasks_.size());
+
+    TaskList failed_tasks;
+
+    for (size_t i = 0; i < batch_size_; ++i)
+    {
+        if (!batch_done_[i])
+            failed_tasks.emplace_back(std::move(tasks_[i]));
+    }
+
+    tasks_.erase(tasks_.begin(), tasks_.begin() + static_cast<ptrdiff_t>(batch_size_));
+
+    // The files that were not written are transferred separately. In this case, the user gets the
+    // usual error for each of them.
+    tasks_.insert(tasks_.begin(),
+                  std::make_move_iterator(failed_tasks.begin()),
+                  std::make_move_iterator(failed_tasks.end()));
+
+    unbatched_tasks_ = failed_tasks.size();
+    batch_size_ = 0;
+    batch_done_.clear();
+    batch_packets_writing_ = 0;
+    is_batch_failed_ = false;
+}
+
+void FileTransfer::onBatchFailed()
+{
+    if (!is_batch_failed_)
+    {
+        LOG(LS_WARNING) << "Unable to transfer batch of files. "
+                        << "Files will be transferred separately";
+        is_batch_failed_ = true;
+    }
+
+    // Replies to the packet requests already sent to the source are ignored.
+    is_reading_ = false;
+
+    // The packets already sent to the target can still be written. The files from them must not
+    // be transferred again, otherwise they fail as already existing.
+    if (batch_packets_writing_)
+        return;
+
+    is_writing_ = false;
+
+    doNextTask();
+}
+
+void FileTransfer::requestPackets()
+{
+    while (is_reading_ && packets_left_ > 0 && packets_in_flight_ < packet_window_)
+    {
+        ++packets_in_flight_;
+        ++packets_requested_;
+        --packets_left_;
+
+        if (is_canceled_)
+        {
+            // The source finishes the file after the cancel request.
+            packets_left_ = 0;
+
+            task_consumer_proxy_->doTask(
+                task_factory_source_->packetRequest(proto::FilePacketRequest::CANCEL));
+            break;
+        }
+
+        task_consumer_proxy_->doTask(
+            task_factory_source_->packetRequest(proto::FilePacketRequest::NO_FLAGS));
+    }
+}
+
 void FileTransfer::onError(Error::Type type, proto::FileError code, const std::string& path)
 {
     auto default_action = actions_.find(type);
@@ -158,7 +158,9 @@ public:
     FileTransfer(std::shared_ptr<base::TaskRunner> io_task_runner,
                  std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
                  std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy,
-                 Type type);
+                 Type type,
+                 size_t packet_window = 1,
+                 bool batch_small_files = false);
     ~FileTransfer() override;
 
     void start(const std::string& source_path,
@@ -178,7 +180,11 @@ private:
     void targetReply(const proto::FileRequest& request, const proto::FileReply& reply);
     void sourceReply(const proto::FileRequest& request, const proto::FileReply& reply);
     void doFrontTask(bool overwrite);
+    bool doFrontBatch();
     void doNextTask();
+    void removeBatch();
+    void onBatchFailed();
+    void requestPackets();
     void onError(Error::Type type, proto::FileError code, const std::string& path = std::string());
     void setActionForErrorType(Error::Type error_type, Error::Action action);
     void onFinished();
@@ -210,6 +216,34 @@ private:
 
     bool is_canceled_ = false;
 
+    // Packets of the current file are requested from the source before the previous ones are
+    // written. Every written packet allows to request the next one.
+    const size_t packet_window_;
+    size_t packets_in_flight_ = 0; // Requested and not yet written.
+    int64_t packets_requested_ = 0;
+    int64_t packets_left_ = 0; // Not yet requested.
+
+    // Replies from the source and the target are expected for the current file. Replies to the
+    // requests sent after the last packet or an error are ignored.
+    bool is_reading_ = false;
+    bool is_writing_ = false;
+
+    // Consecutive small files are transferred in batches. The first |batch_size_| tasks of the
+    // queue belong to the current batch. Files that were not written in the batch are returned to
+    // the front of the queue and the first |unbatched_tasks_| tasks are transferred separately.
+    const bool batch_small_files_;
+    size_t batch_size_ = 0;
+    size_t unbatched_tasks_ = 0;
+    int64_t batch_total_size_ = 0;
+    int64_t batch_packet_count_ = 0;
+    std::vector<bool> batch_done_;
+
+    // After a batch error the target still replies to the packets already sent to it. The batch
+    // is removed only when all of these replies are received, so the files written by them are
+    // not transferred again.
+    size_t batch_packets_writing_ = 0;
+    bool is_batch_failed_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(FileTransfer);
 };
 
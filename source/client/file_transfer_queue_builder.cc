@@ -72,34 +72,18 @@ void FileTransferQueueBuilder::onTaskDone(std::shared_ptr<common::FileTask> task
     const proto::FileRequest& request = task->request();
     const proto::FileReply& reply = task->reply();
 
-    if (!request.has_file_list_request())
+    if (request.has_file_tree_request())
     {
-        onAborted(proto::FILE_ERROR_UNKNOWN);
-        return;
+        onFileTreeDone(request.file_tree_request(), reply);
     }
-
-    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    else if (request.has_file_list_request())
     {
-        onAborted(reply.error_code());
-        return;
+        onFileListDone(reply);
     }
-
-    // If we get a list of files, then the last task is a directory.
-    const FileTransfer::Task& last_task = tasks_.back();
-    DCHECK(last_task.isDirectory());
-
-    for (int i = 0; i < reply.file_list().item_size(); ++i)
+    else
     {
-        const proto::FileList::Item& item = reply.file_list().item(i);
-
-        addPendingTask(last_task.sourcePath(),
-                       last_task.targetPath(),
-                       item.name(),
-                       item.is_directory(),
-                       static_cast<int64_t>(item.size()));
+        onAborted(proto::FILE_ERROR_UNKNOWN);
     }
-
-    doPendingTasks();
 }
 
 void FileTransferQueueBuilder::addPendingTask(const std::string& source_dir,
@@ -123,9 +107,21 @@ void FileTransferQueueBuilder::doPendingTasks()
         tasks_.emplace_back(std::move(pending_tasks_.front()));
         pending_tasks_.pop_front();
 
-        if (tasks_.back().isDirectory())
+        const FileTransfer::Task& task = tasks_.back();
+        if (task.isDirectory())
         {
-            task_consumer_proxy_->doTask(task_factory_->fileList(tasks_.back().sourcePath()));
+            current_source_dir_ = task.sourcePath();
+            current_target_dir_ = task.targetPath();
+
+            if (is_file_tree_supported_)
+            {
+                task_consumer_proxy_->doTask(task_factory_->fileTree(
+                    current_source_dir_, proto::FileTreeRequest::NO_FLAGS));
+            }
+            else
+            {
+                task_consumer_proxy_->doTask(task_factory_->fileList(current_source_dir_));
+            }
             return;
         }
     }
@@ -133,6 +129,73 @@ void FileTransferQueueBuilder::doPendingTasks()
     callback_(proto::FILE_ERROR_SUCCESS);
 }
 
+void FileTransferQueueBuilder::onFileListDone(const proto::FileReply& reply)
+{
+    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    {
+        onAborted(reply.error_code());
+        return;
+    }
+
+    for (int i = 0; i < reply.file_list().item_size(); ++i)
+    {
+        const proto::FileList::Item& item = reply.file_list().item(i);
+
+        addPendingTask(current_source_dir_,
+                       current_target_dir_,
+                       item.name(),
+                       item.is_directory(),
+                       static_cast<int64_t>(item.size()));
+    }
+
+    doPendingTasks();
+}
+
+void FileTransferQueueBuilder::onFileTreeDone(
+    const proto::FileTreeRequest& request, const proto::FileReply& reply)
+{
+    if (reply.error_code() == proto::FILE_ERROR_INVALID_REQUEST &&
+        !(request.flags() & proto::FileTreeRequest::CONTINUE))
+    {
+        LOG(LS_INFO) << "File tree request is not supported by peer";
+
+        // Fall back to requesting the list of each directory separately.
+        is_file_tree_supported_ = false;
+        task_consumer_proxy_->doTask(task_factory_->fileList(current_source_dir_));
+        return;
+    }
+
+    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    {
+        onAborted(reply.error_code());
+        return;
+    }
+
+    // The subtree is already complete, so the items are added directly to the queue. Directories
+    // always precede their contents.
+    for (int i = 0; i < reply.file_list().item_size(); ++i)
+    {
+        const proto::FileList::Item& item = reply.file_list().item(i);
+        int64_t size = static_cast<int64_t>(item.size());
+
+        total_size_ += size;
+
+        tasks_.emplace_back(current_source_dir_ + '/' + item.name(),
+                            current_target_dir_ + '/' + item.name(),
+                            item.is_directory(),
+                            size);
+    }
+
+    if (reply.file_list().has_more())
+    {
+        task_consumer_proxy_->doTask(task_factory_->fileTree(
+            current_source_dir_, proto::FileTreeRequest::CONTINUE));
+        return;
+    }
+
+    doPendingTasks();
+}
+
 void FileTransferQueueBuilder::onAborted(proto::FileError error_code)
 {
     pending_tasks_.clear();
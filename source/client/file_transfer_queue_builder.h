@@ -54,6 +54,8 @@ private:
                         bool is_directory,
                         int64_t size);
     void doPendingTasks();
+    void onFileListDone(const proto::FileReply& reply);
+    void onFileTreeDone(const proto::FileTreeRequest& request, const proto::FileReply& reply);
     void onAborted(proto::FileError error_code);
 
     std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy_;
@@ -66,6 +68,14 @@ private:
     FileTransfer::TaskList tasks_;
     int64_t total_size_ = 0;
 
+    // Source and target paths of the directory whose contents are being received.
+    std::string current_source_dir_;
+    std::string current_target_dir_;
+
+    // Peers older than 2.6.0 do not support file tree requests. In this case, the contents of
+    // each directory are requested separately.
+    bool is_file_tree_supported_ = true;
+
     DISALLOW_COPY_AND_ASSIGN(FileTransferQueueBuilder);
 };
 
@@ -23,8 +23,11 @@
 #include "client/ui/frame_qimage.h"
 
 #include <QApplication>
+#include <QPaintEvent>
 #include <QWheelEvent>
 
+#include <cmath>
+
 #if defined(OS_LINUX)
 #include <X11/XKBlib.h>
 #if defined(KeyPress)
@@ -140,6 +143,7 @@ base::Frame* DesktopWidget::desktopFrame()
 void DesktopWidget::setDesktopFrame(std::shared_ptr<base::Frame>& frame)
 {
     frame_ = std::move(frame);
+    update();
 }
 
 void DesktopWidget::setDesktopFrameError(proto::VideoErrorCode error_code)
@@ -174,25 +178,49 @@ void DesktopWidget::setDesktopFrameError(proto::VideoErrorCode error_code)
     error_timer_->start(std::chrono::milliseconds(1500));
 }
 
-void DesktopWidget::drawDesktopFrame()
+void DesktopWidget::drawDesktopFrame(const base::Region& updated_region)
 {
     if (error_timer_)
         delete error_timer_;
 
     if (current_error_code_ != proto::VIDEO_ERROR_CODE_OK)
+    {
         error_image_.reset();
 
+        last_error_code_ = proto::VIDEO_ERROR_CODE_OK;
+        current_error_code_ = proto::VIDEO_ERROR_CODE_OK;
+
+        // The error message covers the frame. Redraw the whole widget.
+        update();
+        return;
+    }
+
     last_error_code_ = proto::VIDEO_ERROR_CODE_OK;
-    current_error_code_ = proto::VIDEO_ERROR_CODE_OK;
 
-    update();
+    if (!frame_)
+        return;
+
+    // Only the changed areas are redrawn. Qt combines them into a single paint event.
+    QRegion dirty_region;
+
+    for (base::Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+        dirty_region += mapFromFrame(it.rect());
+
+    if (!dirty_region.isEmpty())
+        update(dirty_region);
 }
 
 void DesktopWidget::setCursorShape(QPixmap&& cursor_shape, const QPoint& hotspot)
 {
+    if (enable_remote_cursor_pos_)
+        update(remoteCursorRect());
+
     remote_cursor_shape_ = std::move(cursor_shape);
     remote_cursor_hotspot_ = hotspot;
 
+    if (enable_remote_cursor_pos_)
+        update(remoteCursorRect());
+
     if (remote_cursor_shape_.isNull())
     {
         setCursor(QCursor(Qt::ArrowCursor));
@@ -205,6 +233,10 @@ void DesktopWidget::setCursorShape(QPixmap&& cursor_shape, const QPoint& hotspot
 
 void DesktopWidget::setCursorPosition(const QPoint& cursor_position)
 {
+    // The cursor is erased from the previous position.
+    if (enable_remote_cursor_pos_)
+        update(remoteCursorRect());
+
     remote_cursor_pos_ = cursor_position;
 
     QSize widget_size = size();
@@ -218,6 +250,9 @@ void DesktopWidget::setCursorPosition(const QPoint& cursor_position)
         remote_cursor_pos_.setY(0);
     else if (remote_cursor_pos_.y() > widget_size.height())
         remote_cursor_pos_.setY(widget_size.height());
+
+    if (enable_remote_cursor_pos_)
+        update(remoteCursorRect());
 }
 
 void DesktopWidget::doMouseEvent(QEvent::Type event_type,
@@ -421,7 +456,40 @@ void DesktopWidget::userLeftFromWindow()
     releaseKeyboardButtons();
 }
 
-void DesktopWidget::paintEvent(QPaintEvent* /* event */)
+QRect DesktopWidget::mapFromFrame(const base::Rect& rect) const
+{
+    if (!frame_)
+        return QRect();
+
+    const base::Size& frame_size = frame_->size();
+    if (frame_size.isEmpty())
+        return QRect();
+
+    if (size() == QSize(frame_size.width(), frame_size.height()))
+        return QRect(rect.x(), rect.y(), rect.width(), rect.height());
+
+    const qreal scale_x = static_cast<qreal>(width()) / frame_size.width();
+    const qreal scale_y = static_cast<qreal>(height()) / frame_size.height();
+
+    // The area is extended by a pixel because smoothing changes the neighboring pixels too.
+    QRect widget_rect(QPoint(static_cast<int>(std::floor(rect.left() * scale_x)) - 1,
+                             static_cast<int>(std::floor(rect.top() * scale_y)) - 1),
+                      QPoint(static_cast<int>(std::ceil(rect.right() * scale_x)) + 1,
+                             static_cast<int>(std::ceil(rect.bottom() * scale_y)) + 1));
+
+    return widget_rect.intersected(this->rect());
+}
+
+QRect DesktopWidget::remoteCursorRect() const
+{
+    if (!remote_cursor_shape_.isNull())
+        return QRect(remote_cursor_pos_ - remote_cursor_hotspot_, remote_cursor_shape_.size());
+
+    // The ellipse with a radius of 3 pixels and a pen.
+    return QRect(remote_cursor_pos_ - QPoint(4, 4), QSize(9, 9));
+}
+
+void DesktopWidget::paintEvent(QPaintEvent* event)
 {
     painter_.begin(this);
 
@@ -434,7 +502,37 @@ void DesktopWidget::paintEvent(QPaintEvent* /* event */)
         FrameQImage* frame = reinterpret_cast<FrameQImage*>(frame_.get());
         if (frame)
         {
-            painter_.drawImage(rect(), frame->constImage());
+            const QImage& image = frame->constImage();
+
+            if (size() == image.size())
+            {
+                for (const QRect& dirty_rect : event->region())
+                    painter_.drawImage(dirty_rect.topLeft(), image, dirty_rect);
+            }
+            else
+            {
+                const qreal scale_x = static_cast<qreal>(width()) / image.width();
+                const qreal scale_y = static_cast<qreal>(height()) / image.height();
+                const QRectF image_rect(image.rect());
+
+                for (const QRect& dirty_rect : event->region())
+                {
+                    // The source area is extended by a pixel so that smoothing at the edges uses
+                    // the neighboring pixels. Everything outside the dirty area is clipped.
+                    QRectF source_rect(dirty_rect.x() / scale_x,
+                                       dirty_rect.y() / scale_y,
+                                       dirty_rect.width() / scale_x,
+                                       dirty_rect.height() / scale_y);
+                    source_rect = source_rect.adjusted(-1, -1, 1, 1).intersected(image_rect);
+
+                    QRectF target_rect(source_rect.x() * scale_x,
+                                       source_rect.y() * scale_y,
+                                       source_rect.width() * scale_x,
+                                       source_rect.height() * scale_y);
+
+                    painter_.drawImage(target_rect, image, source_rect);
+                }
+            }
 
             if (enable_remote_cursor_pos_)
             {
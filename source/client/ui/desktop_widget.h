@@ -49,7 +49,7 @@ public:
     base::Frame* desktopFrame();
     void setDesktopFrame(std::shared_ptr<base::Frame>& frame);
     void setDesktopFrameError(proto::VideoErrorCode error_code);
-    void drawDesktopFrame();
+    void drawDesktopFrame(const base::Region& updated_region);
     void setCursorShape(QPixmap&& cursor_shape, const QPoint& hotspot);
     void setCursorPosition(const QPoint& cursor_position);
 
@@ -91,6 +91,10 @@ private:
     void releaseMouseButtons();
     void releaseKeyboardButtons();
 
+    // Returns the area of the widget occupied by |rect| of the frame.
+    QRect mapFromFrame(const base::Rect& rect) const;
+    QRect remoteCursorRect() const;
+
     QPainter painter_;
 
 #if defined(OS_WIN)
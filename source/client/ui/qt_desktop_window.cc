@@ -359,7 +359,6 @@ void QtDesktopWindow::setCursorPosition(const proto::CursorPosition& cursor_posi
         static_cast<double>(frame_size.height()));
 
     desktop_->setCursorPosition(QPoint(pos_x, pos_y));
-    desktop_->update();
 }
 
 void QtDesktopWindow::setSystemInfo(const proto::system_info::SystemInfo& system_info)
@@ -427,9 +426,9 @@ void QtDesktopWindow::setFrame(
     }
 }
 
-void QtDesktopWindow::drawFrame()
+void QtDesktopWindow::drawFrame(const base::Region& updated_region)
 {
-    desktop_->drawDesktopFrame();
+    desktop_->drawDesktopFrame(updated_region);
     panel_->update();
 }
 
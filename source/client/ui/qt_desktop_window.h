@@ -73,7 +73,7 @@ public:
     std::unique_ptr<FrameFactory> frameFactory() override;
     void setFrameError(proto::VideoErrorCode error_code) override;
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame) override;
-    void drawFrame() override;
+    void drawFrame(const base::Region& updated_region) override;
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) override;
 
     // SystemInfoControl implementation.
@@ -167,6 +167,10 @@ void StatisticsDialog::setMetrics(const DesktopWindow::Metrics& metrics)
             case 26:
                 item->setText(1, QString::number(metrics.cursor_pos_count));
                 break;
+
+            case 27:
+                item->setText(1, speedToString(metrics.host_bandwidth));
+                break;
         }
     }
 }
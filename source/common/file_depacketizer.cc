@@ -30,6 +30,14 @@ FileDepacketizer::FileDepacketizer(const std::filesystem::path& file_path,
     // Nothing
 }
 
+FileDepacketizer::FileDepacketizer(std::vector<std::filesystem::path>&& batch_paths,
+                                   bool overwrite)
+    : batch_paths_(std::move(batch_paths)),
+      batch_overwrite_(overwrite)
+{
+    // Nothing
+}
+
 FileDepacketizer::~FileDepacketizer()
 {
     // If the file is opened, it was not completely written.
@@ -62,6 +70,17 @@ std::unique_ptr<FileDepacketizer> FileDepacketizer::create(
         new FileDepacketizer(file_path, std::move(file_stream)));
 }
 
+// static
+std::unique_ptr<FileDepacketizer> FileDepacketizer::createBatch(
+    std::vector<std::filesystem::path> file_paths, bool overwrite)
+{
+    if (file_paths.empty())
+        return nullptr;
+
+    return std::unique_ptr<FileDepacketizer>(
+        new FileDepacketizer(std::move(file_paths), overwrite));
+}
+
 bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
 {
     DCHECK(file_stream_.is_open());
@@ -116,4 +135,66 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
     return true;
 }
 
+bool FileDepacketizer::writeNextBatchPacket(
+    const proto::FilePacket& packet,
+    google::protobuf::RepeatedPtrField<proto::FileBatchItem>* failed_items)
+{
+    DCHECK(isBatch());
+    DCHECK(failed_items);
+
+    for (int i = 0; i < packet.batch_item_size(); ++i)
+    {
+        const proto::FileBatchItem& item = packet.batch_item(i);
+
+        if (item.index() >= batch_paths_.size())
+        {
+            LOG(LS_WARNING) << "Wrong batch item index: " << item.index();
+            return false;
+        }
+
+        const std::filesystem::path& file_path = batch_paths_[item.index()];
+        proto::FileError error_code = item.error_code();
+
+        if (error_code == proto::FILE_ERROR_SUCCESS)
+        {
+            std::error_code ignored_code;
+            if (!batch_overwrite_ && std::filesystem::exists(file_path, ignored_code))
+            {
+                error_code = proto::FILE_ERROR_PATH_ALREADY_EXISTS;
+            }
+            else
+            {
+                std::ofstream file_stream;
+                file_stream.open(file_path, std::ofstream::binary | std::ofstream::trunc);
+
+                if (!file_stream.is_open())
+                {
+                    error_code = proto::FILE_ERROR_FILE_CREATE_ERROR;
+                }
+                else
+                {
+                    file_stream.write(item.data().data(),
+                                      static_cast<std::streamsize>(item.data().size()));
+                    file_stream.close();
+
+                    if (file_stream.fail())
+                    {
+                        std::filesystem::remove(file_path, ignored_code);
+                        error_code = proto::FILE_ERROR_FILE_WRITE_ERROR;
+                    }
+                }
+            }
+        }
+
+        if (error_code != proto::FILE_ERROR_SUCCESS)
+        {
+            proto::FileBatchItem* failed_item = failed_items->Add();
+            failed_item->set_index(item.index());
+            failed_item->set_error_code(error_code);
+        }
+    }
+
+    return true;
+}
+
 } // namespace common
@@ -25,6 +25,7 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <vector>
 
 namespace common {
 
@@ -36,11 +37,28 @@ public:
     static std::unique_ptr<FileDepacketizer> create(const std::filesystem::path& file_path,
                                                     bool overwrite);
 
+    // Creates an instance for receiving a batch of small files. |file_paths| are the target paths
+    // in the order of the batch request.
+    static std::unique_ptr<FileDepacketizer> createBatch(
+        std::vector<std::filesystem::path> file_paths, bool overwrite);
+
+    bool isBatch() const { return !batch_paths_.empty(); }
+
     // Reads the packet and writes its contents to a file.
     bool writeNextPacket(const proto::FilePacket& packet);
 
+    // Writes the files of the batch packet. Files that were not read on the source or could not
+    // be written are added to |failed_items|. Returns false if the packet is malformed.
+    bool writeNextBatchPacket(
+        const proto::FilePacket& packet,
+        google::protobuf::RepeatedPtrField<proto::FileBatchItem>* failed_items);
+
 private:
     FileDepacketizer(const std::filesystem::path& file_path, std::ofstream&& file_stream);
+    FileDepacketizer(std::vector<std::filesystem::path>&& batch_paths, bool overwrite);
+
+    std::vector<std::filesystem::path> batch_paths_;
+    const bool batch_overwrite_ = false;
 
     std::filesystem::path file_path_;
     std::ofstream file_stream_;
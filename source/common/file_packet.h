@@ -25,6 +25,17 @@ namespace common {
 // This parameter specifies the size of the part.
 static const size_t kMaxFilePacketSize = 64 * 1024; // 64 kB
 
+// The maximum number of packets that can be requested from the source before the target confirms
+// writing them. With the default packet size, up to 1 MB is in transit.
+static const size_t kMaxFilePacketWindow = 16;
+
+// Files not larger than this size are transferred in batches: several whole files are placed in
+// one packet. The size must not exceed kMaxFilePacketSize.
+static const size_t kMaxFileBatchItemSize = 16 * 1024; // 16 kB
+
+// The maximum number of files in one batch.
+static const size_t kMaxFileBatchSize = 256;
+
 } // namespace common
 
 #endif // COMMON_FILE_PACKET_H
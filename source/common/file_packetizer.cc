@@ -25,10 +25,10 @@ namespace common {
 
 namespace {
 
-char* outputBuffer(proto::FilePacket* packet, size_t size)
+char* outputBuffer(std::string* data, size_t size)
 {
-    packet->mutable_data()->resize(size);
-    return packet->mutable_data()->data();
+    data->resize(size);
+    return data->data();
 }
 
 } // namespace
@@ -42,6 +42,44 @@ FilePacketizer::FilePacketizer(std::ifstream&& file_stream)
     left_size_ = file_size_;
 }
 
+FilePacketizer::FilePacketizer(std::vector<std::filesystem::path>&& batch_paths)
+{
+    batch_items_.reserve(batch_paths.size());
+
+    uint64_t packet_size = 0;
+
+    for (size_t i = 0; i < batch_paths.size(); ++i)
+    {
+        BatchItem item;
+        item.path = std::move(batch_paths[i]);
+        item.error_code = proto::FILE_ERROR_SUCCESS;
+
+        std::error_code error_code;
+        item.size = std::filesystem::file_size(item.path, error_code);
+
+        // The file could change after the transfer queue was built. Such a file is not sent in the
+        // batch.
+        if (error_code || item.size > kMaxFileBatchItemSize)
+        {
+            item.error_code = proto::FILE_ERROR_FILE_OPEN_ERROR;
+            item.size = 0;
+        }
+
+        // Each packet contains at least one file.
+        if (i != 0 && packet_size + item.size > kMaxFilePacketSize)
+        {
+            batch_packet_ends_.emplace_back(i);
+            packet_size = 0;
+        }
+
+        packet_size += item.size;
+        batch_items_.emplace_back(std::move(item));
+    }
+
+    if (!batch_items_.empty())
+        batch_packet_ends_.emplace_back(batch_items_.size());
+}
+
 std::unique_ptr<FilePacketizer> FilePacketizer::create(const std::filesystem::path& file_path)
 {
     std::ifstream file_stream;
@@ -53,26 +91,40 @@ std::unique_ptr<FilePacketizer> FilePacketizer::create(const std::filesystem::pa
     return std::unique_ptr<FilePacketizer>(new FilePacketizer(std::move(file_stream)));
 }
 
-std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
-    const proto::FilePacketRequest& request)
+// static
+std::unique_ptr<FilePacketizer> FilePacketizer::createBatch(
+    std::vector<std::filesystem::path> file_paths)
 {
-    DCHECK(file_stream_.is_open());
+    if (file_paths.empty())
+        return nullptr;
 
-    // Create a new file packet.
-    std::unique_ptr<proto::FilePacket> packet = std::make_unique<proto::FilePacket>();
+    return std::unique_ptr<FilePacketizer>(new FilePacketizer(std::move(file_paths)));
+}
 
+std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
+    const proto::FilePacketRequest& request)
+{
     if (request.flags() & proto::FilePacketRequest::CANCEL)
     {
+        std::unique_ptr<proto::FilePacket> packet = std::make_unique<proto::FilePacket>();
         packet->set_flags(proto::FilePacket::LAST_PACKET);
         return packet;
     }
 
+    if (!batch_items_.empty())
+        return readNextBatchPacket();
+
+    DCHECK(file_stream_.is_open());
+
+    // Create a new file packet.
+    std::unique_ptr<proto::FilePacket> packet = std::make_unique<proto::FilePacket>();
+
     size_t packet_buffer_size = kMaxFilePacketSize;
 
     if (left_size_ < kMaxFilePacketSize)
         packet_buffer_size = static_cast<size_t>(left_size_);
 
-    char* packet_buffer = outputBuffer(packet.get(), packet_buffer_size);
+    char* packet_buffer = outputBuffer(packet->mutable_data(), packet_buffer_size);
 
     // Moving to a new position in file.
     file_stream_.seekg(static_cast<std::streamoff>(file_size_ - left_size_));
@@ -105,4 +157,77 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
     return packet;
 }
 
+std::unique_ptr<proto::FilePacket> FilePacketizer::readNextBatchPacket()
+{
+    if (batch_packet_index_ >= batch_packet_ends_.size())
+    {
+        LOG(LS_WARNING) << "No more packets in batch";
+        return nullptr;
+    }
+
+    std::unique_ptr<proto::FilePacket> packet = std::make_unique<proto::FilePacket>();
+
+    size_t begin = batch_packet_index_ ? batch_packet_ends_[batch_packet_index_ - 1] : 0;
+    size_t end = batch_packet_ends_[batch_packet_index_];
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const BatchItem& item = batch_items_[i];
+
+        proto::FileBatchItem* batch_item = packet->add_batch_item();
+        batch_item->set_index(static_cast<uint32_t>(i));
+
+        proto::FileError error_code = item.error_code;
+
+        if (error_code == proto::FILE_ERROR_SUCCESS)
+        {
+            std::ifstream file_stream;
+            file_stream.open(item.path, std::ifstream::binary);
+
+            if (!file_stream.is_open())
+            {
+                error_code = proto::FILE_ERROR_FILE_OPEN_ERROR;
+            }
+            else
+            {
+                file_stream.seekg(0, file_stream.end);
+
+                // The size is known when the packet boundaries are calculated and must not change.
+                if (static_cast<uint64_t>(file_stream.tellg()) != item.size)
+                {
+                    error_code = proto::FILE_ERROR_FILE_READ_ERROR;
+                }
+                else
+                {
+                    file_stream.seekg(0);
+
+                    char* buffer = outputBuffer(batch_item->mutable_data(), item.size);
+                    file_stream.read(buffer, static_cast<std::streamsize>(item.size));
+                    if (file_stream.fail())
+                        error_code = proto::FILE_ERROR_FILE_READ_ERROR;
+                }
+            }
+        }
+
+        if (error_code != proto::FILE_ERROR_SUCCESS)
+        {
+            LOG(LS_WARNING) << "Unable to read file in batch: " << item.path
+                            << " (" << error_code << ")";
+            batch_item->clear_data();
+        }
+
+        batch_item->set_error_code(error_code);
+    }
+
+    if (batch_packet_index_ == 0)
+        packet->set_flags(packet->flags() | proto::FilePacket::FIRST_PACKET);
+
+    ++batch_packet_index_;
+
+    if (batch_packet_index_ == batch_packet_ends_.size())
+        packet->set_flags(packet->flags() | proto::FilePacket::LAST_PACKET);
+
+    return packet;
+}
+
 } // namespace common
@@ -25,6 +25,7 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <vector>
 
 namespace common {
 
@@ -38,11 +39,34 @@ public:
     // If the specified file can not be opened for reading, then returns nullptr.
     static std::unique_ptr<FilePacketizer> create(const std::filesystem::path& file_path);
 
+    // Creates an instance for transferring a batch of small files. Each packet contains one or
+    // more whole files. Files are opened only when their packet is read, errors are reported in
+    // the packet for each file separately.
+    static std::unique_ptr<FilePacketizer> createBatch(
+        std::vector<std::filesystem::path> file_paths);
+
+    // Returns the number of packets in the batch.
+    size_t batchPacketCount() const { return batch_packet_ends_.size(); }
+
     // Creates a packet for transferring.
     std::unique_ptr<proto::FilePacket> readNextPacket(const proto::FilePacketRequest& request);
 
 private:
     explicit FilePacketizer(std::ifstream&& file_stream);
+    explicit FilePacketizer(std::vector<std::filesystem::path>&& batch_paths);
+
+    std::unique_ptr<proto::FilePacket> readNextBatchPacket();
+
+    struct BatchItem
+    {
+        std::filesystem::path path;
+        proto::FileError error_code;
+        uint64_t size;
+    };
+
+    std::vector<BatchItem> batch_items_;
+    std::vector<size_t> batch_packet_ends_; // Index of the item following each packet.
+    size_t batch_packet_index_ = 0;
 
     std::ifstream file_stream_;
 
@@ -48,6 +48,17 @@ std::shared_ptr<FileTask> FileTaskFactory::fileList(const std::string& path)
     return makeTask(std::move(request));
 }
 
+std::shared_ptr<FileTask> FileTaskFactory::fileTree(const std::string& path, uint32_t flags)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::FileTreeRequest* file_tree_request = request->mutable_file_tree_request();
+    file_tree_request->set_path(path);
+    file_tree_request->set_flags(flags);
+
+    return makeTask(std::move(request));
+}
+
 std::shared_ptr<FileTask> FileTaskFactory::createDirectory(const std::string& path)
 {
     auto request = std::make_unique<proto::FileRequest>();
@@ -92,6 +103,31 @@ std::shared_ptr<FileTask> FileTaskFactory::upload(const std::string& file_path,
     return makeTask(std::move(request));
 }
 
+std::shared_ptr<FileTask> FileTaskFactory::batchDownload(
+    const std::vector<std::string>& file_paths)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::DownloadRequest* download_request = request->mutable_download_request();
+    for (const auto& file_path : file_paths)
+        download_request->add_batch_path(file_path);
+
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::batchUpload(
+    const std::vector<std::string>& file_paths, bool overwrite)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::UploadRequest* upload_request = request->mutable_upload_request();
+    for (const auto& file_path : file_paths)
+        upload_request->add_batch_path(file_path);
+    upload_request->set_overwrite(overwrite);
+
+    return makeTask(std::move(request));
+}
+
 std::shared_ptr<FileTask> FileTaskFactory::packetRequest(uint32_t flags)
 {
     auto request = std::make_unique<proto::FileRequest>();
@@ -22,6 +22,7 @@
 #include "common/file_task.h"
 
 #include <string>
+#include <vector>
 
 namespace proto {
 class FilePacket;
@@ -39,11 +40,15 @@ public:
 
     std::shared_ptr<FileTask> driveList();
     std::shared_ptr<FileTask> fileList(const std::string& path);
+    std::shared_ptr<FileTask> fileTree(const std::string& path, uint32_t flags);
     std::shared_ptr<FileTask> createDirectory(const std::string& path);
     std::shared_ptr<FileTask> rename(const std::string& old_name, const std::string& new_name);
     std::shared_ptr<FileTask> remove(const std::string& path);
     std::shared_ptr<FileTask> download(const std::string& file_path);
     std::shared_ptr<FileTask> upload(const std::string& file_path, bool overwrite);
+    std::shared_ptr<FileTask> batchDownload(const std::vector<std::string>& file_paths);
+    std::shared_ptr<FileTask> batchUpload(const std::vector<std::string>& file_paths,
+                                          bool overwrite);
     std::shared_ptr<FileTask> packetRequest(uint32_t flags);
     std::shared_ptr<FileTask> packet(const proto::FilePacket& packet);
     std::shared_ptr<FileTask> packet(std::unique_ptr<proto::FilePacket> packet);
@@ -0,0 +1,82 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "common/file_tree_enumerator.h"
+
+#include "base/logging.h"
+#include "common/file_enumerator.h"
+
+namespace common {
+
+FileTreeEnumerator::FileTreeEnumerator(const std::filesystem::path& root_path)
+{
+    levels_.push_back({ std::make_unique<FileEnumerator>(root_path), root_path, std::string() });
+}
+
+FileTreeEnumerator::~FileTreeEnumerator() = default;
+
+void FileTreeEnumerator::readNextChunk(size_t max_items, proto::FileList* file_list)
+{
+    DCHECK(file_list);
+
+    while (!levels_.empty() && static_cast<size_t>(file_list->item_size()) < max_items)
+    {
+        Level& level = levels_.back();
+
+        if (level.enumerator->isAtEnd())
+        {
+            if (level.enumerator->errorCode() != proto::FILE_ERROR_SUCCESS)
+            {
+                error_code_ = level.enumerator->errorCode();
+                levels_.clear();
+                return;
+            }
+
+            levels_.pop_back();
+            continue;
+        }
+
+        const FileEnumerator::FileInfo& file_info = level.enumerator->fileInfo();
+        std::string name = level.prefix + file_info.u8name();
+
+        proto::FileList::Item* item = file_list->add_item();
+        item->set_name(name);
+        item->set_size(static_cast<uint64_t>(file_info.size()));
+        item->set_modification_time(file_info.lastWriteTime());
+        item->set_is_directory(file_info.isDirectory());
+
+        std::filesystem::path child_path = level.path / file_info.name();
+        level.enumerator->advance();
+
+        // |level| must not be used after this point: adding a level may move the vector.
+        if (item->is_directory())
+        {
+            levels_.push_back(
+                { std::make_unique<FileEnumerator>(child_path), child_path, name + '/' });
+        }
+    }
+
+    // Drop finished levels so that the caller does not request an empty chunk.
+    while (!levels_.empty() && levels_.back().enumerator->isAtEnd() &&
+           levels_.back().enumerator->errorCode() == proto::FILE_ERROR_SUCCESS)
+    {
+        levels_.pop_back();
+    }
+}
+
+} // namespace common
@@ -27,6 +27,7 @@
 #include "common/file_enumerator.h"
 #include "common/file_platform_util.h"
 #include "common/file_task.h"
+#include "common/file_tree_enumerator.h"
 
 #if defined(OS_WIN)
 #include "base/win/drive_enumerator.h"
@@ -34,6 +35,13 @@
 
 namespace common {
 
+namespace {
+
+// Maximum number of items in one reply to a file tree request.
+const size_t kMaxFileTreeChunkItems = 1024;
+
+} // namespace
+
 class FileWorker::Impl : public std::enable_shared_from_this<Impl>
 {
 public:
@@ -48,6 +56,7 @@ private:
     std::unique_ptr<proto::FileReply> doRequest(const proto::FileRequest& request);
     std::unique_ptr<proto::FileReply> doDriveListRequest();
     std::unique_ptr<proto::FileReply> doFileListRequest(const proto::FileListRequest& request);
+    std::unique_ptr<proto::FileReply> doFileTreeRequest(const proto::FileTreeRequest& request);
     std::unique_ptr<proto::FileReply> doCreateDirectoryRequest(const proto::CreateDirectoryRequest& request);
     std::unique_ptr<proto::FileReply> doRenameRequest(const proto::RenameRequest& request);
     std::unique_ptr<proto::FileReply> doRemoveRequest(const proto::RemoveRequest& request);
@@ -59,6 +68,7 @@ private:
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<FileDepacketizer> depacketizer_;
     std::unique_ptr<FilePacketizer> packetizer_;
+    std::unique_ptr<FileTreeEnumerator> tree_enumerator_;
 
     DISALLOW_COPY_AND_ASSIGN(Impl);
 };
@@ -96,6 +106,10 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doRequest(const proto::FileR
     {
         return doFileListRequest(request.file_list_request());
     }
+    else if (request.has_file_tree_request())
+    {
+        return doFileTreeRequest(request.file_tree_request());
+    }
     else if (request.has_create_directory_request())
     {
         return doCreateDirectoryRequest(request.create_directory_request());
@@ -259,6 +273,58 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
     return reply;
 }
 
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileTreeRequest(
+    const proto::FileTreeRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+
+    if (request.flags() & proto::FileTreeRequest::CONTINUE)
+    {
+        if (!tree_enumerator_)
+        {
+            // Set the unknown status of the request. The connection will be closed.
+            reply->set_error_code(proto::FILE_ERROR_UNKNOWN);
+            LOG(LS_WARNING) << "Unexpected file tree request";
+            return reply;
+        }
+    }
+    else
+    {
+        std::filesystem::path path = std::filesystem::u8path(request.path());
+
+        std::error_code ignored_code;
+        std::filesystem::file_status status = std::filesystem::status(path, ignored_code);
+
+        if (!std::filesystem::exists(status))
+        {
+            tree_enumerator_.reset();
+            reply->set_error_code(proto::FILE_ERROR_PATH_NOT_FOUND);
+            return reply;
+        }
+
+        if (!std::filesystem::is_directory(status))
+        {
+            tree_enumerator_.reset();
+            reply->set_error_code(proto::FILE_ERROR_INVALID_PATH_NAME);
+            return reply;
+        }
+
+        tree_enumerator_ = std::make_unique<FileTreeEnumerator>(path);
+    }
+
+    proto::FileList* file_list = reply->mutable_file_list();
+    tree_enumerator_->readNextChunk(kMaxFileTreeChunkItems, file_list);
+
+    reply->set_error_code(tree_enumerator_->errorCode());
+
+    if (tree_enumerator_->isAtEnd())
+        tree_enumerator_.reset();
+    else
+        file_list->set_has_more(true);
+
+    return reply;
+}
+
 std::unique_ptr<proto::FileReply> FileWorker::Impl::doCreateDirectoryRequest(
     const proto::CreateDirectoryRequest& request)
 {
@@ -373,7 +439,23 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doDownloadRequest(
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
 
-    packetizer_ = FilePacketizer::create(std::filesystem::u8path(request.path()));
+    if (request.batch_path_size() > 0)
+    {
+        std::vector<std::filesystem::path> file_paths;
+        file_paths.reserve(static_cast<size_t>(request.batch_path_size()));
+
+        for (int i = 0; i < request.batch_path_size(); ++i)
+            file_paths.emplace_back(std::filesystem::u8path(request.batch_path(i)));
+
+        packetizer_ = FilePacketizer::createBatch(std::move(file_paths));
+        if (packetizer_)
+            reply->set_batch_packet_count(static_cast<uint32_t>(packetizer_->batchPacketCount()));
+    }
+    else
+    {
+        packetizer_ = FilePacketizer::create(std::filesystem::u8path(request.path()));
+    }
+
     if (!packetizer_)
         reply->set_error_code(proto::FILE_ERROR_FILE_OPEN_ERROR);
     else
@@ -387,6 +469,20 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doUploadRequest(
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
 
+    if (request.batch_path_size() > 0)
+    {
+        std::vector<std::filesystem::path> file_paths;
+        file_paths.reserve(static_cast<size_t>(request.batch_path_size()));
+
+        for (int i = 0; i < request.batch_path_size(); ++i)
+            file_paths.emplace_back(std::filesystem::u8path(request.batch_path(i)));
+
+        // Errors of separate files are reported in replies to the batch packets.
+        depacketizer_ = FileDepacketizer::createBatch(std::move(file_paths), request.overwrite());
+        reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+        return reply;
+    }
+
     std::filesystem::path file_path = std::filesystem::u8path(request.path());
 
     do
@@ -459,7 +555,18 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacket(const proto::FilePa
     }
     else
     {
-        if (!depacketizer_->writeNextPacket(packet))
+        bool result;
+
+        if (depacketizer_->isBatch())
+        {
+            result = depacketizer_->writeNextBatchPacket(packet, reply->mutable_batch_error());
+        }
+        else
+        {
+            result = depacketizer_->writeNextPacket(packet);
+        }
+
+        if (!result)
         {
             reply->set_error_code(proto::FILE_ERROR_FILE_WRITE_ERROR);
             depacketizer_.reset();
@@ -136,9 +136,10 @@ std::shared_ptr<base::TcpChannelProxy> ClientSession::channelProxy()
     return channel_->channelProxy();
 }
 
-void ClientSession::sendMessage(uint8_t channel_id, base::ByteArray&& buffer)
+void ClientSession::sendMessage(
+    uint8_t channel_id, base::ByteArray&& buffer, base::TcpChannel::Priority priority)
 {
-    channel_->send(channel_id, std::move(buffer));
+    channel_->send(channel_id, std::move(buffer), priority);
 }
 
 void ClientSession::onTcpConnected()
@@ -192,4 +193,14 @@ size_t ClientSession::pendingMessages() const
     return channel_->pendingMessages();
 }
 
+int64_t ClientSession::estimatedBandwidth() const
+{
+    return channel_->estimatedBandwidth();
+}
+
+bool ClientSession::isBandwidthMeasured() const
+{
+    return channel_->isBandwidthMeasured();
+}
+
 } // namespace host
@@ -94,7 +94,8 @@ protected:
     virtual void onWritten(uint8_t channel_id, size_t pending) = 0;
 
     std::shared_ptr<base::TcpChannelProxy> channelProxy();
-    void sendMessage(uint8_t channel_id, base::ByteArray&& buffer);
+    void sendMessage(uint8_t channel_id, base::ByteArray&& buffer,
+                     base::TcpChannel::Priority priority = base::TcpChannel::Priority::NORMAL);
 
     // base::TcpChannel::Listener implementation.
     void onTcpConnected() override;
@@ -103,6 +104,8 @@ protected:
     void onTcpMessageWritten(uint8_t channel_id, size_t pending) override;
 
     size_t pendingMessages() const;
+    int64_t estimatedBandwidth() const;
+    bool isBandwidthMeasured() const;
 
     Delegate* delegate_ = nullptr;
 
@@ -23,14 +23,13 @@
 #include "base/power_controller.h"
 #include "base/codec/audio_encoder_opus.h"
 #include "base/codec/cursor_encoder.h"
-#include "base/codec/scale_reducer.h"
-#include "base/codec/video_encoder_vpx.h"
-#include "base/codec/video_encoder_zstd.h"
+#include "base/codec/video_tile_cache.h"
 #include "base/desktop/frame.h"
 #include "base/desktop/screen_capturer.h"
 #include "common/desktop_session_constants.h"
 #include "host/desktop_session_proxy.h"
 #include "host/service_constants.h"
+#include "host/shared_video_encoder_manager.h"
 #include "proto/desktop_internal.pb.h"
 #include "proto/task_manager.pb.h"
 #include "proto/text_chat.pb.h"
@@ -82,6 +81,13 @@ void ClientSessionDesktop::setDesktopSessionProxy(
     DCHECK(desktop_session_proxy_);
 }
 
+void ClientSessionDesktop::setVideoEncoderManager(
+    base::local_shared_ptr<SharedVideoEncoderManager> manager)
+{
+    video_encoder_manager_ = std::move(manager);
+    DCHECK(video_encoder_manager_);
+}
+
 void ClientSessionDesktop::onStarted()
 {
     max_fps_ = desktop_session_proxy_->maxScreenCaptureFps();
@@ -146,15 +152,15 @@ void ClientSessionDesktop::onReceived(uint8_t /* channel_id */, const base::Byte
         if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
             return;
 
-        if (!scale_reducer_)
+        if (!video_encoder_)
             return;
 
         const proto::MouseEvent& mouse_event = incoming_message_->mouse_event();
 
         int pos_x = static_cast<int>(
-            static_cast<double>(mouse_event.x() * 100) / scale_reducer_->scaleFactorX());
+            static_cast<double>(mouse_event.x() * 100) / video_encoder_->scaleFactorX());
         int pos_y = static_cast<int>(
-            static_cast<double>(mouse_event.y() * 100) / scale_reducer_->scaleFactorY());
+            static_cast<double>(mouse_event.y() * 100) / video_encoder_->scaleFactorY());
 
         proto::MouseEvent out_mouse_event;
         out_mouse_event.set_mask(mouse_event.mask());
@@ -213,14 +219,16 @@ void ClientSessionDesktop::onTaskManagerMessage(const proto::task_manager::HostT
 
 void ClientSessionDesktop::encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor)
 {
+    video_packet_pending_ = false;
+
     if (critical_overflow_)
         return;
 
-    outgoing_message_->Clear();
+    const bool has_video_encoding = video_encoder_key_.encoding != proto::VIDEO_ENCODING_UNKNOWN;
 
-    if (!is_video_paused_ && frame && video_encoder_)
+    if (!is_video_paused_ && frame && has_video_encoding)
     {
-        DCHECK(scale_reducer_);
+        DCHECK(video_encoder_manager_);
 
         if (source_size_ != frame->size())
         {
@@ -252,52 +260,89 @@ void ClientSessionDesktop::encodeScreen(const base::Frame* frame, const base::Mo
                 current_size = forced_size_;
         }
 
-        const base::Frame* scaled_frame = scale_reducer_->scaleFrame(frame, current_size);
-        if (!scaled_frame)
+        video_encoder_key_.size = current_size;
+
+        if (!video_encoder_ || video_encoder_->key() != video_encoder_key_)
         {
-            LOG(LS_ERROR) << "No scaled frame";
-            return;
+            // Clients with the same parameters use the same encoder.
+            video_encoder_ = video_encoder_manager_->encoder(video_encoder_key_);
+            video_encoder_member_ = SharedVideoEncoder::Member();
         }
 
-        proto::VideoPacket* packet = outgoing_message_->mutable_video_packet();
+        if (video_encoder_)
+        {
+            video_encoder_member_.target_bitrate = video_target_bitrate_;
 
-        // Encode the frame into a video packet.
-        if (!video_encoder_->encode(scaled_frame, packet))
+            // The frame is encoded only once for all clients with the same encoder. The packet is
+            // sent in sendVideoPacket() when the encoding is finished.
+            video_encoder_->requestFrame(video_encoder_manager_->frameId(), video_encoder_member_);
+            video_packet_pending_ = true;
+        }
+        else
         {
-            LOG(LS_ERROR) << "Unable to encode video packet";
-            return;
+            LOG(LS_ERROR) << "Unable to get video encoder";
         }
+    }
+
+    if (cursor && cursor_encoder_)
+    {
+        outgoing_message_->Clear();
 
-        if (packet->has_format())
+        if (cursor_encoder_->encode(*cursor, outgoing_message_->mutable_cursor_shape()))
         {
-            proto::VideoPacketFormat* format = packet->mutable_format();
-
-            // In video packets that contain the format, we pass the screen capture type.
-            format->set_capturer_type(frame->capturerType());
-
-            // Real screen size.
-            proto::Size* screen_size = format->mutable_screen_size();
-            screen_size->set_width(frame->size().width());
-            screen_size->set_height(frame->size().height());
-
-            LOG(LS_INFO) << "Video packet has format";
-            LOG(LS_INFO) << "Capturer type: " << base::ScreenCapturer::typeToString(
-                static_cast<base::ScreenCapturer::Type>(frame->capturerType()));
-            LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x"
-                         << screen_size->height();
-            LOG(LS_INFO) << "Video size: " << format->video_rect().width() << "x"
-                         << format->video_rect().height();
+            // The cursor must not wait for the video packets.
+            sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_),
+                        base::TcpChannel::Priority::HIGH);
         }
     }
+}
 
-    if (cursor && cursor_encoder_)
+void ClientSessionDesktop::sendVideoPacket(const base::Frame* frame)
+{
+    if (!video_packet_pending_)
+        return;
+
+    video_packet_pending_ = false;
+
+    if (critical_overflow_ || !video_encoder_ || !frame)
+        return;
+
+    outgoing_message_->Clear();
+    proto::VideoPacket* packet = outgoing_message_->mutable_video_packet();
+
+    if (!video_encoder_->copyPacket(&video_encoder_member_, packet))
     {
-        if (!cursor_encoder_->encode(*cursor, outgoing_message_->mutable_cursor_shape()))
-            outgoing_message_->clear_cursor_shape();
+        // The packet is not available for this client yet.
+        return;
     }
 
-    if (outgoing_message_->has_video_packet() || outgoing_message_->has_cursor_shape())
-        sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_));
+    if (packet->has_format())
+    {
+        proto::VideoPacketFormat* format = packet->mutable_format();
+
+        // In video packets that contain the format, we pass the screen capture type.
+        format->set_capturer_type(frame->capturerType());
+
+        // Real screen size.
+        proto::Size* screen_size = format->mutable_screen_size();
+        screen_size->set_width(frame->size().width());
+        screen_size->set_height(frame->size().height());
+
+        LOG(LS_INFO) << "Video packet has format";
+        LOG(LS_INFO) << "Capturer type: " << base::ScreenCapturer::typeToString(
+            static_cast<base::ScreenCapturer::Type>(frame->capturerType()));
+        LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x"
+                     << screen_size->height();
+        LOG(LS_INFO) << "Video size: " << format->video_rect().width() << "x"
+                     << format->video_rect().height();
+    }
+
+    packet->set_bandwidth(static_cast<uint32_t>(
+        std::min<int64_t>(estimatedBandwidth(), std::numeric_limits<uint32_t>::max())));
+
+    // Large video packets are sent in chunks and do not delay other messages.
+    sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_),
+                base::TcpChannel::Priority::LOW);
 }
 
 void ClientSessionDesktop::encodeAudio(const proto::AudioPacket& audio_packet)
@@ -322,7 +367,8 @@ void ClientSessionDesktop::setVideoErrorCode(proto::VideoErrorCode error_code)
 
     outgoing_message_->Clear();
     outgoing_message_->mutable_video_packet()->set_error_code(error_code);
-    sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_));
+    sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_),
+                base::TcpChannel::Priority::LOW);
 }
 
 void ClientSessionDesktop::setCursorPosition(const proto::CursorPosition& cursor_position)
@@ -332,16 +378,20 @@ void ClientSessionDesktop::setCursorPosition(const proto::CursorPosition& cursor
 
     outgoing_message_->Clear();
 
+    if (!video_encoder_)
+        return;
+
     int pos_x = static_cast<int>(
-        static_cast<double>(cursor_position.x()) * scale_reducer_->scaleFactorX() / 100.0);
+        static_cast<double>(cursor_position.x()) * video_encoder_->scaleFactorX() / 100.0);
     int pos_y = static_cast<int>(
-        static_cast<double>(cursor_position.y()) * scale_reducer_->scaleFactorY() / 100.0);
+        static_cast<double>(cursor_position.y()) * video_encoder_->scaleFactorY() / 100.0);
 
     proto::CursorPosition* position = outgoing_message_->mutable_cursor_position();
     position->set_x(pos_x);
     position->set_y(pos_y);
 
-    sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_));
+    sendMessage(proto::HOST_CHANNEL_ID_SESSION, base::serialize(*outgoing_message_),
+                base::TcpChannel::Priority::HIGH);
 }
 
 void ClientSessionDesktop::setScreenList(const proto::ScreenList& list)
@@ -414,35 +464,42 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
 
 void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
 {
+    video_encoder_.reset();
+    video_encoder_key_ = SharedVideoEncoder::Key();
+
     switch (config.video_encoding())
     {
         case proto::VIDEO_ENCODING_VP8:
-            video_encoder_ = base::VideoEncoderVPX::createVP8();
-            break;
-
         case proto::VIDEO_ENCODING_VP9:
-            video_encoder_ = base::VideoEncoderVPX::createVP9();
             break;
 
         case proto::VIDEO_ENCODING_ZSTD:
-            video_encoder_ = base::VideoEncoderZstd::create(
-                parsePixelFormat(config.pixel_format()), static_cast<int>(config.compress_ratio()));
-            break;
+        {
+            video_encoder_key_.pixel_format = parsePixelFormat(config.pixel_format());
+            video_encoder_key_.compress_ratio = static_cast<int>(config.compress_ratio());
+
+            // Older clients do not send the flag. They would ignore the copy rectangles and show
+            // stale pixels in the moved areas.
+            video_encoder_key_.copy_rect = config.copy_rect();
+
+            // Older clients do not send the tile cache size, so the cache stays disabled.
+            video_encoder_key_.tile_cache_size =
+                std::min<size_t>(config.tile_cache_size(), base::VideoTileCache::kMaxCapacity);
+        }
+        break;
 
         default:
         {
             // No supported video encoding.
             LOG(LS_WARNING) << "Unsupported video encoding: " << config.video_encoding();
+            LOG(LS_ERROR) << "Video encoder not initialized!";
         }
-        break;
-    }
-
-    if (!video_encoder_)
-    {
-        LOG(LS_ERROR) << "Video encoder not initialized!";
         return;
     }
 
+    // The encoder is created (or shared with other clients) when the first frame is received.
+    video_encoder_key_.encoding = config.video_encoding();
+
     switch (config.audio_encoding())
     {
         case proto::AUDIO_ENCODING_OPUS:
@@ -461,8 +518,6 @@ void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
     if (config.flags() & proto::ENABLE_CURSOR_SHAPE)
         cursor_encoder_ = std::make_unique<base::CursorEncoder>();
 
-    scale_reducer_ = std::make_unique<base::ScaleReducer>();
-
     desktop_session_config_.disable_font_smoothing =
         (config.flags() & proto::DISABLE_FONT_SMOOTHING);
     desktop_session_config_.disable_effects =
@@ -556,7 +611,7 @@ void ClientSessionDesktop::readVideoPauseExtension(const std::string& data)
             return;
         }
 
-        video_encoder_->setKeyFrameRequired(true);
+        video_encoder_->setKeyFrameRequired();
     }
 }
 
@@ -762,6 +817,8 @@ void ClientSessionDesktop::onOverflowDetectionTimer()
     // Maximum average number of messages in the send queue.
     static const size_t kWarningPendingCount = 2;
 
+    updateTargetBitrate();
+
     size_t pending = pendingMessages();
     if (pending > kCriticalPendingCount)
     {
@@ -788,7 +845,7 @@ void ClientSessionDesktop::onOverflowDetectionTimer()
         if (critical_overflow_)
         {
             if (video_encoder_)
-                video_encoder_->setKeyFrameRequired(true);
+                video_encoder_->setKeyFrameRequired();
         }
 
         critical_overflow_ = false;
@@ -797,6 +854,13 @@ void ClientSessionDesktop::onOverflowDetectionTimer()
 
         LOG(LS_INFO) << "Overflow finished: " << pending;
     }
+    else if (isBandwidthLimited(desktop_session_proxy_->screenCaptureFps()))
+    {
+        // The queue is empty, but the estimated bandwidth is too low for the current frame rate
+        // and size.
+        write_normal_count_ = 1;
+        downStepOverflow();
+    }
     else if (write_normal_count_ > 0)
     {
         ++write_normal_count_;
@@ -813,13 +877,70 @@ void ClientSessionDesktop::onOverflowDetectionTimer()
         }
 
         // Trying to raise the current FPS every 10 seconds.
-        if ((write_normal_count_ % 10) == 0)
+        if ((write_normal_count_ % 10) == 0 &&
+            !isBandwidthLimited(desktop_session_proxy_->screenCaptureFps() + 1))
+        {
             upStepOverflow();
+        }
     }
 
     last_pending_count_ = pending;
 }
 
+void ClientSessionDesktop::updateTargetBitrate()
+{
+    // Limits of the target bitrate of the video encoder (kbps).
+    static const int64_t kMinVideoBitrate = 100;
+    static const int64_t kMaxVideoBitrate = 100000;
+
+    // Part of the channel is left for cursor shapes, clipboard and other messages.
+    int64_t bitrate = estimatedBandwidth() * 8 * 85 / 100;
+    if (audio_encoder_ && !is_audio_paused_)
+        bitrate -= audio_encoder_->bitrate();
+
+    const uint32_t target_bitrate = static_cast<uint32_t>(
+        std::clamp(bitrate / 1000, kMinVideoBitrate, kMaxVideoBitrate));
+
+    // Do not log small changes.
+    if (target_bitrate > video_target_bitrate_ * 5 / 4 ||
+        target_bitrate < video_target_bitrate_ * 4 / 5)
+    {
+        LOG(LS_INFO) << "Target bitrate: " << video_target_bitrate_ << " to " << target_bitrate
+                     << " kbps";
+    }
+
+    video_target_bitrate_ = target_bitrate;
+}
+
+bool ClientSessionDesktop::isBandwidthLimited(int fps) const
+{
+    // The VPX encoders keep the target bitrate by lowering the quality. Below this number of bits
+    // per pixel the picture becomes too blurry and it is better to reduce the frame rate and the
+    // size.
+    static const double kMinBitsPerPixel = 0.02;
+
+    if (video_encoder_key_.encoding != proto::VIDEO_ENCODING_VP8 &&
+        video_encoder_key_.encoding != proto::VIDEO_ENCODING_VP9)
+    {
+        // The bitrate of other encoders is not controlled.
+        return false;
+    }
+
+    // Until the channel has been congested, the estimate is only a lower bound of the bandwidth
+    // (it does not grow while the screen is static). It must not reduce the frame rate.
+    if (!isBandwidthMeasured())
+        return false;
+
+    const base::Size& size = video_encoder_key_.size;
+    if (fps <= 0 || size.isEmpty() || !video_target_bitrate_)
+        return false;
+
+    const double bits_per_pixel = static_cast<double>(video_target_bitrate_) * 1000.0 /
+        (static_cast<double>(fps) * size.width() * size.height());
+
+    return bits_per_pixel < kMinBitsPerPixel;
+}
+
 void ClientSessionDesktop::downStepOverflow()
 {
     int fps = desktop_session_proxy_->screenCaptureFps();
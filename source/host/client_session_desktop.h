@@ -26,6 +26,7 @@
 #include "base/waitable_timer.h"
 #include "host/client_session.h"
 #include "host/desktop_session.h"
+#include "host/shared_video_encoder.h"
 
 #if defined(OS_WIN)
 #include "host/task_manager.h"
@@ -36,13 +37,12 @@ class AudioEncoder;
 class CursorEncoder;
 class Frame;
 class MouseCursor;
-class ScaleReducer;
-class VideoEncoder;
 } // namespace base
 
 namespace host {
 
 class DesktopSessionProxy;
+class SharedVideoEncoderManager;
 
 class ClientSessionDesktop
     : public ClientSession
@@ -57,8 +57,14 @@ public:
     ~ClientSessionDesktop() override;
 
     void setDesktopSessionProxy(base::local_shared_ptr<DesktopSessionProxy> desktop_session_proxy);
+    void setVideoEncoderManager(base::local_shared_ptr<SharedVideoEncoderManager> manager);
 
+    // Sends the cursor and requests the encoding of |frame| from the video encoder of the client.
     void encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor);
+
+    // Sends the video packet for |frame| if it was requested by encodeScreen(). Must be called
+    // after the encoders of SharedVideoEncoderManager have finished.
+    void sendVideoPacket(const base::Frame* frame);
     void encodeAudio(const proto::AudioPacket& audio_packet);
     void setVideoErrorCode(proto::VideoErrorCode error_code);
     void setCursorPosition(const proto::CursorPosition& cursor_position);
@@ -91,12 +97,20 @@ private:
     void readVideoRecordingExtension(const std::string& data);
     void readTaskManagerExtension(const std::string& data);
     void onOverflowDetectionTimer();
+    void updateTargetBitrate();
+    bool isBandwidthLimited(int fps) const;
     void downStepOverflow();
     void upStepOverflow();
 
     base::local_shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
-    std::unique_ptr<base::ScaleReducer> scale_reducer_;
-    std::unique_ptr<base::VideoEncoder> video_encoder_;
+    base::local_shared_ptr<SharedVideoEncoderManager> video_encoder_manager_;
+
+    // Parameters of the video encoder requested by the client. The target size is calculated for
+    // each frame.
+    SharedVideoEncoder::Key video_encoder_key_;
+    base::local_shared_ptr<SharedVideoEncoder> video_encoder_;
+    SharedVideoEncoder::Member video_encoder_member_;
+    bool video_packet_pending_ = false;
     std::unique_ptr<base::CursorEncoder> cursor_encoder_;
     std::unique_ptr<base::AudioEncoder> audio_encoder_;
     DesktopSession::Config desktop_session_config_;
@@ -112,6 +126,7 @@ private:
     size_t last_pending_count_ = 0;
     bool critical_overflow_ = false;
     int max_fps_ = 0;
+    uint32_t video_target_bitrate_ = 0; // In kbps.
 
 #if defined(OS_WIN)
     std::unique_ptr<TaskManager> task_manager_;
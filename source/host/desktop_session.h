@@ -21,6 +21,8 @@
 
 #include "proto/desktop_internal.pb.h"
 
+#include <memory>
+
 namespace base {
 class Frame;
 class MouseCursor;
@@ -40,7 +42,11 @@ public:
 
         virtual void onDesktopSessionStarted() = 0;
         virtual void onDesktopSessionStopped() = 0;
-        virtual void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor) = 0;
+
+        // The delegate must call DesktopSession::frameProcessed() when it has finished processing
+        // the frame. The next frame is not captured until then and the frame remains unchanged.
+        virtual void onScreenCaptured(std::shared_ptr<const base::Frame> frame,
+                                      const base::MouseCursor* cursor) = 0;
         virtual void onScreenCaptureError(proto::VideoErrorCode error_code) = 0;
         virtual void onAudioCaptured(const proto::AudioPacket& audio_packet) = 0;
         virtual void onCursorPositionChanged(const proto::CursorPosition& cursor_position) = 0;
@@ -77,6 +83,7 @@ public:
     virtual void configure(const Config& config) = 0;
     virtual void selectScreen(const proto::Screen& screen) = 0;
     virtual void captureScreen() = 0;
+    virtual void frameProcessed() = 0;
 
     virtual void setScreenCaptureFps(int fps) = 0;
 
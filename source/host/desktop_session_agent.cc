@@ -141,8 +141,14 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
 
     if (incoming_message_->has_next_screen_capture())
     {
-        captureEnd(std::chrono::milliseconds(
-            incoming_message_->next_screen_capture().update_interval()));
+        const proto::internal::NextScreenCapture& next_screen_capture =
+            incoming_message_->next_screen_capture();
+        const std::chrono::milliseconds update_interval(next_screen_capture.update_interval());
+
+        if (next_screen_capture.processed())
+            onCaptureProcessed(update_interval);
+        else
+            captureEnd(update_interval);
     }
     else if (incoming_message_->has_mouse_event())
     {
@@ -385,6 +391,7 @@ void DesktopSessionAgent::onScreenCaptured(
     if (screen_captured->has_frame() || screen_captured->has_mouse_cursor())
     {
         channel_->send(base::serialize(*outgoing_message_));
+        onCaptureSent();
     }
     else
     {
@@ -413,6 +420,7 @@ void DesktopSessionAgent::onScreenCaptureError(base::ScreenCapturer::Error error
     }
 
     channel_->send(base::serialize(*outgoing_message_));
+    onCaptureSent();
 }
 
 void DesktopSessionAgent::onCursorPositionChanged(const base::Point& position)
@@ -488,6 +496,10 @@ void DesktopSessionAgent::setEnabled(bool enable)
         capture_scheduler_ = std::make_unique<base::CaptureScheduler>(
             std::chrono::milliseconds(40));
 
+        unprocessed_captures_.clear();
+        capture_count_ = 0;
+        capture_waiting_ = false;
+
         screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(
             preferred_video_capturer_, this);
         screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
@@ -544,6 +556,19 @@ void DesktopSessionAgent::captureBegin()
     if (!capture_scheduler_ || !screen_capturer_)
         return;
 
+    if (!unprocessed_captures_.empty())
+    {
+        const uint64_t queue_length = static_cast<uint64_t>(screen_capturer_->frameQueueLength());
+
+        if (capture_count_ + 1 - unprocessed_captures_.front() >= queue_length)
+        {
+            // The next capture would overwrite a frame that the service is still using.
+            capture_waiting_ = true;
+            return;
+        }
+    }
+
+    ++capture_count_;
     capture_scheduler_->beginCapture();
     screen_capturer_->captureFrame();
 }
@@ -574,6 +599,38 @@ void DesktopSessionAgent::captureEnd(const std::chrono::milliseconds& update_int
     }
 }
 
+void DesktopSessionAgent::onCaptureProcessed(const std::chrono::milliseconds& update_interval)
+{
+    if (!unprocessed_captures_.empty())
+        unprocessed_captures_.pop_front();
+
+    if (!capture_scheduler_)
+    {
+        LOG(LS_WARNING) << "No capture scheduler";
+        return;
+    }
+
+    capture_scheduler_->setUpdateInterval(update_interval);
+
+    if (capture_waiting_)
+    {
+        // The frame buffer is free. The delay before the capture has already expired.
+        capture_waiting_ = false;
+
+        io_task_runner_->postTask(
+            std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+    }
+}
+
+void DesktopSessionAgent::onCaptureSent()
+{
+    unprocessed_captures_.push_back(capture_count_);
+
+    // Do not wait until the service processes the frame. The next capture is made while the
+    // service encodes this one.
+    captureEnd(capture_scheduler_->updateInterval());
+}
+
 #if defined(OS_WIN)
 bool DesktopSessionAgent::onWindowsMessage(
     UINT message, WPARAM /* wparam */, LPARAM /* lparam */, LRESULT& result)
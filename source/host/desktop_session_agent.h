@@ -27,6 +27,8 @@
 #include "common/clipboard_monitor.h"
 #include "proto/desktop_internal.pb.h"
 
+#include <deque>
+
 namespace base {
 
 class AudioCapturerWrapper;
@@ -89,6 +91,8 @@ private:
     void setEnabled(bool enable);
     void captureBegin();
     void captureEnd(const std::chrono::milliseconds& update_interval);
+    void onCaptureProcessed(const std::chrono::milliseconds& update_interval);
+    void onCaptureSent();
 
 #if defined(OS_WIN)
     bool onWindowsMessage(UINT message, WPARAM wparam, LPARAM lparam, LRESULT& result);
@@ -116,6 +120,14 @@ private:
     bool lock_at_disconnect_ = false;
     bool clear_clipboard_ = false;
 
+    // Captures whose messages were sent to the service and not yet processed by it. The capturer
+    // reuses its frame buffers in turn, so a capture that would overwrite the buffer of one of
+    // them waits until the service has processed it. While the service encodes a frame, the next
+    // frame is captured into another buffer.
+    std::deque<uint64_t> unprocessed_captures_;
+    uint64_t capture_count_ = 0;
+    bool capture_waiting_ = false;
+
     std::unique_ptr<proto::internal::ServiceToDesktop> incoming_message_;
     std::unique_ptr<proto::internal::DesktopToService> outgoing_message_;
 
@@ -19,6 +19,7 @@
 #include "host/desktop_session_ipc.h"
 
 #include "base/logging.h"
+#include "base/desktop/frame_simple.h"
 #include "base/desktop/mouse_cursor.h"
 #include "base/desktop/shared_memory_frame.h"
 #include "base/memory/local_memory.h"
@@ -147,9 +148,18 @@ void DesktopSessionIpc::selectScreen(const proto::Screen& screen)
 
 void DesktopSessionIpc::captureScreen()
 {
-    if (last_frame_)
+    if (frame_in_use_)
     {
-        last_frame_->updatedRegion()->addRect(base::Rect::makeSize(last_frame_->size()));
+        // The frame will be sent again when the delegate finishes processing it.
+        refresh_required_ = true;
+        return;
+    }
+
+    if (last_frame_copy_)
+    {
+        last_frame_copy_->updatedRegion()->clear();
+        last_frame_copy_->updatedRegion()->addRect(
+            base::Rect::makeSize(last_frame_copy_->size()));
 
         if (delegate_)
         {
@@ -163,7 +173,8 @@ void DesktopSessionIpc::captureScreen()
                 LOG(LS_INFO) << "No last screen list";
             }
 
-            delegate_->onScreenCaptured(last_frame_.get(), last_mouse_cursor_.get());
+            frame_in_use_ = true;
+            delegate_->onScreenCaptured(last_frame_copy_, last_mouse_cursor_.get());
         }
         else
         {
@@ -178,6 +189,33 @@ void DesktopSessionIpc::captureScreen()
     }
 }
 
+void DesktopSessionIpc::frameProcessed()
+{
+    if (!frame_in_use_)
+        return;
+
+    frame_in_use_ = false;
+
+    // The agent can capture into the buffer of the processed frame.
+    sendNextScreenCapture();
+
+    if (!pending_screen_captured_.empty())
+    {
+        proto::internal::ScreenCaptured screen_captured =
+            std::move(pending_screen_captured_.front());
+        pending_screen_captured_.pop();
+
+        onScreenCaptured(screen_captured);
+        return;
+    }
+
+    if (refresh_required_)
+    {
+        refresh_required_ = false;
+        captureScreen();
+    }
+}
+
 void DesktopSessionIpc::setScreenCaptureFps(int fps)
 {
     if (fps > 60 || fps < 1)
@@ -294,7 +332,18 @@ void DesktopSessionIpc::onMessageReceived(const base::ByteArray& buffer)
 
 void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured& screen_captured)
 {
-    const base::Frame* frame = nullptr;
+    if (frame_in_use_)
+    {
+        // The previous frame can still be used by the encoders. The message is processed when the
+        // delegate finishes processing it.
+        pending_screen_captured_.push(screen_captured);
+        return;
+    }
+
+    // The agent does not reuse the frame buffer until it receives a notification.
+    next_capture_required_ = true;
+
+    std::shared_ptr<const base::Frame> frame;
     const base::MouseCursor* mouse_cursor = nullptr;
 
     if (screen_captured.has_frame())
@@ -321,7 +370,7 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
                     dirty_rect.x(), dirty_rect.y(), dirty_rect.width(), dirty_rect.height()));
             }
 
-            frame = last_frame_.get();
+            frame = last_frame_;
         }
     }
 
@@ -347,7 +396,8 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
     {
         if (screen_captured.error_code() == proto::VIDEO_ERROR_CODE_OK)
         {
-            delegate_->onScreenCaptured(frame, mouse_cursor);
+            frame_in_use_ = true;
+            delegate_->onScreenCaptured(std::move(frame), mouse_cursor);
         }
         else
         {
@@ -359,9 +409,7 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
         LOG(LS_WARNING) << "Invalid delegate";
     }
 
-    outgoing_message_->Clear();
-    outgoing_message_->mutable_next_screen_capture()->set_update_interval(update_interval_.count());
-    channel_->send(base::serialize(*outgoing_message_));
+    sendNextScreenCapture();
 }
 
 void DesktopSessionIpc::onCursorPositionChanged(const proto::CursorPosition& cursor_position)
@@ -414,7 +462,62 @@ void DesktopSessionIpc::onReleaseSharedBuffer(int shared_buffer_id)
     {
         LOG(LS_INFO) << "Reset last frame";
         last_frame_.reset();
+        last_frame_copy_.reset();
+    }
+}
+
+void DesktopSessionIpc::sendNextScreenCapture()
+{
+    // The notification is sent only after the delegate has finished processing the frame. If all
+    // frame buffers of the agent are in use, it waits for the notification before the next capture.
+    if (!next_capture_required_ || frame_in_use_)
+        return;
+
+    next_capture_required_ = false;
+
+    // The buffer of the last frame can be overwritten after the confirmation.
+    copyLastFrame();
+
+    outgoing_message_->Clear();
+
+    proto::internal::NextScreenCapture* next_screen_capture =
+        outgoing_message_->mutable_next_screen_capture();
+    next_screen_capture->set_update_interval(update_interval_.count());
+    next_screen_capture->set_processed(true);
+
+    channel_->send(base::serialize(*outgoing_message_));
+}
+
+void DesktopSessionIpc::copyLastFrame()
+{
+    if (!last_frame_)
+        return;
+
+    if (!last_frame_copy_ || last_frame_copy_->size() != last_frame_->size() ||
+        last_frame_copy_->format() != last_frame_->format())
+    {
+        last_frame_copy_ = base::FrameSimple::create(last_frame_->size(), last_frame_->format());
+        if (!last_frame_copy_)
+        {
+            LOG(LS_ERROR) << "Unable to create a copy of the frame";
+            return;
+        }
+
+        last_frame_copy_->copyPixelsFrom(
+            *last_frame_, base::Point(0, 0), base::Rect::makeSize(last_frame_->size()));
     }
+    else
+    {
+        // The copy already contains the previous frames. Only the changed areas are copied.
+        for (base::Region::Iterator it(last_frame_->constUpdatedRegion()); !it.isAtEnd();
+             it.advance())
+        {
+            base::Rect rect = it.rect();
+            last_frame_copy_->copyPixelsFrom(*last_frame_, rect.topLeft(), rect);
+        }
+    }
+
+    last_frame_copy_->copyFrameInfoFrom(*last_frame_);
 }
 
 std::unique_ptr<DesktopSessionIpc::SharedBuffer> DesktopSessionIpc::sharedBuffer(
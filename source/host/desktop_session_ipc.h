@@ -22,6 +22,8 @@
 #include "base/ipc/ipc_channel.h"
 #include "host/desktop_session.h"
 
+#include <queue>
+
 namespace host {
 
 class DesktopSessionIpc
@@ -39,6 +41,7 @@ public:
     void configure(const Config& config) override;
     void selectScreen(const proto::Screen& screen) override;
     void captureScreen() override;
+    void frameProcessed() override;
     void setScreenCaptureFps(int fps) override;
     void injectKeyEvent(const proto::KeyEvent& event) override;
     void injectTextEvent(const proto::TextEvent& event) override;
@@ -60,16 +63,33 @@ private:
     void onCreateSharedBuffer(int shared_buffer_id);
     void onReleaseSharedBuffer(int shared_buffer_id);
     std::unique_ptr<SharedBuffer> sharedBuffer(int shared_buffer_id);
+    void sendNextScreenCapture();
+    void copyLastFrame();
 
     std::unique_ptr<base::IpcChannel> channel_;
     SharedBuffers shared_buffers_;
-    std::unique_ptr<base::Frame> last_frame_;
+    std::shared_ptr<base::Frame> last_frame_;
+    // The agent can capture into the buffer of |last_frame_| after it is confirmed. The frame is
+    // copied before the confirmation and the copy is sent again on a refresh request.
+    std::shared_ptr<base::Frame> last_frame_copy_;
     std::unique_ptr<base::MouseCursor> last_mouse_cursor_;
     std::unique_ptr<proto::ScreenList> last_screen_list_;
     Delegate* delegate_;
 
     std::chrono::milliseconds update_interval_ { 40 }; // 25 fps by default.
 
+    // The delegate is processing the last frame. The frame cannot be changed until it calls
+    // frameProcessed().
+    bool frame_in_use_ = false;
+    // The processed frame must be confirmed to the agent. After that the agent can reuse its
+    // buffer.
+    bool next_capture_required_ = false;
+    // captureScreen() was called while the frame was in use.
+    bool refresh_required_ = false;
+    // The agent captures the next frames while the previous one is in use. They are processed in
+    // order.
+    std::queue<proto::internal::ScreenCaptured> pending_screen_captured_;
+
     std::unique_ptr<proto::internal::ServiceToDesktop> outgoing_message_;
     std::unique_ptr<proto::internal::DesktopToService> incoming_message_;
 
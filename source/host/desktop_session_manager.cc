@@ -191,9 +191,9 @@ void DesktopSessionManager::onDesktopSessionStopped()
 }
 
 void DesktopSessionManager::onScreenCaptured(
-    const base::Frame* frame, const base::MouseCursor* mouse_cursor)
+    std::shared_ptr<const base::Frame> frame, const base::MouseCursor* mouse_cursor)
 {
-    delegate_->onScreenCaptured(frame, mouse_cursor);
+    delegate_->onScreenCaptured(std::move(frame), mouse_cursor);
 }
 
 void DesktopSessionManager::onScreenCaptureError(proto::VideoErrorCode error_code)
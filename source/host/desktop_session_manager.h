@@ -59,7 +59,8 @@ protected:
     // DesktopSession::Delegate implementation.
     void onDesktopSessionStarted() override;
     void onDesktopSessionStopped() override;
-    void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* mouse_cursor) override;
+    void onScreenCaptured(std::shared_ptr<const base::Frame> frame,
+                          const base::MouseCursor* mouse_cursor) override;
     void onScreenCaptureError(proto::VideoErrorCode error_code) override;
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
     void onCursorPositionChanged(const proto::CursorPosition& cursor_position) override;
@@ -139,6 +139,12 @@ void DesktopSessionProxy::captureScreen()
         desktop_session_->captureScreen();
 }
 
+void DesktopSessionProxy::frameProcessed()
+{
+    if (desktop_session_)
+        desktop_session_->frameProcessed();
+}
+
 void DesktopSessionProxy::setScreenCaptureFps(int fps)
 {
     screen_capture_fps_ = fps;
@@ -37,6 +37,7 @@ public:
     void configure(const DesktopSession::Config& config);
     void selectScreen(const proto::Screen& screen);
     void captureScreen();
+    void frameProcessed();
     void setScreenCaptureFps(int fps);
     int screenCaptureFps() const;
     int defaultScreenCaptureFps() const;
@@ -94,6 +94,7 @@ void Server::start()
         std::bind(&Server::updateConfiguration, this, std::placeholders::_1, std::placeholders::_2));
 
     authenticator_manager_ = std::make_unique<base::ServerAuthenticatorManager>(task_runner_, this);
+    authenticator_manager_->setFeatures(proto::CHANNEL_FEATURE_CHUNKING);
 
     user_session_manager_ = std::make_unique<UserSessionManager>(task_runner_);
     user_session_manager_->start(this);
@@ -190,6 +191,13 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
     {
         LOG(LS_INFO) << "Using channel id support";
         session_info.channel->setChannelIdSupport(true);
+
+        // Chunking changes the format of messages, so it is used only if the client reports it.
+        if (session_info.features & proto::CHANNEL_FEATURE_CHUNKING)
+        {
+            LOG(LS_INFO) << "Using chunking support";
+            session_info.channel->setChunkingSupport(true);
+        }
     }
 
     std::unique_ptr<ClientSession> session = ClientSession::create(
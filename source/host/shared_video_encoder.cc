@@ -0,0 +1,201 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/shared_video_encoder.h"
+
+#include "base/logging.h"
+#include "base/codec/scale_reducer.h"
+#include "base/codec/video_encoder_vpx.h"
+#include "base/codec/video_encoder_zstd.h"
+
+namespace host {
+
+bool SharedVideoEncoder::Key::operator==(const Key& other) const
+{
+    if (encoding != other.encoding || size != other.size)
+        return false;
+
+    if (encoding == proto::VIDEO_ENCODING_ZSTD)
+    {
+        return pixel_format == other.pixel_format && compress_ratio == other.compress_ratio &&
+               copy_rect == other.copy_rect && tile_cache_size == other.tile_cache_size;
+    }
+
+    return true;
+}
+
+SharedVideoEncoder::SharedVideoEncoder(
+    const Key& key, std::unique_ptr<base::VideoEncoder> encoder)
+    : key_(key),
+      encoder_(std::move(encoder)),
+      scale_reducer_(std::make_unique<base::ScaleReducer>())
+{
+    LOG(LS_INFO) << "Ctor (encoding: " << key_.encoding << ", size: " << key_.size << ")";
+    DCHECK(encoder_);
+}
+
+SharedVideoEncoder::~SharedVideoEncoder()
+{
+    LOG(LS_INFO) << "Dtor";
+}
+
+// static
+std::unique_ptr<SharedVideoEncoder> SharedVideoEncoder::create(const Key& key)
+{
+    std::unique_ptr<base::VideoEncoder> encoder;
+
+    switch (key.encoding)
+    {
+        case proto::VIDEO_ENCODING_VP8:
+            encoder = base::VideoEncoderVPX::createVP8();
+            break;
+
+        case proto::VIDEO_ENCODING_VP9:
+            encoder = base::VideoEncoderVPX::createVP9();
+            break;
+
+        case proto::VIDEO_ENCODING_ZSTD:
+        {
+            std::unique_ptr<base::VideoEncoderZstd> zstd_encoder =
+                base::VideoEncoderZstd::create(key.pixel_format, key.compress_ratio);
+            zstd_encoder->setCopyRectEnabled(key.copy_rect);
+            zstd_encoder->setTileCacheSize(key.tile_cache_size);
+            encoder = std::move(zstd_encoder);
+        }
+        break;
+
+        default:
+            LOG(LS_WARNING) << "Unsupported video encoding: " << key.encoding;
+            break;
+    }
+
+    if (!encoder)
+        return nullptr;
+
+    return std::unique_ptr<SharedVideoEncoder>(new SharedVideoEncoder(key, std::move(encoder)));
+}
+
+void SharedVideoEncoder::requestFrame(int64_t frame_id, const Member& member)
+{
+    if (frame_id != frame_id_)
+    {
+        frame_id_ = frame_id;
+        frame_requested_ = true;
+        frame_encoded_ = false;
+
+        encode_key_frame_ = key_frame_required_;
+        key_frame_required_ = false;
+        target_bitrate_ = 0;
+    }
+
+    if (member.target_bitrate && (!target_bitrate_ || member.target_bitrate < target_bitrate_))
+        target_bitrate_ = member.target_bitrate;
+
+    // If the member missed the last packet, then it needs a key frame.
+    if (!member.packet_serial || member.packet_serial != packet_serial_)
+        encode_key_frame_ = true;
+}
+
+void SharedVideoEncoder::encodeFrame(const base::Frame* frame)
+{
+    DCHECK(frame);
+
+    if (!frame_requested_)
+        return;
+
+    frame_requested_ = false;
+
+    if (encode_key_frame_)
+        encoder_->setKeyFrameRequired(true);
+
+    if (target_bitrate_)
+        encoder_->setTargetBitrate(target_bitrate_);
+
+    const base::Frame* scaled_frame = scale_reducer_->scaleFrame(frame, key_.size);
+    if (!scaled_frame)
+    {
+        LOG(LS_ERROR) << "No scaled frame";
+        return;
+    }
+
+    packet_.Clear();
+    key_frame_ = encoder_->isKeyFrameRequired();
+
+    if (!encoder_->encode(scaled_frame, &packet_))
+    {
+        LOG(LS_ERROR) << "Unable to encode video packet";
+
+        // Members cannot skip a packet, so the next one must be a key frame.
+        encoder_->setKeyFrameRequired(true);
+        return;
+    }
+
+    ++packet_serial_;
+    frame_encoded_ = true;
+
+    if (packet_.has_format())
+    {
+        key_frame_ = true;
+        format_ = packet_.format();
+        format_serial_ = packet_serial_;
+    }
+}
+
+bool SharedVideoEncoder::copyPacket(Member* member, proto::VideoPacket* packet)
+{
+    DCHECK(member);
+    DCHECK(packet);
+
+    // The scale reducer is not used by other threads after the frame is encoded.
+    scale_factor_x_ = scale_reducer_->scaleFactorX();
+    scale_factor_y_ = scale_reducer_->scaleFactorY();
+
+    if (!frame_encoded_)
+    {
+        // Encoding of this frame failed.
+        return false;
+    }
+
+    if (!key_frame_ && member->packet_serial + 1 != packet_serial_)
+    {
+        // The member can't decode the packet without the previous ones.
+        key_frame_required_ = true;
+        return false;
+    }
+
+    packet->CopyFrom(packet_);
+
+    if (member->format_serial != format_serial_)
+    {
+        // The member has not yet received the current format.
+        if (!packet->has_format())
+            packet->mutable_format()->CopyFrom(format_);
+
+        member->format_serial = format_serial_;
+    }
+
+    member->packet_serial = packet_serial_;
+    return true;
+}
+
+void SharedVideoEncoder::setKeyFrameRequired()
+{
+    key_frame_required_ = true;
+}
+
+} // namespace host
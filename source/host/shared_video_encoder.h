@@ -0,0 +1,133 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_SHARED_VIDEO_ENCODER_H
+#define HOST_SHARED_VIDEO_ENCODER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/pixel_format.h"
+#include "proto/desktop.pb.h"
+
+#include <memory>
+
+namespace base {
+class Frame;
+class ScaleReducer;
+class VideoEncoder;
+} // namespace base
+
+namespace host {
+
+// Video encoder that is used by all desktop clients with the same encoding parameters. Every
+// captured frame is scaled and encoded only once, the clients receive copies of the packet.
+class SharedVideoEncoder
+{
+public:
+    struct Key
+    {
+        proto::VideoEncoding encoding = proto::VIDEO_ENCODING_UNKNOWN;
+        base::Size size;
+
+        // Used only for VIDEO_ENCODING_ZSTD.
+        base::PixelFormat pixel_format;
+        int compress_ratio = 0;
+        bool copy_rect = false; // Clients can apply VideoPacket.copy_rect.
+        size_t tile_cache_size = 0; // Number of tiles in the cache of clients.
+
+        bool operator==(const Key& other) const;
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    // State of the client which receives packets from the encoder.
+    struct Member
+    {
+        uint64_t packet_serial = 0; // Serial number of the last received packet.
+        uint64_t format_serial = 0; // Serial number of the last received format.
+        uint32_t target_bitrate = 0; // Bitrate (kbps) that the member can receive (0 if unknown).
+    };
+
+    ~SharedVideoEncoder();
+
+    // Creates an encoder for |key|. Returns nullptr if the encoding is not supported.
+    static std::unique_ptr<SharedVideoEncoder> create(const Key& key);
+
+    const Key& key() const { return key_; }
+
+    // Encoding of a frame is split into three steps:
+    // 1. Every member that needs the frame calls requestFrame() on the owner thread.
+    // 2. encodeFrame() is called once. It may be called on any thread, but until it returns no
+    //    other methods may be called.
+    // 3. Every member that requested the frame calls copyPacket() on the owner thread.
+
+    // Requests the encoding of the frame with identifier |frame_id| for |member|. If the member
+    // has missed previous packets, the frame will be encoded as a key frame. The frame is encoded
+    // with the lowest target bitrate of the members that requested it.
+    void requestFrame(int64_t frame_id, const Member& member);
+
+    // Returns true if the frame was requested but has not yet been encoded.
+    bool isFrameRequested() const { return frame_requested_; }
+
+    // Scales and encodes the requested frame.
+    void encodeFrame(const base::Frame* frame);
+
+    // Gets a copy of the encoded packet for |member|. Returns false if encoding failed or if the
+    // member cannot decode the packet. In the last case a key frame is requested.
+    bool copyPacket(Member* member, proto::VideoPacket* packet);
+
+    // Forces the next packet to be a key frame for all members.
+    void setKeyFrameRequired();
+
+    double scaleFactorX() const { return scale_factor_x_; }
+    double scaleFactorY() const { return scale_factor_y_; }
+
+private:
+    SharedVideoEncoder(const Key& key, std::unique_ptr<base::VideoEncoder> encoder);
+
+    const Key key_;
+    std::unique_ptr<base::VideoEncoder> encoder_;
+    std::unique_ptr<base::ScaleReducer> scale_reducer_;
+
+    // Accessed only on the owner thread.
+    bool key_frame_required_ = false;
+    double scale_factor_x_ = 0;
+    double scale_factor_y_ = 0;
+
+    // Parameters of the requested frame. Written by requestFrame() before encodeFrame() is called.
+    int64_t frame_id_ = -1;
+    bool frame_requested_ = false;
+    bool encode_key_frame_ = false;
+    uint32_t target_bitrate_ = 0;
+
+    // The last encoded packet and its parameters. Written by encodeFrame().
+    bool frame_encoded_ = false;
+    bool key_frame_ = false;
+    uint64_t packet_serial_ = 0;
+    proto::VideoPacket packet_;
+
+    // The last format sent by the encoder. Members which joined later receive it with the first
+    // key frame.
+    uint64_t format_serial_ = 0;
+    proto::VideoPacketFormat format_;
+
+    DISALLOW_COPY_AND_ASSIGN(SharedVideoEncoder);
+};
+
+} // namespace host
+
+#endif // HOST_SHARED_VIDEO_ENCODER_H
@@ -0,0 +1,163 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/shared_video_encoder_manager.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/desktop/frame.h"
+#include "base/threading/thread_pool.h"
+
+namespace host {
+
+SharedVideoEncoderManager::SharedVideoEncoderManager(
+    std::shared_ptr<base::TaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)),
+      alive_token_(std::make_shared<int>(0))
+{
+    LOG(LS_INFO) << "Ctor";
+    DCHECK(task_runner_);
+}
+
+SharedVideoEncoderManager::~SharedVideoEncoderManager()
+{
+    LOG(LS_INFO) << "Dtor";
+    alive_token_.reset();
+
+    // Wait for the encoders that are running. The frame and the encoders are destroyed after that.
+    thread_pool_.reset();
+}
+
+base::local_shared_ptr<SharedVideoEncoder> SharedVideoEncoderManager::encoder(
+    const SharedVideoEncoder::Key& key)
+{
+    for (auto it = encoders_.begin(); it != encoders_.end();)
+    {
+        base::local_shared_ptr<SharedVideoEncoder> encoder = it->lock();
+        if (!encoder)
+        {
+            // The encoder is no longer used by any client.
+            it = encoders_.erase(it);
+            continue;
+        }
+
+        if (encoder->key() == key)
+            return encoder;
+
+        ++it;
+    }
+
+    std::unique_ptr<SharedVideoEncoder> encoder = SharedVideoEncoder::create(key);
+    if (!encoder)
+        return nullptr;
+
+    base::local_shared_ptr<SharedVideoEncoder> result(encoder.release());
+    encoders_.emplace_back(result);
+
+    LOG(LS_INFO) << "Shared video encoder created (total: " << encoders_.size() << ")";
+    return result;
+}
+
+void SharedVideoEncoderManager::encodeFrame(
+    std::shared_ptr<const base::Frame> frame, EncodeCallback callback)
+{
+    DCHECK(task_runner_->belongsToCurrentThread());
+    DCHECK(!isEncoding());
+    DCHECK(callback);
+
+    if (frame)
+    {
+        for (const auto& weak_encoder : encoders_)
+        {
+            base::local_shared_ptr<SharedVideoEncoder> encoder = weak_encoder.lock();
+            if (encoder && encoder->isFrameRequested())
+                encoding_.emplace_back(std::move(encoder));
+        }
+    }
+
+    if (encoding_.empty())
+    {
+        callback();
+        return;
+    }
+
+    if (!thread_pool_)
+        thread_pool_ = std::make_unique<base::ThreadPool>();
+
+    encoding_frame_ = std::move(frame);
+    encoding_callback_ = std::move(callback);
+    encoding_remaining_ = encoding_.size();
+
+    std::weak_ptr<int> alive_token = alive_token_;
+    std::shared_ptr<base::TaskRunner> task_runner = task_runner_;
+    const base::Frame* source_frame = encoding_frame_.get();
+
+    for (const auto& encoder : encoding_)
+    {
+        // Only raw pointers are passed to the pool. The frame and the encoders are owned by this
+        // thread until all of them are finished.
+        SharedVideoEncoder* raw_encoder = encoder.get();
+
+        thread_pool_->postTask([this, alive_token, task_runner, raw_encoder, source_frame]()
+        {
+            raw_encoder->encodeFrame(source_frame);
+
+            task_runner->postTask([this, alive_token]()
+            {
+                // The manager can be destroyed while the encoding is in progress.
+                if (alive_token.expired())
+                    return;
+
+                onEncoderFinished();
+            });
+        });
+    }
+}
+
+size_t SharedVideoEncoderManager::encoderCount() const
+{
+    size_t count = 0;
+
+    for (const auto& encoder : encoders_)
+    {
+        if (!encoder.expired())
+            ++count;
+    }
+
+    return count;
+}
+
+void SharedVideoEncoderManager::onEncoderFinished()
+{
+    DCHECK(task_runner_->belongsToCurrentThread());
+    DCHECK_GT(encoding_remaining_, 0u);
+
+    if (--encoding_remaining_)
+        return;
+
+    EncodeCallback callback = std::move(encoding_callback_);
+
+    encoding_callback_ = nullptr;
+    encoding_frame_.reset();
+    encoding_.clear();
+
+    if (callback)
+        callback();
+}
+
+} // namespace host
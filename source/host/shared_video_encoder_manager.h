@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_SHARED_VIDEO_ENCODER_MANAGER_H
+#define HOST_SHARED_VIDEO_ENCODER_MANAGER_H
+
+#include "base/memory/local_memory.h"
+#include "host/shared_video_encoder.h"
+
+#include <functional>
+#include <vector>
+
+namespace base {
+class TaskRunner;
+class ThreadPool;
+} // namespace base
+
+namespace host {
+
+// Keeps video encoders that are shared between desktop clients of the same user session.
+// An encoder exists while at least one client uses it. Different encoders encode the same frame
+// in parallel on a thread pool.
+class SharedVideoEncoderManager
+{
+public:
+    explicit SharedVideoEncoderManager(std::shared_ptr<base::TaskRunner> task_runner);
+    ~SharedVideoEncoderManager();
+
+    // Returns an existing encoder for |key| or creates a new one. Returns nullptr if the encoder
+    // cannot be created.
+    base::local_shared_ptr<SharedVideoEncoder> encoder(const SharedVideoEncoder::Key& key);
+
+    // Must be called for every captured frame before the frame is passed to the clients.
+    void onFrameCaptured() { ++frame_id_; }
+
+    // Identifier of the current captured frame.
+    int64_t frameId() const { return frame_id_; }
+
+    using EncodeCallback = std::function<void()>;
+
+    // Encodes |frame| by all encoders for which the frame was requested. The encoders work in
+    // parallel, |callback| is called on the current thread when the slowest of them has finished.
+    // The frame and the encoders are kept alive until then. If no encoder has requested the frame,
+    // |callback| is called immediately.
+    void encodeFrame(std::shared_ptr<const base::Frame> frame, EncodeCallback callback);
+
+    // The callback of the current encoding will not be called. The encoders that are already
+    // running finish their work.
+    void cancelEncoding() { encoding_callback_ = nullptr; }
+
+    // Returns true if the encoding started by encodeFrame() has not yet finished.
+    bool isEncoding() const { return !encoding_.empty(); }
+
+    size_t encoderCount() const;
+
+private:
+    void onEncoderFinished();
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    std::unique_ptr<base::ThreadPool> thread_pool_;
+    std::shared_ptr<int> alive_token_;
+
+    std::vector<base::local_weak_ptr<SharedVideoEncoder>> encoders_;
+    int64_t frame_id_ = 0;
+
+    // State of the current encoding.
+    std::vector<base::local_shared_ptr<SharedVideoEncoder>> encoding_;
+    std::shared_ptr<const base::Frame> encoding_frame_;
+    EncodeCallback encoding_callback_;
+    size_t encoding_remaining_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(SharedVideoEncoderManager);
+};
+
+} // namespace host
+
+#endif // HOST_SHARED_VIDEO_ENCODER_MANAGER_H
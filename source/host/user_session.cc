@@ -24,6 +24,7 @@
 #include "base/scoped_task_runner.h"
 #include "base/crypto/password_generator.h"
 #include "base/desktop/frame.h"
+#include "base/desktop/mouse_cursor.h"
 #include "base/strings/strcat.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
@@ -31,6 +32,7 @@
 #include "host/client_session_desktop.h"
 #include "host/client_session_text_chat.h"
 #include "host/desktop_session_proxy.h"
+#include "host/shared_video_encoder_manager.h"
 
 #if defined(OS_WIN)
 #include "base/win/session_enumerator.h"
@@ -72,6 +74,7 @@ UserSession::UserSession(std::shared_ptr<base::TaskRunner> task_runner,
       desktop_dettach_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
       session_id_(session_id),
       password_expire_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
+      video_encoder_manager_(base::make_local_shared<SharedVideoEncoderManager>(task_runner)),
       delegate_(delegate)
 {
     type_ = UserSession::Type::CONSOLE;
@@ -112,6 +115,9 @@ UserSession::~UserSession()
     LOG(LS_INFO) << "Dtor (sid: " << session_id_
                  << " type: " << typeToString(type_)
                  << " state: " << stateToString(state_) << ")";
+
+    // Clients can keep the encoder manager after the session is destroyed.
+    video_encoder_manager_->cancelEncoding();
 }
 
 // static
@@ -748,10 +754,47 @@ void UserSession::onDesktopSessionStopped()
     }
 }
 
-void UserSession::onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor)
+void UserSession::onScreenCaptured(std::shared_ptr<const base::Frame> frame,
+                                   const base::MouseCursor* cursor)
 {
+    if (video_encoder_manager_->isEncoding())
+    {
+        // The desktop session was replaced while the previous frame was being encoded. The frame
+        // is processed after that.
+        has_pending_screen_ = true;
+        pending_frame_ = std::move(frame);
+        pending_cursor_ = cursor ? std::make_unique<base::MouseCursor>(*cursor) : nullptr;
+        return;
+    }
+
+    if (frame)
+        video_encoder_manager_->onFrameCaptured();
+
+    // The cursor is sent immediately, the clients request the encoding of the frame.
     for (const auto& client : desktop_clients_)
-        static_cast<ClientSessionDesktop*>(client.get())->encodeScreen(frame, cursor);
+        static_cast<ClientSessionDesktop*>(client.get())->encodeScreen(frame.get(), cursor);
+
+    // Different encoders encode the frame in parallel.
+    video_encoder_manager_->encodeFrame(
+        frame, std::bind(&UserSession::onScreenEncoded, this, frame));
+}
+
+void UserSession::onScreenEncoded(std::shared_ptr<const base::Frame> frame)
+{
+    for (const auto& client : desktop_clients_)
+        static_cast<ClientSessionDesktop*>(client.get())->sendVideoPacket(frame.get());
+
+    if (has_pending_screen_)
+    {
+        has_pending_screen_ = false;
+
+        std::unique_ptr<base::MouseCursor> cursor = std::move(pending_cursor_);
+        onScreenCaptured(std::move(pending_frame_), cursor.get());
+        return;
+    }
+
+    // Allow the desktop session to capture the next frame.
+    desktop_session_proxy_->frameProcessed();
 }
 
 void UserSession::onScreenCaptureError(proto::VideoErrorCode error_code)
@@ -1187,6 +1230,7 @@ void UserSession::addNewClientSession(std::unique_ptr<ClientSession> client_sess
                 static_cast<ClientSessionDesktop*>(client_session_ptr);
 
             desktop_client_session->setDesktopSessionProxy(desktop_session_proxy_);
+            desktop_client_session->setVideoEncoderManager(video_encoder_manager_);
 
             if (enable_required)
                 desktop_session_proxy_->control(proto::internal::DesktopControl::ENABLE);
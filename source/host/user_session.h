@@ -38,6 +38,8 @@ class ScopedTaskRunner;
 
 namespace host {
 
+class SharedVideoEncoderManager;
+
 class UserSession
     : public base::IpcChannel::Listener,
       public DesktopSession::Delegate,
@@ -104,7 +106,8 @@ protected:
     // DesktopSession::Delegate implementation.
     void onDesktopSessionStarted() override;
     void onDesktopSessionStopped() override;
-    void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor) override;
+    void onScreenCaptured(std::shared_ptr<const base::Frame> frame,
+                          const base::MouseCursor* cursor) override;
     void onScreenCaptureError(proto::VideoErrorCode error_code) override;
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
     void onCursorPositionChanged(const proto::CursorPosition& cursor_position) override;
@@ -137,6 +140,7 @@ private:
     void onTextChatSessionStarted(uint32_t id);
     void onTextChatSessionFinished(uint32_t id);
     void mergeAndSendConfiguration();
+    void onScreenEncoded(std::shared_ptr<const base::Frame> frame);
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::ScopedTaskRunner> scoped_task_runner_;
@@ -175,6 +179,12 @@ private:
 
     std::unique_ptr<DesktopSessionManager> desktop_session_;
     base::local_shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
+    base::local_shared_ptr<SharedVideoEncoderManager> video_encoder_manager_;
+
+    // The screen received from a new desktop session while the previous frame was being encoded.
+    bool has_pending_screen_ = false;
+    std::shared_ptr<const base::Frame> pending_frame_;
+    std::unique_ptr<base::MouseCursor> pending_cursor_;
 
     Delegate* delegate_ = nullptr;
 
@@ -25,6 +25,8 @@
 #include "proto/router_common.pb.h"
 #include "relay/settings.h"
 
+#include <thread>
+
 namespace relay {
 
 namespace {
@@ -85,6 +87,12 @@ Controller::Controller(std::shared_ptr<base::TaskRunner> task_runner)
     max_peer_count_ = settings.maxPeerCount();
     statistics_enabled_ = settings.isStatisticsEnabled();
     statistics_interval_ = settings.statisticsInterval();
+    session_workers_ = settings.sessionWorkers();
+    zero_copy_enabled_ = settings.isZeroCopyEnabled();
+    max_buffer_size_ = settings.maxBufferSize();
+
+    if (!session_workers_)
+        session_workers_ = std::max(std::thread::hardware_concurrency(), 1U);
 
     LOG(LS_INFO) << "Listen interface: " << listen_interface_;
     LOG(LS_INFO) << "Peer address: " << peer_address_;
@@ -93,6 +101,9 @@ Controller::Controller(std::shared_ptr<base::TaskRunner> task_runner)
     LOG(LS_INFO) << "Max peer count: " << max_peer_count_;
     LOG(LS_INFO) << "Statistics enabled: " << statistics_enabled_;
     LOG(LS_INFO) << "Statistics interval: " << statistics_interval_.count();
+    LOG(LS_INFO) << "Session workers: " << session_workers_;
+    LOG(LS_INFO) << "Zero-copy enabled: " << zero_copy_enabled_;
+    LOG(LS_INFO) << "Max buffer size: " << max_buffer_size_;
 }
 
 Controller::~Controller()
@@ -152,9 +163,15 @@ bool Controller::start()
         return false;
     }
 
+    if (max_buffer_size_ < 4096 || max_buffer_size_ > 16 * 1024 * 1024)
+    {
+        LOG(LS_WARNING) << "Invalid max buffer size";
+        return false;
+    }
+
     sessions_worker_ = std::make_unique<SessionsWorker>(
         listen_interface_, peer_port_, peer_idle_timeout_, statistics_enabled_, statistics_interval_,
-        shared_pool_->share());
+        session_workers_, zero_copy_enabled_, max_buffer_size_, shared_pool_->share());
     sessions_worker_->start(task_runner_, this);
 
     connectToRouter();
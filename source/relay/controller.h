@@ -76,6 +76,9 @@ private:
     uint32_t max_peer_count_ = 0;
     bool statistics_enabled_ = false;
     std::chrono::seconds statistics_interval_;
+    uint32_t session_workers_ = 0;
+    bool zero_copy_enabled_ = true;
+    uint32_t max_buffer_size_ = 0;
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     base::WaitableTimer reconnect_timer_;
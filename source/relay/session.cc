@@ -25,16 +25,23 @@
 
 #include <asio/write.hpp>
 
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif // defined(OS_LINUX)
+
 namespace relay {
 
-Session::Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets,
-                 const base::ByteArray& secret)
-    : socket_{ std::move(sockets.first), std::move(sockets.second) }
+Session::Session(uint64_t session_id,
+                 std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets,
+                 const base::ByteArray& secret,
+                 bool zero_copy,
+                 size_t max_buffer_size)
+    : session_id_(session_id),
+      socket_{ std::move(sockets.first), std::move(sockets.second) },
+      max_buffer_size_(std::max(max_buffer_size, kMinBufferSize)),
+      zero_copy_(zero_copy)
 {
-    static uint64_t session_id = 0;
-    ++session_id;
-    session_id_ = session_id;
-
     proto::PeerToRelay::Secret secret_message;
     if (secret_message.ParseFromArray(secret.data(), static_cast<int>(secret.size())))
     {
@@ -43,14 +50,15 @@ Session::Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& socke
         host_address_ = secret_message.host_address();
         host_id_ = secret_message.host_id();
     }
-
-    for (size_t i = 0; i < kNumberOfSides; ++i)
-        std::fill(buffer_[i].begin(), buffer_[i].end(), 0);
 }
 
 Session::~Session()
 {
     stop();
+
+#if defined(OS_LINUX)
+    closeSplice();
+#endif // defined(OS_LINUX)
 }
 
 void Session::start(Delegate* delegate)
@@ -60,6 +68,22 @@ void Session::start(Delegate* delegate)
     start_time_ = Clock::now();
     delegate_ = delegate;
 
+#if defined(OS_LINUX)
+    if (zero_copy_)
+    {
+        if (initSplice())
+        {
+            for (int i = 0; i < kNumberOfSides; ++i)
+                Session::doSplice(this, i);
+            return;
+        }
+
+        LOG(LS_WARNING) << "Zero-copy forwarding is not available. Buffered forwarding is used";
+        closeSplice();
+        zero_copy_ = false;
+    }
+#endif // defined(OS_LINUX)
+
     for (int i = 0; i < kNumberOfSides; ++i)
         Session::doReadSome(this, i);
 }
@@ -108,38 +132,235 @@ std::chrono::seconds Session::duration(const TimePoint& current_time) const
 // static
 void Session::doReadSome(Session* session, int source)
 {
+    Side& side = session->side_[source];
+    Buffer& buffer = side.buffer[side.read_index];
+
+    // A read is already pending or all buffers are waiting to be written. In the last case the
+    // read will be started when the write completes.
+    if (buffer.state != BufferState::FREE)
+        return;
+
+    if (buffer.data.size() != side.buffer_size)
+    {
+        buffer.data.resize(side.buffer_size);
+        buffer.data.shrink_to_fit();
+    }
+
+    buffer.state = BufferState::READING;
+
     session->socket_[source].async_read_some(
-        asio::buffer(session->buffer_[source].data(), session->buffer_[source].size()),
+        asio::buffer(buffer.data.data(), buffer.data.size()),
         [session, source](const std::error_code& error_code, size_t bytes_transferred)
     {
         if (error_code)
         {
             if (error_code != asio::error::operation_aborted)
                 session->onErrorOccurred(FROM_HERE, error_code);
+            return;
         }
-        else
+
+        Side& side = session->side_[source];
+        Buffer& buffer = side.buffer[side.read_index];
+
+        DCHECK(buffer.state == BufferState::READING);
+
+        buffer.length = bytes_transferred;
+        buffer.state = BufferState::FILLED;
+        side.read_index = (side.read_index + 1) % kBuffersPerSide;
+
+        session->bytes_transferred_ += bytes_transferred;
+        session->start_idle_time_ = TimePoint();
+        session->updateBufferSize(source, bytes_transferred, buffer.data.size());
+
+        doWrite(session, source);
+        doReadSome(session, source);
+    });
+}
+
+// static
+void Session::doWrite(Session* session, int source)
+{
+    Side& side = session->side_[source];
+    Buffer& buffer = side.buffer[side.write_index];
+
+    // A write is already pending or there is no data to write.
+    if (buffer.state != BufferState::FILLED)
+        return;
+
+    buffer.state = BufferState::WRITING;
+
+    asio::async_write(
+        session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
+        asio::const_buffer(buffer.data.data(), buffer.length),
+        [session, source](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                session->onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        Side& side = session->side_[source];
+        Buffer& buffer = side.buffer[side.write_index];
+
+        DCHECK(buffer.state == BufferState::WRITING);
+
+        buffer.length = 0;
+        buffer.state = BufferState::FREE;
+        side.write_index = (side.write_index + 1) % kBuffersPerSide;
+
+        // Do not keep a large buffer if the traffic has decreased.
+        if (buffer.data.size() > side.buffer_size)
+        {
+            buffer.data.clear();
+            buffer.data.shrink_to_fit();
+        }
+
+        doWrite(session, source);
+        doReadSome(session, source);
+    });
+}
+
+void Session::updateBufferSize(int source, size_t bytes_read, size_t capacity)
+{
+    size_t& buffer_size = side_[source].buffer_size;
+
+    if (bytes_read == capacity)
+        buffer_size = std::min(buffer_size * 2, max_buffer_size_);
+    else if (bytes_read < buffer_size / 4)
+        buffer_size = std::max(buffer_size / 2, kMinBufferSize);
+}
+
+#if defined(OS_LINUX)
+bool Session::initSplice()
+{
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        if (pipe2(pipe_[i], O_NONBLOCK | O_CLOEXEC) != 0)
         {
-            session->bytes_transferred_ += bytes_transferred;
-            session->start_idle_time_ = TimePoint();
+            PLOG(LS_ERROR) << "pipe2 failed";
+            return false;
+        }
+
+        // splice() is called directly on native sockets and must not block the thread.
+        std::error_code error_code;
+        socket_[i].native_non_blocking(true, error_code);
+        if (error_code)
+        {
+            LOG(LS_ERROR) << "Unable to set non-blocking mode: "
+                          << base::utf16FromLocal8Bit(error_code.message());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Session::closeSplice()
+{
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        for (int j = 0; j < 2; ++j)
+        {
+            if (pipe_[i][j] != -1)
+            {
+                close(pipe_[i][j]);
+                pipe_[i][j] = -1;
+            }
+        }
+
+        pipe_bytes_[i] = 0;
+    }
+}
+
+// static
+void Session::doSplice(Session* session, int source)
+{
+    const int target = (source + kNumberOfSides - 1) % kNumberOfSides;
 
-            asio::async_write(
-                session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
-                asio::const_buffer(session->buffer_[source].data(), bytes_transferred),
-                [session, source](const std::error_code& error_code, size_t /* bytes_transferred */)
+    const int source_fd = session->socket_[source].native_handle();
+    const int target_fd = session->socket_[target].native_handle();
+
+    int* pipe_fds = session->pipe_[source];
+    size_t& pipe_bytes = session->pipe_bytes_[source];
+
+    if (!pipe_bytes)
+    {
+        ssize_t ret = splice(source_fd, nullptr, pipe_fds[kPipeWrite], nullptr, kSpliceSize,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (ret < 0)
+        {
+            if (errno == EAGAIN || errno == EINTR)
             {
-                if (error_code)
-                {
-                    if (error_code != asio::error::operation_aborted)
-                        session->onErrorOccurred(FROM_HERE, error_code);
-                }
-                else
-                {
-                    doReadSome(session, source);
-                }
-            });
+                // No data in the socket. Waiting for it.
+                doSpliceWait(session, source, source, asio::ip::tcp::socket::wait_read);
+                return;
+            }
+
+            session->onErrorOccurred(FROM_HERE, std::error_code(errno, std::system_category()));
+            return;
+        }
+
+        if (ret == 0)
+        {
+            // The peer closed the connection.
+            session->onErrorOccurred(FROM_HERE, asio::error::eof);
+            return;
+        }
+
+        pipe_bytes = static_cast<size_t>(ret);
+
+        session->bytes_transferred_ += ret;
+        session->start_idle_time_ = TimePoint();
+    }
+
+    while (pipe_bytes)
+    {
+        ssize_t ret = splice(pipe_fds[kPipeRead], nullptr, target_fd, nullptr, pipe_bytes,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EAGAIN)
+            {
+                // The send buffer of the target socket is full. Waiting until it is writable.
+                doSpliceWait(session, source, target, asio::ip::tcp::socket::wait_write);
+                return;
+            }
+
+            session->onErrorOccurred(FROM_HERE, std::error_code(errno, std::system_category()));
+            return;
+        }
+
+        pipe_bytes -= static_cast<size_t>(ret);
+    }
+
+    // All data has been sent. Waiting for the next portion.
+    doSpliceWait(session, source, source, asio::ip::tcp::socket::wait_read);
+}
+
+// static
+void Session::doSpliceWait(
+    Session* session, int source, int socket, asio::ip::tcp::socket::wait_type wait_type)
+{
+    session->socket_[socket].async_wait(wait_type,
+        [session, source](const std::error_code& error_code)
+    {
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                session->onErrorOccurred(FROM_HERE, error_code);
+        }
+        else
+        {
+            doSplice(session, source);
         }
     });
 }
+#endif // defined(OS_LINUX)
 
 void Session::onErrorOccurred(const base::Location& location, const std::error_code& error_code)
 {
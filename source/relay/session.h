@@ -22,6 +22,7 @@
 #include "base/macros_magic.h"
 #include "base/memory/byte_array.h"
 #include "base/peer/host_id.h"
+#include "build/build_config.h"
 
 #include <asio/ip/tcp.hpp>
 
@@ -34,8 +35,11 @@ namespace relay {
 class Session
 {
 public:
-    Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets,
-            const base::ByteArray& secret);
+    Session(uint64_t session_id,
+            std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets,
+            const base::ByteArray& secret,
+            bool zero_copy,
+            size_t max_buffer_size);
     ~Session();
 
     using Clock = std::chrono::high_resolution_clock;
@@ -63,7 +67,21 @@ public:
     int64_t bytesTransferred() const { return bytes_transferred_; }
 
 private:
+    // Buffered forwarding. Each side has two buffers: while one of them is being written to the
+    // opposite socket, the next portion of data is read into the other one.
     static void doReadSome(Session* session, int source);
+    static void doWrite(Session* session, int source);
+    void updateBufferSize(int source, size_t bytes_read, size_t capacity);
+
+#if defined(OS_LINUX)
+    // Zero-copy forwarding. Data is moved from one socket to another through a pipe using
+    // splice() without copying to user space.
+    bool initSplice();
+    void closeSplice();
+    static void doSplice(Session* session, int source);
+    static void doSpliceWait(
+        Session* session, int source, int socket, asio::ip::tcp::socket::wait_type wait_type);
+#endif // defined(OS_LINUX)
     void onErrorOccurred(const base::Location& location, const std::error_code& error_code);
 
     uint64_t session_id_ = 0;
@@ -77,10 +95,44 @@ private:
     int64_t bytes_transferred_ = 0;
 
     static const int kNumberOfSides = 2;
-    static const int kBufferSize = 8192;
+    static const int kBuffersPerSide = 2;
+    static constexpr size_t kMinBufferSize = 4096;
 
     asio::ip::tcp::socket socket_[kNumberOfSides];
-    std::array<uint8_t, kBufferSize> buffer_[kNumberOfSides];
+
+    enum class BufferState { FREE, READING, FILLED, WRITING };
+
+    struct Buffer
+    {
+        base::ByteArray data;
+        size_t length = 0;
+        BufferState state = BufferState::FREE;
+    };
+
+    struct Side
+    {
+        Buffer buffer[kBuffersPerSide];
+        int read_index = 0;
+        int write_index = 0;
+
+        // The size grows while reads fill the buffer completely and decreases when they do not.
+        size_t buffer_size = kMinBufferSize;
+    };
+
+    Side side_[kNumberOfSides];
+    const size_t max_buffer_size_;
+
+    bool zero_copy_ = false;
+
+#if defined(OS_LINUX)
+    static const int kPipeRead = 0;
+    static const int kPipeWrite = 1;
+    static const size_t kSpliceSize = 65536;
+
+    // Pipe and number of bytes in it for each direction.
+    int pipe_[kNumberOfSides][2] = { { -1, -1 }, { -1, -1 } };
+    size_t pipe_bytes_[kNumberOfSides] = { 0, 0 };
+#endif // defined(OS_LINUX)
 
     Delegate* delegate_ = nullptr;
 
@@ -99,7 +99,10 @@ SessionManager::SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
                                uint16_t port,
                                const std::chrono::minutes& idle_timeout,
                                bool statistics_enabled,
-                               const std::chrono::seconds& statistics_interval)
+                               const std::chrono::seconds& statistics_interval,
+                               size_t worker_count,
+                               bool zero_copy,
+                               size_t max_buffer_size)
     : task_runner_(std::move(task_runner)),
       acceptor_(base::MessageLoop::current()->pumpAsio()->ioContext(),
                 asio::ip::tcp::endpoint(listen_address, port)),
@@ -107,15 +110,24 @@ SessionManager::SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
       idle_timer_(base::MessageLoop::current()->pumpAsio()->ioContext()),
       stat_timer_(base::MessageLoop::current()->pumpAsio()->ioContext()),
       statistics_enabled_(statistics_enabled),
-      statistics_interval_(statistics_interval)
+      statistics_interval_(statistics_interval),
+      worker_count_(worker_count),
+      zero_copy_(zero_copy),
+      max_buffer_size_(max_buffer_size)
 {
     DCHECK(task_runner_);
 
     LOG(LS_INFO) << "Session manager port: " << port;
+    LOG(LS_INFO) << "Session manager workers: " << worker_count_;
+    LOG(LS_INFO) << "Session manager zero-copy: " << zero_copy_;
+    LOG(LS_INFO) << "Session manager max buffer size: " << max_buffer_size_;
 }
 
 SessionManager::~SessionManager()
 {
+    // Stop shard threads before other members are destroyed.
+    shards_.clear();
+
     std::error_code ignored_code;
     acceptor_.cancel(ignored_code);
     acceptor_.close(ignored_code);
@@ -133,6 +145,18 @@ void SessionManager::start(std::unique_ptr<SharedPool> shared_pool, Delegate* de
 
     DCHECK(delegate_ && shared_pool_);
 
+    if (worker_count_ > 1)
+    {
+        for (size_t i = 0; i < worker_count_; ++i)
+        {
+            shards_.emplace_back(std::make_unique<SessionShard>(
+                i, idle_timeout_, zero_copy_, max_buffer_size_, this));
+            shards_.back()->start();
+        }
+
+        shard_load_.resize(worker_count_, 0);
+    }
+
     idle_timer_.expires_after(kIdleTimerInterval);
     idle_timer_.async_wait(std::bind(&SessionManager::doIdleTimeout, this, std::placeholders::_1));
 
@@ -149,6 +173,13 @@ void SessionManager::disconnectSession(uint64_t session_id)
 {
     LOG(LS_INFO) << "Disconnect session by session id: " << session_id;
 
+    auto shard = shard_sessions_.find(session_id);
+    if (shard != shard_sessions_.end())
+    {
+        shards_[shard->second]->disconnectSession(session_id);
+        return;
+    }
+
     for (const auto& session : active_sessions_)
     {
         if (session->sessionId() == session_id)
@@ -188,12 +219,8 @@ void SessionManager::onPendingSessionReady(
                     shared_pool_->removeKey(message.key_id());
 
                     // Now the opposite peer is found, start the data transfer between them.
-                    active_sessions_.emplace_back(std::make_unique<Session>(
-                        std::make_pair(session->takeSocket(), other_session->takeSocket()), secret));
-                    active_sessions_.back()->start(this);
-
-                    if (delegate_)
-                        delegate_->onSessionStarted();
+                    startSession(
+                        std::make_pair(session->takeSocket(), other_session->takeSocket()), secret);
 
                     // Pending sessions are no longer needed, remove them.
                     removePendingSession(other_session.get());
@@ -229,6 +256,29 @@ void SessionManager::onSessionFinished(Session* session)
     removeSession(session);
 }
 
+void SessionManager::onShardSessionFinished(size_t shard_index, uint64_t session_id)
+{
+    if (!task_runner_->belongsToCurrentThread())
+    {
+        task_runner_->postTask(std::bind(
+            &SessionManager::onShardSessionFinished, this, shard_index, session_id));
+        return;
+    }
+
+    if (!shard_sessions_.erase(session_id))
+    {
+        LOG(LS_WARNING) << "Session with id " << session_id << " not found in shard list";
+        return;
+    }
+
+    DCHECK_LT(shard_index, shard_load_.size());
+    DCHECK_GT(shard_load_[shard_index], 0U);
+    --shard_load_[shard_index];
+
+    if (delegate_)
+        delegate_->onSessionFinished();
+}
+
 // static
 void SessionManager::doAccept(SessionManager* self)
 {
@@ -282,6 +332,9 @@ void SessionManager::doIdleTimeoutImpl(const std::error_code& error_code)
             {
                 it = active_sessions_.erase(it);
                 ++count;
+
+                if (delegate_)
+                    delegate_->onSessionFinished();
             }
             else
             {
@@ -326,6 +379,12 @@ void SessionManager::doStatTimeoutImpl(const std::error_code& error_code)
 
 void SessionManager::collectAndSendStatistics()
 {
+    if (pending_stat_shards_ != 0)
+    {
+        LOG(LS_WARNING) << "Previous statistics collection is not completed yet";
+        return;
+    }
+
     Session::TimePoint now = Session::Clock::now();
 
     proto::RelayStat relay_stat;
@@ -347,8 +406,109 @@ void SessionManager::collectAndSendStatistics()
         peer_connection->set_duration(session->duration(now).count());
     }
 
+    if (shards_.empty())
+    {
+        if (delegate_)
+            delegate_->onSessionStatistics(relay_stat);
+        return;
+    }
+
+    // The statistics will be sent when all shards have replied.
+    pending_stat_ = std::make_unique<proto::RelayStat>(std::move(relay_stat));
+    pending_stat_shards_ = shards_.size();
+
+    for (const auto& shard : shards_)
+    {
+        shard->collectStatistics(now, [this](proto::RelayStat shard_stat)
+        {
+            task_runner_->postTask(
+                std::bind(&SessionManager::onShardStatistics, this, std::move(shard_stat)));
+        });
+    }
+}
+
+void SessionManager::onShardStatistics(const proto::RelayStat& relay_stat)
+{
+    DCHECK(pending_stat_);
+    DCHECK_GT(pending_stat_shards_, 0U);
+
+    pending_stat_->mutable_peer_connection()->MergeFrom(relay_stat.peer_connection());
+
+    if (--pending_stat_shards_ != 0)
+        return;
+
     if (delegate_)
-        delegate_->onSessionStatistics(relay_stat);
+        delegate_->onSessionStatistics(*pending_stat_);
+
+    pending_stat_.reset();
+}
+
+void SessionManager::startSession(SocketPair&& sockets, const base::ByteArray& secret)
+{
+    uint64_t session_id = ++last_session_id_;
+
+    if (delegate_)
+        delegate_->onSessionStarted();
+
+    if (!shards_.empty() && startShardSession(session_id, &sockets, secret))
+        return;
+
+    active_sessions_.emplace_back(
+        std::make_unique<Session>(session_id, std::move(sockets), secret, zero_copy_, max_buffer_size_));
+    active_sessions_.back()->start(this);
+}
+
+bool SessionManager::startShardSession(
+    uint64_t session_id, SocketPair* sockets, const base::ByteArray& secret)
+{
+    std::error_code error_code;
+
+    asio::ip::tcp::endpoint endpoint = sockets->first.local_endpoint(error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Unable to get local endpoint: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    // Sockets are bound to the io_context of the current thread. To move them to another thread,
+    // we release native handles and assign them to the io_context of the shard.
+    SessionShard::NativeSocket first = sockets->first.release(error_code);
+    if (error_code)
+    {
+        // On some platforms (for example, Windows older than 8.1) the operation is not supported.
+        LOG(LS_WARNING) << "Unable to release first socket: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    SessionShard::NativeSocket second = sockets->second.release(error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Unable to release second socket: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+
+        // Return the first socket to the current thread. The session will be started here.
+        sockets->first.assign(endpoint.protocol(), first, error_code);
+        if (error_code)
+            SessionShard::closeNativeSocket(first);
+        return false;
+    }
+
+    // Select the least loaded shard.
+    size_t shard_index = 0;
+    for (size_t i = 1; i < shard_load_.size(); ++i)
+    {
+        if (shard_load_[i] < shard_load_[shard_index])
+            shard_index = i;
+    }
+
+    ++shard_load_[shard_index];
+    shard_sessions_.emplace(session_id, shard_index);
+
+    shards_[shard_index]->addSession(
+        session_id, endpoint.protocol(), std::make_pair(first, second), secret);
+    return true;
 }
 
 void SessionManager::removePendingSession(PendingSession* session)
@@ -23,10 +23,13 @@
 #include "proto/router_relay.pb.h"
 #include "relay/pending_session.h"
 #include "relay/session.h"
+#include "relay/session_shard.h"
 #include "relay/shared_pool.h"
 
 #include <asio/high_resolution_timer.hpp>
 
+#include <map>
+
 namespace base {
 class TaskRunner;
 } // namespace base
@@ -35,7 +38,8 @@ namespace relay {
 
 class SessionManager
     : public PendingSession::Delegate,
-      public Session::Delegate
+      public Session::Delegate,
+      public SessionShard::Delegate
 {
 public:
     class Delegate
@@ -53,7 +57,10 @@ public:
                    uint16_t port,
                    const std::chrono::minutes& idle_timeout,
                    bool statistics_enabled,
-                   const std::chrono::seconds& statistics_interval);
+                   const std::chrono::seconds& statistics_interval,
+                   size_t worker_count,
+                   bool zero_copy,
+                   size_t max_buffer_size);
     ~SessionManager() override;
 
     void start(std::unique_ptr<SharedPool> shared_pool, Delegate* delegate);
@@ -68,13 +75,22 @@ protected:
     // Session::Delegate implementation.
     void onSessionFinished(Session* session) override;
 
+    // SessionShard::Delegate implementation.
+    void onShardSessionFinished(size_t shard_index, uint64_t session_id) override;
+
 private:
+    using SocketPair = std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>;
+
     static void doAccept(SessionManager* self);
     static void doIdleTimeout(SessionManager* self, const std::error_code& error_code);
     void doIdleTimeoutImpl(const std::error_code& error_code);
     static void doStatTimeout(SessionManager* self, const std::error_code& error_code);
     void doStatTimeoutImpl(const std::error_code& error_code);
     void collectAndSendStatistics();
+    void onShardStatistics(const proto::RelayStat& relay_stat);
+
+    void startSession(SocketPair&& sockets, const base::ByteArray& secret);
+    bool startShardSession(uint64_t session_id, SocketPair* sockets, const base::ByteArray& secret);
 
     void removePendingSession(PendingSession* sessions);
     void removeSession(Session* session);
@@ -101,6 +117,20 @@ private:
     bool statistics_enabled_ = false;
     std::chrono::seconds statistics_interval_;
 
+    uint64_t last_session_id_ = 0;
+
+    // If there is more than one worker, the paired sockets are transferred to the shards and the
+    // data transfer is performed on their threads. Otherwise, sessions run on the current thread.
+    const size_t worker_count_;
+    const bool zero_copy_;
+    const size_t max_buffer_size_;
+    std::vector<std::unique_ptr<SessionShard>> shards_;
+    std::vector<size_t> shard_load_;
+    std::map<uint64_t, size_t> shard_sessions_;
+
+    std::unique_ptr<proto::RelayStat> pending_stat_;
+    size_t pending_stat_shards_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(SessionManager);
 };
 
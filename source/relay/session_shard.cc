@@ -0,0 +1,256 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/session_shard.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/strings/unicode.h"
+
+#if defined(OS_POSIX)
+#include <unistd.h>
+#endif // defined(OS_POSIX)
+
+namespace relay {
+
+namespace {
+
+const std::chrono::minutes kIdleTimerInterval { 1 };
+
+} // namespace
+
+SessionShard::SessionShard(size_t shard_index,
+                           const std::chrono::minutes& idle_timeout,
+                           bool zero_copy,
+                           size_t max_buffer_size,
+                           Delegate* delegate)
+    : shard_index_(shard_index),
+      idle_timeout_(idle_timeout),
+      zero_copy_(zero_copy),
+      max_buffer_size_(max_buffer_size),
+      delegate_(delegate),
+      thread_(std::make_unique<base::Thread>())
+{
+    DCHECK(delegate_);
+}
+
+SessionShard::~SessionShard()
+{
+    thread_->stop();
+}
+
+void SessionShard::start()
+{
+    LOG(LS_INFO) << "Starting session shard #" << shard_index_;
+    thread_->start(base::MessageLoop::Type::ASIO, this);
+}
+
+void SessionShard::addSession(uint64_t session_id,
+                              const asio::ip::tcp::socket::protocol_type& protocol,
+                              std::pair<NativeSocket, NativeSocket> sockets,
+                              const base::ByteArray& secret)
+{
+    if (!self_task_runner_->belongsToCurrentThread())
+    {
+        self_task_runner_->postTask(std::bind(
+            &SessionShard::addSession, this, session_id, protocol, sockets, secret));
+        return;
+    }
+
+    asio::io_context& io_context = base::MessageLoop::current()->pumpAsio()->ioContext();
+
+    asio::ip::tcp::socket first(io_context);
+    asio::ip::tcp::socket second(io_context);
+    std::error_code error_code;
+
+    first.assign(protocol, sockets.first, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Unable to assign first socket: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        closeNativeSocket(sockets.first);
+        closeNativeSocket(sockets.second);
+        delegate_->onShardSessionFinished(shard_index_, session_id);
+        return;
+    }
+
+    second.assign(protocol, sockets.second, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Unable to assign second socket: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        closeNativeSocket(sockets.second);
+        delegate_->onShardSessionFinished(shard_index_, session_id);
+        return;
+    }
+
+    LOG(LS_INFO) << "Session " << session_id << " added to shard #" << shard_index_
+                 << " (total: " << sessions_.size() + 1 << ")";
+
+    sessions_.emplace_back(std::make_unique<Session>(
+        session_id, std::make_pair(std::move(first), std::move(second)), secret, zero_copy_,
+        max_buffer_size_));
+    sessions_.back()->start(this);
+}
+
+void SessionShard::disconnectSession(uint64_t session_id)
+{
+    if (!self_task_runner_->belongsToCurrentThread())
+    {
+        self_task_runner_->postTask(
+            std::bind(&SessionShard::disconnectSession, this, session_id));
+        return;
+    }
+
+    for (const auto& session : sessions_)
+    {
+        if (session->sessionId() == session_id)
+        {
+            session->disconnect();
+            return;
+        }
+    }
+
+    LOG(LS_WARNING) << "Session with id " << session_id << " not found in shard #" << shard_index_;
+}
+
+void SessionShard::collectStatistics(const Session::TimePoint& now, StatisticsCallback callback)
+{
+    if (!self_task_runner_->belongsToCurrentThread())
+    {
+        self_task_runner_->postTask(
+            std::bind(&SessionShard::collectStatistics, this, now, std::move(callback)));
+        return;
+    }
+
+    proto::RelayStat relay_stat;
+
+    for (const auto& session : sessions_)
+    {
+        proto::PeerConnection* peer_connection = relay_stat.add_peer_connection();
+
+        peer_connection->set_session_id(session->sessionId());
+        peer_connection->set_status(proto::PeerConnection::PEER_STATUS_ACTIVE);
+        peer_connection->set_client_address(session->clientAddress());
+        peer_connection->set_client_user_name(session->clientUserName());
+        peer_connection->set_host_address(session->hostAddress());
+        peer_connection->set_host_id(session->hostId());
+        peer_connection->set_bytes_transferred(session->bytesTransferred());
+        peer_connection->set_idle_time(session->idleTime(now).count());
+        peer_connection->set_duration(session->duration(now).count());
+    }
+
+    callback(std::move(relay_stat));
+}
+
+// static
+void SessionShard::closeNativeSocket(NativeSocket socket)
+{
+#if defined(OS_WIN)
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+void SessionShard::onBeforeThreadRunning()
+{
+    self_task_runner_ = thread_->taskRunner();
+    DCHECK(self_task_runner_);
+
+    idle_timer_ = std::make_unique<asio::high_resolution_timer>(
+        base::MessageLoop::current()->pumpAsio()->ioContext());
+    idle_timer_->expires_after(kIdleTimerInterval);
+    idle_timer_->async_wait(
+        std::bind(&SessionShard::doIdleTimeout, this, std::placeholders::_1));
+}
+
+void SessionShard::onAfterThreadRunning()
+{
+    // Sockets and timers must be destroyed before the io_context of the thread.
+    idle_timer_.reset();
+    sessions_.clear();
+}
+
+void SessionShard::onSessionFinished(Session* session)
+{
+    session->stop();
+
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    {
+        if (it->get() == session)
+        {
+            uint64_t session_id = session->sessionId();
+
+            self_task_runner_->deleteSoon(std::move(*it));
+            sessions_.erase(it);
+
+            delegate_->onShardSessionFinished(shard_index_, session_id);
+            return;
+        }
+    }
+}
+
+// static
+void SessionShard::doIdleTimeout(SessionShard* self, const std::error_code& error_code)
+{
+    if (error_code == asio::error::operation_aborted)
+        return;
+
+    self->doIdleTimeoutImpl(error_code);
+}
+
+void SessionShard::doIdleTimeoutImpl(const std::error_code& error_code)
+{
+    if (!error_code)
+    {
+        auto current_time = Session::Clock::now();
+        auto it = sessions_.begin();
+        int count = 0;
+
+        while (it != sessions_.end())
+        {
+            if ((*it)->idleTime(current_time) >= idle_timeout_)
+            {
+                uint64_t session_id = (*it)->sessionId();
+
+                it = sessions_.erase(it);
+                delegate_->onShardSessionFinished(shard_index_, session_id);
+                ++count;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        LOG(LS_INFO) << "Sessions ended by timeout in shard #" << shard_index_ << ": " << count;
+    }
+    else
+    {
+        LOG(LS_ERROR) << "Error in idle timer: " << base::utf16FromLocal8Bit(error_code.message());
+    }
+
+    idle_timer_->expires_after(kIdleTimerInterval);
+    idle_timer_->async_wait(
+        std::bind(&SessionShard::doIdleTimeout, this, std::placeholders::_1));
+}
+
+} // namespace relay
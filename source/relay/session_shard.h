@@ -0,0 +1,102 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY_SESSION_SHARD_H
+#define RELAY_SESSION_SHARD_H
+
+#include "base/threading/thread.h"
+#include "proto/router_relay.pb.h"
+#include "relay/session.h"
+
+#include <asio/high_resolution_timer.hpp>
+
+namespace relay {
+
+// Runs the data transfer for a subset of relay sessions on its own thread and io_context.
+// Sockets are accepted and paired by SessionManager and then handed over to the shard as native
+// handles. All public methods may be called from any thread.
+class SessionShard
+    : public base::Thread::Delegate,
+      public Session::Delegate
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // Called from the shard thread.
+        virtual void onShardSessionFinished(size_t shard_index, uint64_t session_id) = 0;
+    };
+
+    using NativeSocket = asio::ip::tcp::socket::native_handle_type;
+    using StatisticsCallback = std::function<void(proto::RelayStat relay_stat)>;
+
+    SessionShard(size_t shard_index,
+                 const std::chrono::minutes& idle_timeout,
+                 bool zero_copy,
+                 size_t max_buffer_size,
+                 Delegate* delegate);
+    ~SessionShard() override;
+
+    size_t shardIndex() const { return shard_index_; }
+
+    void start();
+
+    void addSession(uint64_t session_id,
+                    const asio::ip::tcp::socket::protocol_type& protocol,
+                    std::pair<NativeSocket, NativeSocket> sockets,
+                    const base::ByteArray& secret);
+    void disconnectSession(uint64_t session_id);
+
+    // Collects information about sessions of the shard. |callback| is called on the shard thread
+    // and receives only the list of peer connections.
+    void collectStatistics(const Session::TimePoint& now, StatisticsCallback callback);
+
+    static void closeNativeSocket(NativeSocket socket);
+
+protected:
+    // base::Thread::Delegate implementation.
+    void onBeforeThreadRunning() override;
+    void onAfterThreadRunning() override;
+
+    // Session::Delegate implementation.
+    void onSessionFinished(Session* session) override;
+
+private:
+    static void doIdleTimeout(SessionShard* self, const std::error_code& error_code);
+    void doIdleTimeoutImpl(const std::error_code& error_code);
+
+    const size_t shard_index_;
+    const std::chrono::minutes idle_timeout_;
+    const bool zero_copy_;
+    const size_t max_buffer_size_;
+    Delegate* delegate_;
+
+    std::unique_ptr<base::Thread> thread_;
+    std::shared_ptr<base::TaskRunner> self_task_runner_;
+
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::unique_ptr<asio::high_resolution_timer> idle_timer_;
+
+    DISALLOW_COPY_AND_ASSIGN(SessionShard);
+};
+
+} // namespace relay
+
+#endif // RELAY_SESSION_SHARD_H
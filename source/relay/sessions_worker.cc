@@ -28,12 +28,18 @@ SessionsWorker::SessionsWorker(std::u16string_view listen_interface,
                                const std::chrono::minutes& peer_idle_timeout,
                                bool statistics_enabled,
                                const std::chrono::seconds& statistics_interval,
+                               size_t worker_count,
+                               bool zero_copy,
+                               size_t max_buffer_size,
                                std::unique_ptr<SharedPool> shared_pool)
     : listen_interface_(listen_interface),
       peer_port_(peer_port),
       peer_idle_timeout_(peer_idle_timeout),
       statistics_enabled_(statistics_enabled),
       statistics_interval_(statistics_interval),
+      worker_count_(worker_count),
+      zero_copy_(zero_copy),
+      max_buffer_size_(max_buffer_size),
       shared_pool_(std::move(shared_pool)),
       thread_(std::make_unique<base::Thread>())
 {
@@ -78,7 +84,8 @@ void SessionsWorker::onBeforeThreadRunning()
 
     session_manager_ = std::make_unique<SessionManager>(
         self_task_runner_, listen_address, peer_port_, peer_idle_timeout_, statistics_enabled_,
-        statistics_interval_);
+        statistics_interval_, worker_count_,
+        zero_copy_, max_buffer_size_);
     session_manager_->start(std::move(shared_pool_), this);
 }
 
@@ -36,6 +36,9 @@ public:
                    const std::chrono::minutes& peer_idle_timeout,
                    bool statistics_enabled,
                    const std::chrono::seconds& statistics_interval,
+                   size_t worker_count,
+                   bool zero_copy,
+                   size_t max_buffer_size,
                    std::unique_ptr<SharedPool> shared_pool);
     ~SessionsWorker() override;
 
@@ -59,6 +62,9 @@ private:
     const std::chrono::minutes peer_idle_timeout_;
     const bool statistics_enabled_;
     const std::chrono::seconds statistics_interval_;
+    const size_t worker_count_;
+    const bool zero_copy_;
+    const size_t max_buffer_size_;
 
     std::unique_ptr<SharedPool> shared_pool_;
 
@@ -28,6 +28,7 @@ namespace {
 const base::JsonSettings::Scope kScope = base::JsonSettings::Scope::SYSTEM;
 const char kApplicationName[] = "aspia";
 const char kFileName[] = "relay";
+const uint32_t kDefaultMaxBufferSize = 256 * 1024;
 
 } // namespace
 
@@ -56,6 +57,9 @@ void Settings::reset()
     setMaxPeerCount(100);
     setStatisticsEnabled(false);
     setStatisticsInterval(std::chrono::seconds(5));
+    setSessionWorkers(0);
+    setZeroCopyEnabled(true);
+    setMaxBufferSize(kDefaultMaxBufferSize);
 }
 
 void Settings::flush()
@@ -167,4 +171,34 @@ std::chrono::seconds Settings::statisticsInterval() const
     return std::chrono::seconds(impl_.get<int>("StatisticsInterval", 5));
 }
 
+void Settings::setSessionWorkers(uint32_t count)
+{
+    impl_.set<uint32_t>("SessionWorkers", count);
+}
+
+uint32_t Settings::sessionWorkers() const
+{
+    return impl_.get<uint32_t>("SessionWorkers", 0);
+}
+
+void Settings::setZeroCopyEnabled(bool enable)
+{
+    impl_.set<bool>("ZeroCopyEnabled", enable);
+}
+
+bool Settings::isZeroCopyEnabled() const
+{
+    return impl_.get<bool>("ZeroCopyEnabled", true);
+}
+
+void Settings::setMaxBufferSize(uint32_t size)
+{
+    impl_.set<uint32_t>("MaxBufferSize", size);
+}
+
+uint32_t Settings::maxBufferSize() const
+{
+    return impl_.get<uint32_t>("MaxBufferSize", kDefaultMaxBufferSize);
+}
+
 } // namespace relay
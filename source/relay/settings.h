@@ -66,6 +66,19 @@ public:
     void setStatisticsInterval(const std::chrono::seconds& interval);
     std::chrono::seconds statisticsInterval() const;
 
+    // Number of threads that transfer data between peers. If 0, the number of processor cores is
+    // used.
+    void setSessionWorkers(uint32_t count);
+    uint32_t sessionWorkers() const;
+
+    // Enables forwarding of data between peers without copying it to user space (only Linux).
+    void setZeroCopyEnabled(bool enable);
+    bool isZeroCopyEnabled() const;
+
+    // Upper limit for the size of the forwarding buffer (in bytes) for each side of a session.
+    void setMaxBufferSize(uint32_t size);
+    uint32_t maxBufferSize() const;
+
 private:
     base::JsonSettings impl_;
 };
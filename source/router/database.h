@@ -22,6 +22,8 @@
 #include "base/peer/host_id.h"
 #include "base/peer/user_list.h"
 
+#include <functional>
+
 namespace router {
 
 class Database
@@ -42,7 +44,12 @@ public:
     virtual bool removeUser(int64_t entry_id) = 0;
     virtual base::User findUser(std::u16string_view username) = 0;
     virtual ErrorCode hostId(const base::ByteArray& key_hash, base::HostId* host_id) const = 0;
-    virtual bool addHost(const base::ByteArray& key_hash) = 0;
+
+    using AddHostCallback = std::function<void(bool result)>;
+
+    // Adds a host with the specified key hash. |callback| is called on the current thread after
+    // the host is saved to the database (it can be called before the method returns).
+    virtual void addHost(const base::ByteArray& key_hash, AddHostCallback callback) = 0;
 };
 
 } // namespace router
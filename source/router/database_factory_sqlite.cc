@@ -18,11 +18,15 @@
 
 #include "router/database_factory_sqlite.h"
 
-#include "router/database_sqlite.h"
+#include "router/host_key_index.h"
 
 namespace router {
 
-DatabaseFactorySqlite::DatabaseFactorySqlite() = default;
+DatabaseFactorySqlite::DatabaseFactorySqlite(DatabaseSqlite::Synchronous synchronous)
+    : synchronous_(synchronous)
+{
+    // Nothing
+}
 
 DatabaseFactorySqlite::~DatabaseFactorySqlite() = default;
 
@@ -33,7 +37,21 @@ std::unique_ptr<Database> DatabaseFactorySqlite::createDatabase() const
 
 std::unique_ptr<Database> DatabaseFactorySqlite::openDatabase() const
 {
-    return DatabaseSqlite::open();
+    if (!connection_)
+    {
+        std::shared_ptr<DatabaseSqlite::Connection> connection =
+            DatabaseSqlite::Connection::open(synchronous_);
+        if (!connection)
+            return nullptr;
+
+        host_index_ = HostKeyIndex::create(DatabaseSqlite(connection), synchronous_);
+        if (!host_index_)
+            return nullptr;
+
+        connection_ = std::move(connection);
+    }
+
+    return std::make_unique<DatabaseSqlite>(connection_, host_index_);
 }
 
 } // namespace router
@@ -21,19 +21,28 @@
 
 #include "base/macros_magic.h"
 #include "router/database_factory.h"
+#include "router/database_sqlite.h"
 
 namespace router {
 
 class DatabaseFactorySqlite : public DatabaseFactory
 {
 public:
-    DatabaseFactorySqlite();
+    explicit DatabaseFactorySqlite(
+        DatabaseSqlite::Synchronous synchronous = DatabaseSqlite::Synchronous::NORMAL);
     ~DatabaseFactorySqlite() override;
 
     std::unique_ptr<Database> createDatabase() const override;
+
+    // All opened databases share one connection, so the prepared statements are not recreated for
+    // every request. Host IDs are resolved through the in-memory host key index.
     std::unique_ptr<Database> openDatabase() const override;
 
 private:
+    const DatabaseSqlite::Synchronous synchronous_;
+    mutable std::shared_ptr<DatabaseSqlite::Connection> connection_;
+    mutable std::shared_ptr<HostKeyIndex> host_index_;
+
     DISALLOW_COPY_AND_ASSIGN(DatabaseFactorySqlite);
 };
 
@@ -22,6 +22,7 @@
 #include "base/files/base_paths.h"
 #include "base/strings/unicode.h"
 #include "build/build_config.h"
+#include "router/host_key_index.h"
 
 #include <optional>
 
@@ -29,6 +30,9 @@ namespace router {
 
 namespace {
 
+// Time (in milliseconds) during which a connection waits for a lock held by another connection.
+const int kBusyTimeout = 5000;
+
 const char* columnTypeToString(int type)
 {
     switch (type)
@@ -183,6 +187,28 @@ std::optional<std::u16string> readText16(sqlite3_stmt* statement, int column)
     return base::utf16FromUtf8(*str);
 }
 
+// Resets the prepared statement when leaving the scope so that it can be executed again.
+class ScopedStatementReset
+{
+public:
+    explicit ScopedStatementReset(sqlite3_stmt* statement)
+        : statement_(statement)
+    {
+        DCHECK(statement_);
+    }
+
+    ~ScopedStatementReset()
+    {
+        sqlite3_reset(statement_);
+        sqlite3_clear_bindings(statement_);
+    }
+
+private:
+    sqlite3_stmt* statement_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedStatementReset);
+};
+
 std::optional<base::User> readUser(sqlite3_stmt* statement)
 {
     std::optional<int64_t> entry_id = readInteger<int64_t>(statement, 0);
@@ -249,17 +275,135 @@ std::optional<base::User> readUser(sqlite3_stmt* statement)
 
 } // namespace
 
-DatabaseSqlite::DatabaseSqlite(sqlite3* db)
+DatabaseSqlite::Connection::Connection(sqlite3* db)
     : db_(db)
 {
     DCHECK(db_);
 }
 
-DatabaseSqlite::~DatabaseSqlite()
+DatabaseSqlite::Connection::~Connection()
 {
+    for (size_t i = 0; i < std::size(statements_); ++i)
+        sqlite3_finalize(statements_[i]);
+
     sqlite3_close(db_);
 }
 
+// static
+std::shared_ptr<DatabaseSqlite::Connection> DatabaseSqlite::Connection::open(
+    Synchronous synchronous)
+{
+    std::filesystem::path file_path = filePath();
+    if (file_path.empty())
+    {
+        LOG(LS_WARNING) << "Invalid file path";
+        return nullptr;
+    }
+
+    std::string file_path_utf8 = file_path.u8string();
+    LOG(LS_INFO) << "Opening database: " << file_path_utf8;
+
+    sqlite3* db = nullptr;
+
+    int error_code = sqlite3_open(file_path_utf8.c_str(), &db);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_WARNING) << "sqlite3_open failed: " << sqlite3_errstr(error_code)
+                        << " (" << error_code << ")";
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    std::shared_ptr<Connection> connection(new Connection(db));
+
+    // Several connections to the database can write at the same time.
+    sqlite3_busy_timeout(db, kBusyTimeout);
+
+    // In WAL mode, writers do not block readers and a transaction does not require rewriting the
+    // rollback journal. The journal mode is stored in the database file.
+    std::string pragmas = "PRAGMA journal_mode=WAL;PRAGMA synchronous=" +
+        std::to_string(static_cast<int>(synchronous)) + ";";
+
+    char* error_string = nullptr;
+    error_code = sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, &error_string);
+    if (error_code != SQLITE_OK)
+    {
+        // The database remains usable with the default settings.
+        LOG(LS_WARNING) << "Unable to set journal mode: "
+                        << (error_string ? error_string : sqlite3_errstr(error_code));
+        sqlite3_free(error_string);
+    }
+
+    return connection;
+}
+
+sqlite3_stmt* DatabaseSqlite::Connection::statement(StatementType type)
+{
+    static const char* const kQueries[] =
+    {
+        // STATEMENT_USER_LIST
+        "SELECT * FROM users",
+
+        // STATEMENT_ADD_USER
+        "INSERT INTO users ('id', 'name', 'group', 'salt', 'verifier', 'sessions', 'flags') "
+        "VALUES (NULL, ?, ?, ?, ?, ?, ?)",
+
+        // STATEMENT_MODIFY_USER
+        "UPDATE users SET ('name', 'group', 'salt', 'verifier', 'sessions', 'flags') = "
+        "(?, ?, ?, ?, ?, ?) WHERE id=?",
+
+        // STATEMENT_REMOVE_USER
+        "DELETE FROM users WHERE id=?",
+
+        // STATEMENT_FIND_USER
+        "SELECT * FROM users WHERE name=?",
+
+        // STATEMENT_HOST_ID
+        "SELECT * FROM hosts WHERE key=?",
+
+        // STATEMENT_ADD_HOST
+        "INSERT INTO hosts ('id', 'key') VALUES (NULL, ?)",
+
+        // STATEMENT_HOST_LIST
+        "SELECT id, key FROM hosts",
+
+        // STATEMENT_INSERT_HOST
+        "INSERT INTO hosts ('id', 'key') VALUES (?, ?)",
+
+        // STATEMENT_HOST_SEQUENCE
+        "SELECT seq FROM sqlite_sequence WHERE name='hosts'"
+    };
+
+    static_assert(std::size(kQueries) == STATEMENT_COUNT);
+    DCHECK_LT(type, STATEMENT_COUNT);
+
+    sqlite3_stmt* statement = statements_[type];
+    if (statement)
+        return statement;
+
+    int error_code = sqlite3_prepare_v3(
+        db_, kQueries[type], -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_prepare_v3 failed: " << sqlite3_errstr(error_code)
+                      << " (" << error_code << ")";
+        return nullptr;
+    }
+
+    statements_[type] = statement;
+    return statement;
+}
+
+DatabaseSqlite::DatabaseSqlite(std::shared_ptr<Connection> connection,
+                               std::shared_ptr<HostKeyIndex> host_index)
+    : connection_(std::move(connection)),
+      host_index_(std::move(host_index))
+{
+    DCHECK(connection_);
+}
+
+DatabaseSqlite::~DatabaseSqlite() = default;
+
 // static
 std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
 {
@@ -325,7 +469,7 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
         "COMMIT;";
 
     char* error_string = nullptr;
-    int ret = sqlite3_exec(db->db_, kSql, nullptr, nullptr, &error_string);
+    int ret = sqlite3_exec(db->connection_->db(), kSql, nullptr, nullptr, &error_string);
     if (ret != SQLITE_OK)
     {
         LOG(LS_ERROR) << "sqlite3_exec failed: " << error_string;
@@ -338,27 +482,11 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
 // static
 std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open()
 {
-    std::filesystem::path file_path = filePath();
-    if (file_path.empty())
-    {
-        LOG(LS_WARNING) << "Invalid file path";
+    std::shared_ptr<Connection> connection = Connection::open();
+    if (!connection)
         return nullptr;
-    }
-
-    std::string file_path_utf8 = file_path.u8string();
-    LOG(LS_INFO) << "Opening database: " << file_path_utf8;
-
-    sqlite3* db = nullptr;
 
-    int error_code = sqlite3_open(file_path_utf8.c_str(), &db);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_WARNING) << "sqlite3_open failed: " << sqlite3_errstr(error_code)
-                        << " (" << error_code << ")";
-        return nullptr;
-    }
-
-    return std::unique_ptr<DatabaseSqlite>(new DatabaseSqlite(db));
+    return std::make_unique<DatabaseSqlite>(std::move(connection));
 }
 
 // static
@@ -374,21 +502,16 @@ std::filesystem::path DatabaseSqlite::filePath()
 
 std::vector<base::User> DatabaseSqlite::userList() const
 {
-    const char kQuery[] = "SELECT * FROM users";
-
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_USER_LIST);
+    if (!statement)
         return {};
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     std::vector<base::User> users;
     for (;;)
     {
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_ROW)
             break;
 
@@ -397,7 +520,6 @@ std::vector<base::User> DatabaseSqlite::userList() const
             users.emplace_back(std::move(*user));
     }
 
-    sqlite3_finalize(statement);
     return users;
 }
 
@@ -409,18 +531,11 @@ bool DatabaseSqlite::addUser(const base::User& user)
         return false;
     }
 
-    static const char kQuery[] =
-        "INSERT INTO users ('id', 'name', 'group', 'salt', 'verifier', 'sessions', 'flags') "
-        "VALUES (NULL, ?, ?, ?, ?, ?, ?)";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_ADD_USER);
+    if (!statement)
         return false;
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
@@ -445,7 +560,7 @@ bool DatabaseSqlite::addUser(const base::User& user)
         if (!writeInt(statement, static_cast<int>(user.flags), 6))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -457,7 +572,6 @@ bool DatabaseSqlite::addUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
@@ -469,18 +583,11 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
         return false;
     }
 
-    static const char kQuery[] =
-        "UPDATE users SET ('name', 'group', 'salt', 'verifier', 'sessions', 'flags') = "
-        "(?, ?, ?, ?, ?, ?) WHERE id=?";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_MODIFY_USER);
+    if (!statement)
         return false;
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
@@ -508,7 +615,7 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
         if (!writeInt64(statement, user.entry_id, 7))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -520,21 +627,16 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
 bool DatabaseSqlite::removeUser(int64_t entry_id)
 {
-    static const char kQuery[] = "DELETE FROM users WHERE id=?";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_REMOVE_USER);
+    if (!statement)
         return false;
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     bool result = false;
 
@@ -543,7 +645,7 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
         if (!writeInt64(statement, entry_id, 1))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -555,22 +657,16 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
 base::User DatabaseSqlite::findUser(std::u16string_view username)
 {
-    const char kQuery[] = "SELECT * FROM users WHERE name=?";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_FIND_USER);
+    if (!statement)
         return base::User::kInvalidUser;
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     std::string username_utf8 = base::utf8FromUtf16(username);
     std::optional<base::User> user;
@@ -587,7 +683,6 @@ base::User DatabaseSqlite::findUser(std::u16string_view username)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return user.value_or(base::User::kInvalidUser);
 }
 
@@ -606,18 +701,16 @@ Database::ErrorCode DatabaseSqlite::hostId(
         return ErrorCode::UNKNOWN;
     }
 
-    *host_id = base::kInvalidHostId;
+    if (host_index_)
+        return host_index_->hostId(key_hash, host_id);
 
-    const char kQuery[] = "SELECT * FROM hosts WHERE key=?";
+    *host_id = base::kInvalidHostId;
 
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_HOST_ID);
+    if (!statement)
         return ErrorCode::UNKNOWN;
-    }
+
+    ScopedStatementReset statement_reset(statement);
 
     ErrorCode result = ErrorCode::UNKNOWN;
 
@@ -626,7 +719,7 @@ Database::ErrorCode DatabaseSqlite::hostId(
         if (!writeBlob(statement, key_hash, 1))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_ROW)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -647,29 +740,35 @@ Database::ErrorCode DatabaseSqlite::hostId(
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
-bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
+void DatabaseSqlite::addHost(const base::ByteArray& key_hash, AddHostCallback callback)
 {
-    if (keyHash.empty())
+    if (key_hash.empty())
     {
         LOG(LS_ERROR) << "Invalid parameters";
-        return false;
+        callback(false);
+        return;
     }
 
-    const char kQuery[] = "INSERT INTO hosts ('id', 'key') VALUES (NULL, ?)";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
+    if (host_index_)
     {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code)
-                      << " (" << error_code << ")";
-        return false;
+        host_index_->addHost(key_hash, std::move(callback));
+        return;
     }
 
+    callback(insertHost(key_hash));
+}
+
+bool DatabaseSqlite::insertHost(const base::ByteArray& keyHash)
+{
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_ADD_HOST);
+    if (!statement)
+        return false;
+
+    ScopedStatementReset statement_reset(statement);
+
     bool result = false;
 
     do
@@ -677,7 +776,7 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
         if (!writeBlob(statement, keyHash, 1))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -689,10 +788,129 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
+bool DatabaseSqlite::hostList(std::vector<Host>* hosts) const
+{
+    DCHECK(hosts);
+
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_HOST_LIST);
+    if (!statement)
+        return false;
+
+    ScopedStatementReset statement_reset(statement);
+    hosts->clear();
+
+    for (;;)
+    {
+        int error_code = sqlite3_step(statement);
+        if (error_code == SQLITE_DONE)
+            break;
+
+        if (error_code != SQLITE_ROW)
+        {
+            LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
+                          << " (" << error_code << ")";
+            return false;
+        }
+
+        std::optional<int64_t> entry_id = readInteger<int64_t>(statement, 0);
+        if (!entry_id.has_value())
+        {
+            LOG(LS_ERROR) << "Failed to get field 'id'";
+            return false;
+        }
+
+        std::optional<base::ByteArray> key_hash = readBlob(statement, 1);
+        if (!key_hash.has_value())
+        {
+            LOG(LS_ERROR) << "Failed to get field 'key'";
+            return false;
+        }
+
+        Host host;
+        host.host_id = static_cast<base::HostId>(*entry_id);
+        host.key_hash = std::move(*key_hash);
+
+        hosts->emplace_back(std::move(host));
+    }
+
+    return true;
+}
+
+bool DatabaseSqlite::lastHostId(base::HostId* host_id) const
+{
+    DCHECK(host_id);
+
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_HOST_SEQUENCE);
+    if (!statement)
+        return false;
+
+    ScopedStatementReset statement_reset(statement);
+
+    int error_code = sqlite3_step(statement);
+    if (error_code == SQLITE_DONE)
+    {
+        // No host has been added yet.
+        *host_id = base::kInvalidHostId;
+        return true;
+    }
+
+    if (error_code != SQLITE_ROW)
+    {
+        LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
+                      << " (" << error_code << ")";
+        return false;
+    }
+
+    std::optional<int64_t> sequence = readInteger<int64_t>(statement, 0);
+    if (!sequence.has_value())
+    {
+        LOG(LS_ERROR) << "Failed to get field 'seq'";
+        return false;
+    }
+
+    *host_id = static_cast<base::HostId>(*sequence);
+    return true;
+}
+
+bool DatabaseSqlite::addHosts(const std::vector<Host>& hosts)
+{
+    if (hosts.empty())
+        return true;
+
+    sqlite3_stmt* statement = connection_->statement(Connection::STATEMENT_INSERT_HOST);
+    if (!statement)
+        return false;
+
+    if (!exec("BEGIN TRANSACTION"))
+        return false;
+
+    for (const auto& host : hosts)
+    {
+        ScopedStatementReset statement_reset(statement);
+
+        if (!writeInt64(statement, static_cast<int64_t>(host.host_id), 1) ||
+            !writeBlob(statement, host.key_hash, 2))
+        {
+            exec("ROLLBACK");
+            return false;
+        }
+
+        int error_code = sqlite3_step(statement);
+        if (error_code != SQLITE_DONE)
+        {
+            LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
+                          << " (" << error_code << ")";
+            exec("ROLLBACK");
+            return false;
+        }
+    }
+
+    return exec("COMMIT");
+}
+
 // static
 std::filesystem::path DatabaseSqlite::databaseDirectory()
 {
@@ -712,4 +930,21 @@ std::filesystem::path DatabaseSqlite::databaseDirectory()
     return dir_path;
 }
 
+bool DatabaseSqlite::exec(const char* sql)
+{
+    char* error_string = nullptr;
+
+    int error_code = sqlite3_exec(connection_->db(), sql, nullptr, nullptr, &error_string);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_exec failed: "
+                      << (error_string ? error_string : sqlite3_errstr(error_code))
+                      << " (" << error_code << ")";
+        sqlite3_free(error_string);
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace router
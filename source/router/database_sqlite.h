@@ -23,14 +23,77 @@
 #include "router/database.h"
 
 #include <filesystem>
+#include <memory>
 
 #include <sqlite3.h>
 
 namespace router {
 
+class HostKeyIndex;
+
 class DatabaseSqlite : public Database
 {
 public:
+    // Value of PRAGMA synchronous. The database uses WAL journal mode, in which NORMAL does not
+    // risk database corruption, but the last transactions may be lost after a power failure.
+    enum class Synchronous
+    {
+        OFF    = 0,
+        NORMAL = 1,
+        FULL   = 2,
+        EXTRA  = 3
+    };
+
+    // Database connection with the prepared statements. It can be shared by several database
+    // instances that are used from the same thread.
+    class Connection
+    {
+    public:
+        ~Connection();
+
+        static std::shared_ptr<Connection> open(Synchronous synchronous = Synchronous::NORMAL);
+
+        sqlite3* db() const { return db_; }
+
+    private:
+        friend class DatabaseSqlite;
+
+        enum StatementType
+        {
+            STATEMENT_USER_LIST,
+            STATEMENT_ADD_USER,
+            STATEMENT_MODIFY_USER,
+            STATEMENT_REMOVE_USER,
+            STATEMENT_FIND_USER,
+            STATEMENT_HOST_ID,
+            STATEMENT_ADD_HOST,
+            STATEMENT_HOST_LIST,
+            STATEMENT_INSERT_HOST,
+            STATEMENT_HOST_SEQUENCE,
+            STATEMENT_COUNT
+        };
+
+        explicit Connection(sqlite3* db);
+
+        // Returns the prepared statement of the specified type. The statement is prepared on the
+        // first call and is kept until the connection is closed.
+        sqlite3_stmt* statement(StatementType type);
+
+        sqlite3* db_;
+        sqlite3_stmt* statements_[STATEMENT_COUNT] = { nullptr };
+
+        DISALLOW_COPY_AND_ASSIGN(Connection);
+    };
+
+    struct Host
+    {
+        base::HostId host_id = base::kInvalidHostId;
+        base::ByteArray key_hash;
+    };
+
+    // If |host_index| is specified, hostId() and addHost() use it instead of the hosts table.
+    explicit DatabaseSqlite(std::shared_ptr<Connection> connection,
+                            std::shared_ptr<HostKeyIndex> host_index = nullptr);
     ~DatabaseSqlite() override;
 
     static std::unique_ptr<DatabaseSqlite> create();
@@ -44,13 +107,25 @@ public:
     bool removeUser(int64_t entry_id) override;
     base::User findUser(std::u16string_view username) override;
     ErrorCode hostId(const base::ByteArray& key_hash, base::HostId* host_id) const override;
-    bool addHost(const base::ByteArray& key_hash) override;
+    void addHost(const base::ByteArray& key_hash, AddHostCallback callback) override;
+
+    // Reads all entries of the hosts table.
+    bool hostList(std::vector<Host>* hosts) const;
+
+    // Reads the largest host ID ever assigned by the hosts table (including removed hosts).
+    // If no host has been added yet, |host_id| is set to kInvalidHostId.
+    bool lastHostId(base::HostId* host_id) const;
+
+    // Adds hosts with already assigned IDs in one transaction.
+    bool addHosts(const std::vector<Host>& hosts);
 
 private:
-    explicit DatabaseSqlite(sqlite3* db);
     static std::filesystem::path databaseDirectory();
+    bool insertHost(const base::ByteArray& key_hash);
+    bool exec(const char* sql);
 
-    sqlite3* db_;
+    std::shared_ptr<Connection> connection_;
+    std::shared_ptr<HostKeyIndex> host_index_;
 
     DISALLOW_COPY_AND_ASSIGN(DatabaseSqlite);
 };
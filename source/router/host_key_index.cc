@@ -0,0 +1,298 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/host_key_index.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+
+namespace router {
+
+namespace {
+
+// Delay between adding a host and writing it to the database. Hosts added during this time are
+// written in one transaction.
+constexpr std::chrono::milliseconds kWriteDelay { 500 };
+
+// Delay before retrying hosts that could not be written.
+constexpr std::chrono::seconds kRetryDelay { 5 };
+
+// Number of attempts to write a host after which the host is dropped.
+const int kMaxWriteAttempts = 3;
+
+std::string indexKey(const base::ByteArray& key_hash)
+{
+    return std::string(key_hash.begin(), key_hash.end());
+}
+
+} // namespace
+
+HostKeyIndex::HostKeyIndex(std::unique_ptr<DatabaseSqlite> writer,
+                           std::shared_ptr<base::TaskRunner> owner_task_runner)
+    : owner_task_runner_(std::move(owner_task_runner)),
+      writer_(std::move(writer))
+{
+    DCHECK(owner_task_runner_);
+    DCHECK(writer_);
+
+    writer_thread_.start(base::MessageLoop::Type::DEFAULT);
+}
+
+HostKeyIndex::~HostKeyIndex()
+{
+    writer_thread_.stop();
+
+    // The thread is stopped, remaining hosts are written on the current thread. Callbacks are
+    // not called because the owner is being destroyed.
+    std::scoped_lock lock(pending_lock_);
+    if (pending_hosts_.empty())
+        return;
+
+    std::vector<WriteResult> results;
+    writeHosts(&pending_hosts_, &results);
+
+    if (!pending_hosts_.empty())
+        LOG(LS_ERROR) << "Unable to write " << pending_hosts_.size() << " hosts";
+}
+
+// static
+std::shared_ptr<HostKeyIndex> HostKeyIndex::create(const DatabaseSqlite& database,
+                                                   DatabaseSqlite::Synchronous synchronous)
+{
+    base::MessageLoop* message_loop = base::MessageLoop::current();
+    if (!message_loop)
+    {
+        LOG(LS_ERROR) << "Host index requires a message loop";
+        return nullptr;
+    }
+
+    std::vector<DatabaseSqlite::Host> hosts;
+    if (!database.hostList(&hosts))
+    {
+        LOG(LS_ERROR) << "Unable to read host list";
+        return nullptr;
+    }
+
+    // IDs of removed hosts must not be assigned again, so the sequence of the AUTOINCREMENT
+    // column is taken into account along with existing hosts.
+    base::HostId last_host_id = base::kInvalidHostId;
+    if (!database.lastHostId(&last_host_id))
+    {
+        LOG(LS_ERROR) << "Unable to read last host id";
+        return nullptr;
+    }
+
+    std::shared_ptr<DatabaseSqlite::Connection> connection =
+        DatabaseSqlite::Connection::open(synchronous);
+    if (!connection)
+    {
+        LOG(LS_ERROR) << "Unable to open database connection for writing";
+        return nullptr;
+    }
+
+    std::shared_ptr<HostKeyIndex> index(
+        new HostKeyIndex(std::make_unique<DatabaseSqlite>(std::move(connection)),
+                         message_loop->taskRunner()));
+
+    index->hosts_.reserve(hosts.size());
+
+    for (const auto& host : hosts)
+    {
+        index->hosts_.emplace(indexKey(host.key_hash), host.host_id);
+        last_host_id = std::max(last_host_id, host.host_id);
+    }
+
+    index->next_host_id_ = last_host_id + 1;
+
+    LOG(LS_INFO) << "Host index loaded (hosts: " << index->hosts_.size()
+                 << " next id: " << index->next_host_id_ << ")";
+    return index;
+}
+
+Database::ErrorCode HostKeyIndex::hostId(
+    const base::ByteArray& key_hash, base::HostId* host_id) const
+{
+    DCHECK(owner_task_runner_->belongsToCurrentThread());
+    DCHECK(host_id);
+
+    auto result = hosts_.find(indexKey(key_hash));
+    if (result == hosts_.end())
+    {
+        *host_id = base::kInvalidHostId;
+        return Database::ErrorCode::NO_HOST_FOUND;
+    }
+
+    *host_id = result->second;
+    return Database::ErrorCode::SUCCESS;
+}
+
+void HostKeyIndex::addHost(const base::ByteArray& key_hash, Database::AddHostCallback callback)
+{
+    DCHECK(owner_task_runner_->belongsToCurrentThread());
+
+    std::string key = indexKey(key_hash);
+    if (hosts_.find(key) != hosts_.end())
+    {
+        LOG(LS_ERROR) << "Host with the same key already exists";
+        callback(false);
+        return;
+    }
+
+    // The ID is returned to the caller only after the host is written, so an ID assigned before
+    // a crash is never returned again. Duplicate keys among hosts being added are rejected by the
+    // database.
+    base::HostId host_id = next_host_id_++;
+    adding_hosts_.emplace(host_id, AddingHost{ std::move(key), std::move(callback) });
+
+    bool schedule_write;
+
+    {
+        std::scoped_lock lock(pending_lock_);
+
+        PendingHost pending_host;
+        pending_host.host.host_id = host_id;
+        pending_host.host.key_hash = key_hash;
+
+        pending_hosts_.emplace_back(std::move(pending_host));
+
+        schedule_write = !write_scheduled_;
+        write_scheduled_ = true;
+    }
+
+    if (schedule_write)
+    {
+        writer_thread_.taskRunner()->postDelayedTask(
+            std::bind(&HostKeyIndex::writePendingHosts, this), kWriteDelay);
+    }
+}
+
+void HostKeyIndex::writePendingHosts()
+{
+    std::vector<PendingHost> hosts;
+
+    {
+        std::scoped_lock lock(pending_lock_);
+        hosts.swap(pending_hosts_);
+    }
+
+    std::vector<WriteResult> results;
+    writeHosts(&hosts, &results);
+
+    std::chrono::milliseconds delay = kWriteDelay;
+    bool schedule_write;
+
+    {
+        std::scoped_lock lock(pending_lock_);
+
+        if (!hosts.empty())
+        {
+            // Hosts that could not be written are retried later.
+            pending_hosts_.insert(pending_hosts_.begin(),
+                                  std::make_move_iterator(hosts.begin()),
+                                  std::make_move_iterator(hosts.end()));
+            delay = kRetryDelay;
+        }
+
+        schedule_write = !pending_hosts_.empty();
+        write_scheduled_ = schedule_write;
+    }
+
+    if (!results.empty())
+    {
+        owner_task_runner_->postTask(
+            [index = weak_from_this(), results = std::move(results)]()
+        {
+            std::shared_ptr<HostKeyIndex> self = index.lock();
+            if (self)
+                self->onHostsWritten(results);
+        });
+    }
+
+    if (schedule_write)
+    {
+        writer_thread_.taskRunner()->postDelayedTask(
+            std::bind(&HostKeyIndex::writePendingHosts, this), delay);
+    }
+}
+
+void HostKeyIndex::writeHosts(std::vector<PendingHost>* hosts, std::vector<WriteResult>* results)
+{
+    std::vector<DatabaseSqlite::Host> batch;
+    batch.reserve(hosts->size());
+
+    for (const auto& pending_host : *hosts)
+        batch.emplace_back(pending_host.host);
+
+    if (writer_->addHosts(batch))
+    {
+        for (const auto& host : batch)
+            results->emplace_back(host.host_id, true);
+
+        hosts->clear();
+        return;
+    }
+
+    // One failing host must not block the rest of the batch.
+    LOG(LS_WARNING) << "Unable to write " << hosts->size() << " hosts in one transaction. "
+                    << "Hosts will be written one by one";
+
+    std::vector<PendingHost> failed_hosts;
+
+    for (auto& pending_host : *hosts)
+    {
+        if (writer_->addHosts({ pending_host.host }))
+        {
+            results->emplace_back(pending_host.host.host_id, true);
+            continue;
+        }
+
+        if (++pending_host.attempts < kMaxWriteAttempts)
+        {
+            failed_hosts.emplace_back(std::move(pending_host));
+            continue;
+        }
+
+        LOG(LS_ERROR) << "Unable to write host " << pending_host.host.host_id
+                      << " (attempts: " << pending_host.attempts << "). Host dropped";
+        results->emplace_back(pending_host.host.host_id, false);
+    }
+
+    hosts->swap(failed_hosts);
+}
+
+void HostKeyIndex::onHostsWritten(const std::vector<WriteResult>& results)
+{
+    DCHECK(owner_task_runner_->belongsToCurrentThread());
+
+    for (const auto& [host_id, result] : results)
+    {
+        auto it = adding_hosts_.find(host_id);
+        if (it == adding_hosts_.end())
+            continue;
+
+        AddingHost adding_host = std::move(it->second);
+        adding_hosts_.erase(it);
+
+        if (result)
+            hosts_.emplace(std::move(adding_host.key), host_id);
+
+        adding_host.callback(result);
+    }
+}
+
+} // namespace router
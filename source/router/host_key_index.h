@@ -0,0 +1,93 @@
+//
+// Aspia Project
+// Copyright (C) 2016-2023 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER_HOST_KEY_INDEX_H
+#define ROUTER_HOST_KEY_INDEX_H
+
+#include "base/threading/thread.h"
+#include "router/database_sqlite.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace router {
+
+// In-memory index of host key hashes. All hosts are loaded from the database at startup, so the
+// host ID is resolved without a database query. New hosts are written to the database in batches
+// on a separate thread with its own connection. A new host becomes visible in the index (and its
+// callback is called) only after it has been written.
+// All methods except the destructor must be called from the thread on which the index was created.
+class HostKeyIndex : public std::enable_shared_from_this<HostKeyIndex>
+{
+public:
+    ~HostKeyIndex();
+
+    static std::shared_ptr<HostKeyIndex> create(const DatabaseSqlite& database,
+                                                DatabaseSqlite::Synchronous synchronous);
+
+    Database::ErrorCode hostId(const base::ByteArray& key_hash, base::HostId* host_id) const;
+    void addHost(const base::ByteArray& key_hash, Database::AddHostCallback callback);
+
+private:
+    struct PendingHost
+    {
+        DatabaseSqlite::Host host;
+        int attempts = 0;
+    };
+
+    using WriteResult = std::pair<base::HostId, bool>;
+
+    HostKeyIndex(std::unique_ptr<DatabaseSqlite> writer,
+                 std::shared_ptr<base::TaskRunner> owner_task_runner);
+
+    // Writes pending hosts to the database. Called on the writer thread.
+    void writePendingHosts();
+
+    // Writes |hosts| in one transaction. If the transaction fails, the hosts are written one by
+    // one. Hosts that could not be written are left in |hosts|.
+    void writeHosts(std::vector<PendingHost>* hosts, std::vector<WriteResult>* results);
+
+    // Called on the owner thread when the hosts have been written (or dropped).
+    void onHostsWritten(const std::vector<WriteResult>& results);
+
+    std::shared_ptr<base::TaskRunner> owner_task_runner_;
+
+    struct AddingHost
+    {
+        std::string key;
+        Database::AddHostCallback callback;
+    };
+
+    // Members used only on the owner thread.
+    std::unordered_map<std::string, base::HostId> hosts_;
+    std::unordered_map<base::HostId, AddingHost> adding_hosts_;
+    base::HostId next_host_id_ = 1;
+
+    std::unique_ptr<DatabaseSqlite> writer_;
+    base::Thread writer_thread_;
+
+    std::mutex pending_lock_;
+    std::vector<PendingHost> pending_hosts_;
+    bool write_scheduled_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(HostKeyIndex);
+};
+
+} // namespace router
+
+#endif // ROUTER_HOST_KEY_INDEX_H
@@ -24,6 +24,7 @@
 #include "base/peer/user.h"
 #include "build/version.h"
 #include "router/database_factory_sqlite.h"
+#include "router/database_sqlite.h"
 #include "router/database.h"
 #include "router/settings.h"
 
@@ -141,7 +142,8 @@ void createConfig()
     std::unique_ptr<router::Database> db = router::DatabaseFactorySqlite().createDatabase();
     if (!db)
     {
-        db = router::DatabaseFactorySqlite().openDatabase();
+        // Only the existence of the database is checked, so the host index is not needed.
+        db = router::DatabaseSqlite::open();
         if (db)
         {
             std::cout << "Database already exists. Continuation is impossible." << std::endl;
@@ -34,6 +34,8 @@
 #include "router/settings.h"
 #include "router/user_list_db.h"
 
+#include <algorithm>
+
 namespace router {
 
 namespace {
@@ -62,8 +64,7 @@ const char* sessionTypeToString(proto::RouterSession session_type)
 } // namespace
 
 Server::Server(std::shared_ptr<base::TaskRunner> task_runner)
-    : task_runner_(std::move(task_runner)),
-      database_factory_(base::make_local_shared<DatabaseFactorySqlite>())
+    : task_runner_(std::move(task_runner))
 {
     LOG(LS_INFO) << "Ctor";
     DCHECK(task_runner_);
@@ -82,6 +83,15 @@ bool Server::start()
         return false;
     }
 
+    Settings settings;
+
+    uint32_t database_synchronous = std::min(
+        settings.databaseSynchronous(), static_cast<uint32_t>(DatabaseSqlite::Synchronous::EXTRA));
+    LOG(LS_INFO) << "Database synchronous: " << database_synchronous;
+
+    database_factory_ = base::make_local_shared<DatabaseFactorySqlite>(
+        static_cast<DatabaseSqlite::Synchronous>(database_synchronous));
+
     std::unique_ptr<Database> database = database_factory_->openDatabase();
     if (!database)
     {
@@ -89,8 +99,6 @@ bool Server::start()
         return false;
     }
 
-    Settings settings;
-
     base::ByteArray private_key = settings.privateKey();
     if (private_key.empty())
     {
@@ -174,6 +182,14 @@ bool Server::start()
         base::ServerAuthenticator::AnonymousAccess::ENABLE,
         proto::ROUTER_SESSION_HOST | proto::ROUTER_SESSION_RELAY);
 
+    // SRP calculations with 8192-bit groups are expensive. We perform them on a separate pool so
+    // that mass reconnection of hosts does not block the established sessions.
+    uint32_t max_concurrent_handshakes = settings.maxConcurrentHandshakes();
+    LOG(LS_INFO) << "Max concurrent handshakes: " << max_concurrent_handshakes;
+
+    authenticator_manager_->setCryptoThreads(settings.cryptoThreads());
+    authenticator_manager_->setMaxConcurrentHandshakes(max_concurrent_handshakes);
+
     relay_key_pool_ = std::make_unique<SharedKeyPool>(this);
 
     server_ = std::make_unique<base::TcpServer>();
@@ -187,7 +203,20 @@ std::unique_ptr<proto::SessionList> Server::sessionList() const
 {
     std::unique_ptr<proto::SessionList> result = std::make_unique<proto::SessionList>();
 
+    // Sessions are listed in the order of their creation.
+    std::vector<const Session*> sorted_sessions;
+    sorted_sessions.reserve(sessions_.size());
+
     for (const auto& session : sessions_)
+        sorted_sessions.emplace_back(session.second.get());
+
+    std::sort(sorted_sessions.begin(), sorted_sessions.end(),
+              [](const Session* first, const Session* second)
+    {
+        return first->sessionId() < second->sessionId();
+    });
+
+    for (const Session* session : sorted_sessions)
     {
         proto::Session* item = result->add_session();
 
@@ -205,7 +234,7 @@ std::unique_ptr<proto::SessionList> Server::sessionList() const
             {
                 proto::HostSessionData session_data;
 
-                for (const auto& host_id : static_cast<SessionHost*>(session.get())->hostIdList())
+                for (const auto& host_id : static_cast<const SessionHost*>(session)->hostIdList())
                     session_data.add_host_id(host_id);
 
                 item->set_session_data(session_data.SerializeAsString());
@@ -218,7 +247,7 @@ std::unique_ptr<proto::SessionList> Server::sessionList() const
                 session_data.set_pool_size(relay_key_pool_->countForRelay(session->sessionId()));
 
                 const std::optional<proto::RelayStat>& in_relay_stat =
-                    static_cast<SessionRelay*>(session.get())->relayStat();
+                    static_cast<const SessionRelay*>(session)->relayStat();
                 if (in_relay_stat.has_value())
                 {
                     proto::RelaySessionData::RelayStat* out_relay_stat =
@@ -238,75 +267,65 @@ std::unique_ptr<proto::SessionList> Server::sessionList() const
         }
     }
 
+    if (authenticator_manager_)
+    {
+        result->set_pending_handshakes(
+            static_cast<uint32_t>(authenticator_manager_->pendingCount()));
+        result->set_waiting_handshakes(
+            static_cast<uint32_t>(authenticator_manager_->waitingCount()));
+        result->set_crypto_queue_depth(
+            static_cast<uint32_t>(authenticator_manager_->cryptoQueueDepth()));
+    }
+
     result->set_error_code(proto::SessionList::SUCCESS);
     return result;
 }
 
 bool Server::stopSession(Session::SessionId session_id)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
-    {
-        if (it->get()->sessionId() == session_id)
-        {
-            sessions_.erase(it);
-            return true;
-        }
-    }
-
-    return false;
+    return takeSession(session_id) != nullptr;
 }
 
 void Server::onHostSessionWithId(SessionHost* session)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end();)
+    for (const auto& host_id : session->hostIdList())
     {
-        if (it->get()->sessionType() == proto::ROUTER_SESSION_HOST)
+        auto it = host_sessions_.find(host_id);
+        if (it != host_sessions_.end() && it->second != session)
         {
-            SessionHost* other_session = reinterpret_cast<SessionHost*>(it->get());
-            if (other_session != session)
-            {
-                for (const auto& host_id : session->hostIdList())
-                {
-                    if (other_session->hasHostId(host_id))
-                    {
-                        LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
+            LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
 
-                        it = sessions_.erase(it);
-                        continue;
-                    }
-                }
-            }
+            // The previous session removes all its host IDs from the index.
+            takeSession(it->second->sessionId());
         }
 
-        ++it;
+        host_sessions_[host_id] = session;
     }
 }
 
-SessionHost* Server::hostSessionById(base::HostId host_id)
+void Server::onHostIdRemoved(SessionHost* session, base::HostId host_id)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
-    {
-        Session* entry = it->get();
+    auto it = host_sessions_.find(host_id);
+    if (it != host_sessions_.end() && it->second == session)
+        host_sessions_.erase(it);
+}
 
-        if (entry->sessionType() == proto::ROUTER_SESSION_HOST &&
-            static_cast<SessionHost*>(entry)->hasHostId(host_id))
-        {
-            return static_cast<SessionHost*>(entry);
-        }
-    }
+SessionHost* Server::hostSessionById(base::HostId host_id)
+{
+    auto it = host_sessions_.find(host_id);
+    if (it == host_sessions_.end())
+        return nullptr;
 
-    return nullptr;
+    return it->second;
 }
 
 Session* Server::sessionById(Session::SessionId session_id)
 {
-    for (auto& session : sessions_)
-    {
-        if (session->sessionId() == session_id)
-            return session.get();
-    }
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end())
+        return nullptr;
 
-    return nullptr;
+    return it->second.get();
 }
 
 void Server::onNewConnection(std::unique_ptr<base::TcpChannel> channel)
@@ -322,12 +341,9 @@ void Server::onNewConnection(std::unique_ptr<base::TcpChannel> channel)
 
 void Server::onPoolKeyUsed(Session::SessionId session_id, uint32_t key_id)
 {
-    for (const auto& session : sessions_)
-    {
-        SessionRelay* relay_session = static_cast<SessionRelay*>(session.get());
-        if (relay_session->sessionId() == session_id)
-            relay_session->sendKeyUsed(key_id);
-    }
+    Session* session = sessionById(session_id);
+    if (session && session->sessionType() == proto::ROUTER_SESSION_RELAY)
+        static_cast<SessionRelay*>(session)->sendKeyUsed(key_id);
 }
 
 void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& session_info)
@@ -407,24 +423,38 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
     session->setComputerName(session_info.computer_name);
     session->setUserName(session_info.user_name);
 
-    sessions_.emplace_back(std::move(session));
-    sessions_.back()->start(this);
+    Session* session_ptr = session.get();
+
+    sessions_.emplace(session_ptr->sessionId(), std::move(session));
+    session_ptr->start(this);
 }
 
 void Server::onSessionFinished(Session::SessionId session_id, proto::RouterSession /* session_type */)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    // Session will be destroyed after completion of the current call.
+    std::unique_ptr<Session> session = takeSession(session_id);
+    if (session)
+        task_runner_->deleteSoon(std::move(session));
+}
+
+std::unique_ptr<Session> Server::takeSession(Session::SessionId session_id)
+{
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end())
+        return nullptr;
+
+    std::unique_ptr<Session> session = std::move(it->second);
+    sessions_.erase(it);
+
+    if (session->sessionType() == proto::ROUTER_SESSION_HOST)
     {
-        if (it->get()->sessionId() == session_id)
-        {
-            // Session will be destroyed after completion of the current call.
-            task_runner_->deleteSoon(std::move(*it));
+        SessionHost* host_session = static_cast<SessionHost*>(session.get());
 
-            // Delete a session from the list.
-            sessions_.erase(it);
-            break;
-        }
+        for (const auto& host_id : host_session->hostIdList())
+            onHostIdRemoved(host_session, host_id);
     }
+
+    return session;
 }
 
 } // namespace router
@@ -27,6 +27,8 @@
 #include "router/session.h"
 #include "router/shared_key_pool.h"
 
+#include <unordered_map>
+
 namespace router {
 
 class DatabaseFactory;
@@ -48,6 +50,7 @@ public:
     std::unique_ptr<proto::SessionList> sessionList() const;
     bool stopSession(Session::SessionId session_id);
     void onHostSessionWithId(SessionHost* session);
+    void onHostIdRemoved(SessionHost* session, base::HostId host_id);
 
     SessionHost* hostSessionById(base::HostId host_id);
     Session* sessionById(Session::SessionId session_id);
@@ -67,12 +70,18 @@ protected:
                            proto::RouterSession session_type) override;
 
 private:
+    std::unique_ptr<Session> takeSession(Session::SessionId session_id);
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     base::local_shared_ptr<DatabaseFactory> database_factory_;
     std::unique_ptr<base::TcpServer> server_;
     std::unique_ptr<base::ServerAuthenticatorManager> authenticator_manager_;
     std::unique_ptr<SharedKeyPool> relay_key_pool_;
-    std::vector<std::unique_ptr<Session>> sessions_;
+    std::unordered_map<Session::SessionId, std::unique_ptr<Session>> sessions_;
+
+    // Index of host sessions by host IDs. Maintained when host IDs are assigned to a session or
+    // removed from it and when the session is removed.
+    std::unordered_map<base::HostId, SessionHost*> host_sessions_;
 
     std::vector<std::u16string> client_white_list_;
     std::vector<std::u16string> host_white_list_;
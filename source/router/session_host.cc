@@ -95,41 +95,71 @@ void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
         return;
     }
 
-    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
-    proto::HostIdResponse* host_id_response = message->mutable_host_id_response();
-    base::ByteArray key_hash;
-
     if (host_id_request.type() == proto::HostIdRequest::NEW_ID)
     {
         // Generate new key.
         std::string key = base::Random::string(kHostKeySize);
 
         // Calculate hash for key.
-        key_hash = base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key);
+        base::ByteArray key_hash =
+            base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key);
 
-        if (!database->addHost(key_hash))
+        // The session can be destroyed before the host is saved, so it is searched by ID.
+        Server* server = &this->server();
+        SessionId session_id = sessionId();
+
+        database->addHost(key_hash, [server, session_id, key = std::move(key), key_hash](
+            bool result) mutable
         {
-            LOG(LS_ERROR) << "Unable to add host";
-            return;
-        }
+            Session* session = server->sessionById(session_id);
+            if (!session)
+                return;
 
-        host_id_response->set_key(std::move(key));
+            DCHECK_EQ(session->sessionType(), proto::ROUTER_SESSION_HOST);
+            SessionHost* self = static_cast<SessionHost*>(session);
+
+            if (!result)
+            {
+                LOG(LS_ERROR) << "Unable to add host";
+                return;
+            }
+
+            std::unique_ptr<Database> database = self->openDatabase();
+            if (!database)
+            {
+                LOG(LS_ERROR) << "Failed to connect to database";
+                return;
+            }
+
+            self->sendHostIdResponse(*database, key_hash, std::move(key));
+        });
     }
     else if (host_id_request.type() == proto::HostIdRequest::EXISTING_ID)
     {
         // Using existing key.
-        key_hash = base::GenericHash::hash(
+        base::ByteArray key_hash = base::GenericHash::hash(
             base::GenericHash::Type::BLAKE2b512, host_id_request.key());
+
+        sendHostIdResponse(*database, key_hash, std::string());
     }
     else
     {
         LOG(LS_ERROR) << "Unknown request type: " << host_id_request.type();
-        return;
     }
+}
+
+void SessionHost::sendHostIdResponse(
+    const Database& database, const base::ByteArray& key_hash, std::string&& key)
+{
+    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
+    proto::HostIdResponse* host_id_response = message->mutable_host_id_response();
+
+    if (!key.empty())
+        host_id_response->set_key(std::move(key));
 
     base::HostId host_id = base::kInvalidHostId;
 
-    switch (database->hostId(key_hash, &host_id))
+    switch (database.hostId(key_hash, &host_id))
     {
         case Database::ErrorCode::SUCCESS:
         {
@@ -187,6 +217,7 @@ void SessionHost::readResetHostId(const proto::ResetHostId& reset_host_id)
         {
             LOG(LS_INFO) << "Host ID " << host_id << " remove from list";
             host_id_list_.erase(it);
+            server().onHostIdRemoved(this, host_id);
             return;
         }
     }
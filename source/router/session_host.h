@@ -25,6 +25,7 @@
 
 namespace router {
 
+class Database;
 class ServerProxy;
 
 class SessionHost : public Session
@@ -49,6 +50,8 @@ protected:
 private:
     void readHostIdRequest(const proto::HostIdRequest& host_id_request);
     void readResetHostId(const proto::ResetHostId& reset_host_id);
+    void sendHostIdResponse(
+        const Database& database, const base::ByteArray& key_hash, std::string&& key);
 
     HostIdList host_id_list_;
 
@@ -30,6 +30,8 @@ namespace {
 const base::JsonSettings::Scope kScope = base::JsonSettings::Scope::SYSTEM;
 const char kApplicationName[] = "aspia";
 const char kFileName[] = "router";
+const uint32_t kDefaultMaxConcurrentHandshakes = 256;
+const uint32_t kDefaultDatabaseSynchronous = 1; // NORMAL
 
 } // namespace
 
@@ -55,6 +57,9 @@ void Settings::reset()
     setHostWhiteList(WhiteList());
     setAdminWhiteList(WhiteList());
     setRelayWhiteList(WhiteList());
+    setCryptoThreads(0);
+    setMaxConcurrentHandshakes(kDefaultMaxConcurrentHandshakes);
+    setDatabaseSynchronous(kDefaultDatabaseSynchronous);
 }
 
 void Settings::flush()
@@ -136,6 +141,36 @@ Settings::WhiteList Settings::relayWhiteList() const
     return whiteList("RelayWhiteList");
 }
 
+void Settings::setCryptoThreads(uint32_t count)
+{
+    impl_.set<uint32_t>("CryptoThreads", count);
+}
+
+uint32_t Settings::cryptoThreads() const
+{
+    return impl_.get<uint32_t>("CryptoThreads", 0);
+}
+
+void Settings::setMaxConcurrentHandshakes(uint32_t count)
+{
+    impl_.set<uint32_t>("MaxConcurrentHandshakes", count);
+}
+
+uint32_t Settings::maxConcurrentHandshakes() const
+{
+    return impl_.get<uint32_t>("MaxConcurrentHandshakes", kDefaultMaxConcurrentHandshakes);
+}
+
+void Settings::setDatabaseSynchronous(uint32_t level)
+{
+    impl_.set<uint32_t>("DatabaseSynchronous", level);
+}
+
+uint32_t Settings::databaseSynchronous() const
+{
+    return impl_.get<uint32_t>("DatabaseSynchronous", kDefaultDatabaseSynchronous);
+}
+
 void Settings::setWhiteList(std::string_view key, const WhiteList& value)
 {
     std::u16string result;
@@ -57,6 +57,20 @@ public:
     void setRelayWhiteList(const WhiteList& list);
     WhiteList relayWhiteList() const;
 
+    // Number of threads for cryptographic calculations during authentication. If 0, the number
+    // of threads is equal to the number of processor threads.
+    void setCryptoThreads(uint32_t count);
+    uint32_t cryptoThreads() const;
+
+    // Maximum number of simultaneous authentications. Connections above the limit are waiting in
+    // the queue. If 0, the number is unlimited.
+    void setMaxConcurrentHandshakes(uint32_t count);
+    uint32_t maxConcurrentHandshakes() const;
+
+    // Value of PRAGMA synchronous for the database: 0 (OFF), 1 (NORMAL), 2 (FULL) or 3 (EXTRA).
+    void setDatabaseSynchronous(uint32_t level);
+    uint32_t databaseSynchronous() const;
+
 private:
     void setWhiteList(std::string_view key, const WhiteList& value);
     WhiteList whiteList(std::string_view key) const;